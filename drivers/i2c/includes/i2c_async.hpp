@@ -0,0 +1,160 @@
+#pragma once
+
+#include <coroutine>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "i2c_device.hpp"
+#include "queue.hpp"
+
+// Coroutine frames come from a static pool of I2C_TASK_POOL_SIZE blocks of
+// I2C_TASK_FRAME_SIZE bytes. Override them with compile definitions if needed.
+#ifndef I2C_TASK_POOL_SIZE
+#define I2C_TASK_POOL_SIZE 8
+#endif
+#ifndef I2C_TASK_FRAME_SIZE
+#define I2C_TASK_FRAME_SIZE 512
+#endif
+
+static_assert(I2C_TASK_POOL_SIZE <= 32, "The frame pool keeps its free blocks in a 32 bit mask.");
+
+class I2cTask;
+
+/*
+ *  @brief Cooperative executor for I2cTask coroutines. The I2C completion callbacks (ISR)
+ *  only post the waiting coroutine here; it's resumed from poll(), in thread context.
+ */
+class I2cExecutor
+{
+    public:
+        /*
+         *  @brief Takes the task over and starts it on the next poll(). Its frame is
+         *  released when it finishes.
+         *
+         *  @return false if the task is invalid (no frame could be allocated).
+         */
+        bool spawn(I2cTask&& task);
+
+        /*
+         *  @brief Resumes every coroutine ready to run. Call it from the main loop.
+         */
+        void poll();
+
+        // ISR safe.
+        void post(std::coroutine_handle<> handle);
+
+    protected:
+        // Every coroutine waits on one thing at a time, so there can't be more ready
+        // coroutines than frames.
+        StaticQueue<std::coroutine_handle<>, I2C_TASK_POOL_SIZE> ready;
+};
+
+/*
+ *  @brief Coroutine returning nothing, to write drivers as a sequence of transfers:
+ *
+ *      I2cTask readSensor(I2cDevice& sensor, uint8_t* out)
+ *      {
+ *          uint8_t start = 0x01;
+ *          if(!co_await sensor.write(0x10, &start, 1))
+ *              co_return;
+ *          co_await sensor.read(0x20, out, 6);
+ *      }
+ *
+ *      executor.spawn(readSensor(sensor, buffer));
+ *
+ *  A task starts suspended: spawn it on an I2cExecutor, or co_await it from another task
+ *  (it runs on the same executor and resumes the caller when it finishes). Results are
+ *  returned through parameters. Never heap allocated: if the frame pool is exhausted, or
+ *  the frame is bigger than I2C_TASK_FRAME_SIZE, the task is invalid and never runs.
+ */
+class I2cTask
+{
+    public:
+        struct promise_type;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+            void await_resume() noexcept {}
+        };
+
+        struct promise_type
+        {
+            I2cExecutor* executor = nullptr;
+            std::coroutine_handle<> continuation;
+            bool detached = false;
+
+            static void* operator new(size_t size) noexcept;
+            static void operator delete(void* frame) noexcept;
+            static I2cTask get_return_object_on_allocation_failure() { return I2cTask(nullptr); }
+
+            I2cTask get_return_object() { return I2cTask(Handle::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            FinalAwaiter final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception();
+        };
+
+        struct Awaiter
+        {
+            Handle child;
+
+            bool await_ready() noexcept { return !child || child.done(); }
+            std::coroutine_handle<> await_suspend(Handle parent) noexcept;
+            void await_resume() noexcept {}
+        };
+
+        I2cTask(I2cTask&& other) noexcept;
+        I2cTask(const I2cTask&) = delete;
+        I2cTask& operator=(const I2cTask&) = delete;
+        ~I2cTask();
+
+        bool isValid() const;
+
+        bool isDone() const;
+
+        Awaiter operator co_await() && noexcept;
+
+    private:
+        Handle handle;
+
+        explicit I2cTask(Handle handle) : handle(handle) {}
+
+    friend class I2cExecutor;
+};
+
+/*
+ *  @brief A transaction awaited from an I2cTask. co_await returns true once it has
+ *  FINISHED, false on ERROR or if it couldn't be queued. Returned by the I2cDevice
+ *  read()/write() helpers, or built from any transaction builder (priority, deadline...).
+ *
+ *  Lives in the coroutine frame while the transfer runs. If the task is destroyed
+ *  meanwhile, the transaction is cancelled. A transaction cancelled from elsewhere
+ *  (I2cBus::cancel()) never resumes the task.
+ */
+class I2cAwaitable
+{
+    public:
+        I2cAwaitable(I2cDevice& device, I2cTransaction::Builder& builder);
+        I2cAwaitable(const I2cAwaitable&) = delete;
+        I2cAwaitable& operator=(const I2cAwaitable&) = delete;
+        ~I2cAwaitable();
+
+        bool await_ready() noexcept { return false; }
+        bool await_suspend(I2cTask::Handle handle);
+        bool await_resume() noexcept { return succeeded; }
+
+    protected:
+        I2cDevice& device;
+        I2cTransaction transaction;
+
+        I2cExecutor* executor = nullptr;
+        std::coroutine_handle<> handle;
+        volatile bool pending = false;
+        bool succeeded = false;
+
+        static void onFinished(void* parameters);
+        static void onFailed(void* parameters);
+};
\ No newline at end of file
@@ -4,14 +4,20 @@
 #include <array>
 #include "stm32f4xx.h"
 
+#include "driver_result.hpp"
 #include "i2c_driver_exceptions.hpp"
 #include "i2c_transaction.hpp"
 #include "i2c_slave.hpp"
 
 #include "timer.hpp"
+#include "timer_wheel.hpp"
 #include "queue.hpp"
 #include "set.hpp"
 
+#ifdef ISR_PROFILING
+#include "isr_profiler.hpp"
+#endif
+
 #define I2C_BUS_MAX 3
 
 #ifdef __cplusplus
@@ -23,6 +29,9 @@ void I2C2_ER_IRQHandler();
 void I2C2_EV_IRQHandler();
 void I2C3_ER_IRQHandler();
 void I2C3_EV_IRQHandler();
+void DMA1_Stream0_IRQHandler();
+void DMA1_Stream2_IRQHandler();
+void DMA1_Stream3_IRQHandler();
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +45,55 @@ class I2cBus
 
         struct Config;
 
+        /*
+         *  @brief Health counters of a bus since init (or the last resetStatistics()).
+         *  Queue times are in the units of Config::timestampSource and only counted when
+         *  one is configured.
+         */
+        struct Statistics
+        {
+            uint32_t transactionsCompleted = 0;
+            uint32_t transactionsFailed = 0;
+            uint32_t bytesTx = 0;
+            uint32_t bytesRx = 0;
+
+            uint32_t acknowledgeFailures = 0;   // AF
+            uint32_t arbitrationLosses = 0;     // ARLO
+            uint32_t busErrors = 0;             // BERR
+            uint32_t overruns = 0;              // OVR
+            uint32_t busResets = 0;
+            uint32_t busyRetries = 0;           // Retry timer expirations
+            uint32_t retryGiveUps = 0;          // Transactions failed after RetryPolicy::maxAttempts
+            uint32_t arbitrationRetries = 0;    // Transactions retried after an ARLO
+
+            uint16_t maxQueueDepth = 0;
+            uint32_t maxQueueTime = 0;
+            uint64_t totalQueueTime = 0;
+            uint32_t queueTimeSamples = 0;
+        };
+
+        /*
+         *  @brief How long to wait before checking again when the bus is BUSY (another
+         *  master is using it). Every retry of the same transaction waits multiplierPercent
+         *  longer than the previous one, up to maxDelayUs, and a random part of up to
+         *  jitterPercent of each delay is cut off so several masters don't retry in sync.
+         *  Delays are rounded up to whole timer ticks.
+         */
+        struct RetryPolicy
+        {
+            uint32_t initialDelayUs = 10000;
+            uint16_t multiplierPercent = 100;   // 200 doubles the delay on every retry
+            uint32_t maxDelayUs = 10000;
+            uint8_t jitterPercent = 0;
+            uint16_t maxAttempts = 0;           // 0: retry until the bus is free
+
+            /*
+             *  @brief Seed of the jitter. 0 derives it from the MCU unique ID, so identical
+             *  firmware on two masters still draws different delays.
+             */
+            uint32_t jitterSeed = 0;
+        };
+
         enum class State
         {
             Idle,
@@ -54,6 +112,9 @@ class I2cBus
             RepeatedStart,
             RepeatedStartAckAddr,
             ReceiveData,
+
+            SendDataDma,
+            ReceiveDataDma,
         };
 
         enum class Selection
@@ -66,7 +127,8 @@ class I2cBus
         enum class InterruptType
         {
             Event,
-            Error
+            Error,
+            DmaRx
         };
 
         enum class DutyCycle
@@ -78,14 +140,30 @@ class I2cBus
 
         I2C_TypeDef* getInstance();
 
-        void init(const Config& config);
+        DRIVER_RESULT(void) init(const Config& config);
 
         I2cBus() = default;
+
+        /*
+         *  @brief Without exceptions the init status is lost, use init() or
+         *  Builder::buildIn() to get it.
+         */
         I2cBus(const Config& config);
         ~I2cBus();
 
         bool verifyPendingTransaction();
 
+        /*
+         *  @brief Withdraws a queued transaction, or stops the one in progress (releasing the
+         *  bus with a STOP). A chain is cancelled as a whole: through its head while queued,
+         *  through its head or any segment while in progress (whichever is on the wire).
+         *  Cancelled transactions are marked CANCELLED without running any callback and
+         *  their buffers are free to reuse on return.
+         *
+         *  @return false if the transaction was neither queued nor in progress.
+         */
+        bool cancel(I2cTransaction& transaction);
+
         /*
          *  @brief Checks whether the address is valid, taking into account the addressing mode
          *  (7 bit or 10 bit)
@@ -104,6 +182,24 @@ class I2cBus
         void enableInterrupts();
         void disableInterrupts();
 
+        /*
+         *  @brief Consistent copy of the counters. Interrupts are only masked while the
+         *  struct is copied.
+         */
+        Statistics getStatistics();
+        void resetStatistics();
+
+#ifdef ISR_PROFILING
+        /*
+         *  @brief Execution time of the event interrupt, split by the state the bus was in
+         *  when it fired.
+         */
+        const IsrStats& getIsrEventStats(State state);
+        const IsrStats& getIsrErrorStats();
+        const IsrStats& getIsrDmaStats();
+        void resetIsrStats();
+#endif
+
     protected:
         static std::array<I2cBus*, I2C_BUS_MAX> drivers;
 
@@ -115,6 +211,13 @@ class I2cBus
 
         I2cTransaction* currentTransaction = nullptr;
 
+        // Head of the chain currentTransaction belongs to (the transaction that was queued).
+        I2cTransaction* currentChainHead = nullptr;
+
+        // Lost arbitration, sent again before anything in the queue once the bus is free.
+        I2cTransaction* arbitrationLostTransaction = nullptr;
+        uint8_t maxArbitrationRetries = 3;
+
         I2C_TypeDef* instance = nullptr;
 
         Selection bus;
@@ -136,28 +239,74 @@ class I2cBus
 
         Timer* timer;
 
-        uint16_t retryIntervalMs;
+        // Alternative to a dedicated Timer: the busy-retry runs as a software timer.
+        TimerWheel* timerWheel = nullptr;
+        SoftTimer retryTimer;
+
+        RetryPolicy retryPolicy;
+        uint16_t retryAttempts = 0;
+        uint32_t retryDelayUs = 0;
+        uint32_t jitterState = 1;
+        bool retryPending = false;
+
+        bool dmaMode = false;
+
+        // Streams of this bus claimed through DmaStreams (see i2c_bus_dma.cpp).
+        bool dmaTxClaimed = false;
+        bool dmaRxClaimed = false;
+
+        // Slave window being moved by DMA: the length armed on the stream (0: none).
+        uint16_t slaveDmaLength = 0;
+        bool slaveDmaTx = false;
+
+        Statistics statistics;
+
+        uint32_t (*timestampSource)() = nullptr;
+
+#ifdef ISR_PROFILING
+        // One slot per State (ReceiveDataDma is the last one), then the ER and DMA interrupts.
+        static constexpr size_t ISR_PROFILE_ERROR_SLOT = static_cast<size_t>(State::ReceiveDataDma) + 1;
+        static constexpr size_t ISR_PROFILE_DMA_SLOT = ISR_PROFILE_ERROR_SLOT + 1;
+        IsrProfiler<ISR_PROFILE_DMA_SLOT + 1> isrProfiler;
+#endif
 
         uint32_t currentIndex;
 
-        static void handleInterrupt(Selection bus, InterruptType type);
+        /*
+         *  @brief Entry point of the interrupt handlers. The bus and the interrupt type are
+         *  template parameters, so each handler compiles down to one driver lookup and a
+         *  direct call. Never throws.
+         */
+        template <Selection Bus, InterruptType Type>
+        static void handleInterrupt() noexcept;
 
-        static void timerCallback(void* argument);
+        static void timerCallback(void* argument) noexcept;
 
         static uint16_t getBusDriverNumber(Selection bus);
 
-        uint32_t verifyTimer();
+        /*
+         *  @throws I2cException: When the retry policy can't be applied.
+         */
+        DRIVER_RESULT(void) verifyRetryPolicy();
 
-        void scheduleTimer();
+        /*
+         *  @brief Waits for the bus to be free following the retry policy. After
+         *  maxAttempts the transaction at the front of the queue is failed with its error
+         *  callback and the next one starts waiting from the initial delay.
+         */
+        void scheduleRetry();
+        uint32_t nextRetryDelayUs();
+        uint32_t retryDelayToTicks(uint32_t delayUs);
+        void giveUpPendingTransaction();
 
         /*
          *  @brief Initializes and enables the I2C peripheral using the stored config members.
          *
          *  @throws I2cException: If there's a HAL error.
          */
-        void initInstance();
+        DRIVER_RESULT(void) initInstance();
 
-        void registerDriver(Selection bus);
+        DRIVER_RESULT(void) registerDriver(Selection bus);
 
         void initGpio();
         void deinitGpio();
@@ -186,15 +335,19 @@ class I2cBus
          *
          *  @throws I2cException: When the provided parameters are not in a valid state.
          */
-        void areAddressesValid(uint16_t ownAddress1, uint16_t ownAddress2, bool addressing7bit);
+        DRIVER_RESULT(void) areAddressesValid(uint16_t ownAddress1, uint16_t ownAddress2, bool addressing7bit);
 
-        void attachDevice(I2cDevice& device);
+        DRIVER_RESULT(void) attachDevice(I2cDevice& device);
 
         void detachDevice(I2cDevice& device);
 
         bool sendNextTransaction();
 
-        void setTransaction(I2cTransaction& transaction);
+        /*
+         *  @brief Queues the transaction. If it can't be queued it's also marked as ERROR,
+         *  which is all I2cDevice::operator<< can report without exceptions.
+         */
+        DRIVER_RESULT(void) setTransaction(I2cTransaction& transaction);
 
         void eventCallback();
 
@@ -202,8 +355,64 @@ class I2cBus
 
         bool sendSlaveAddress(bool readBit);
         void prepareMasterRx(uint8_t remainingBytes);
+        /*
+         *  @brief Requests the condition that ends the current segment on the wire: a
+         *  REPEATED-START if it's chained to another one, a STOP otherwise.
+         */
+        void issueEndCondition();
+
+        /*
+         *  @brief Ends the current transaction. When it completed (postCallback) and is
+         *  chained, the bus moves on to the next segment instead of going back to Idle.
+         */
         void finishCurrentTransaction(bool postCallback);
 
+        /*
+         *  @brief Fails the in-flight master transaction: stops any DMA transfer, marks it as
+         *  ERROR (with the rest of its chain), runs its error callback and releases the bus
+         *  with a STOP. It already left the queue when it started.
+         */
+        void abortCurrentTransaction();
+
+        void cancelCurrentTransaction();
+
+        /*
+         *  @brief After an ARLO: the peripheral already fell back to slave mode and the bus
+         *  belongs to the other master, so no STOP. The transaction (a chain from its
+         *  first segment) is set aside and started again once the bus is free (see
+         *  sendNextTransaction()).
+         */
+        void retryLostArbitration();
+
+        bool hasPendingTransaction();
+        I2cTransaction* takePendingTransaction();
+
+        /*
+         *  @brief Whether the data phase of the current transaction is moved by DMA. Single
+         *  byte transfers always go through the interrupt path (the LAST/NACK handling of the
+         *  I2Cv1 peripheral needs at least 2 bytes).
+         */
+        bool isDmaTransfer();
+
+        /*
+         *  @brief Arm the stream for the data phase of the current transaction.
+         *
+         *  @return false, with nothing armed, if the stream is claimed by another driver.
+         *  The transfer then goes through the interrupt path.
+         */
+        bool startDmaTx();
+        bool startDmaRx();
+        void stopDma();
+        void dmaRxCallback();
+
+        /*
+         *  @brief Moves the slave TX/RX window by DMA, if it's 2+ bytes long and the stream
+         *  is free. Otherwise the bytes go through the TXE/RXNE interrupts.
+         */
+        bool startSlaveDma(bool transmit);
+        void stopSlaveDma();
+        void continueSlaveReceive();
+
         void masterStateStartAttemp();
         void masterStateSendSlaveAddress();
         void masterStateSendRegister();
@@ -213,9 +422,10 @@ class I2cBus
         void masterStateRepeatedStart();
         void masterStateRepeatedStartAckAddr();
         void masterStateReceiveData();
+        void masterStateSendDataDma();
+        void masterStateReceiveDataDma();
 
         void eventSlaveCallback();
-        void eventMasterCallback();
 
     friend class I2cDevice;
 
@@ -231,4 +441,34 @@ class I2cBus
     friend void I2C2_ER_IRQHandler();
 
     friend void I2C3_ER_IRQHandler();
-};
\ No newline at end of file
+
+    friend void DMA1_Stream0_IRQHandler();
+
+    friend void DMA1_Stream2_IRQHandler();
+
+    friend void DMA1_Stream3_IRQHandler();
+};
+
+template <I2cBus::Selection Bus, I2cBus::InterruptType Type>
+inline void I2cBus::handleInterrupt() noexcept
+{
+    I2cBus* driver = drivers[static_cast<size_t>(Bus)];
+    if(!driver)
+        return;
+
+#ifdef ISR_PROFILING
+    size_t slot = static_cast<size_t>(driver->state);
+    if constexpr(Type == InterruptType::Error)
+        slot = ISR_PROFILE_ERROR_SLOT;
+    else if constexpr(Type == InterruptType::DmaRx)
+        slot = ISR_PROFILE_DMA_SLOT;
+    IsrProfiler<ISR_PROFILE_DMA_SLOT + 1>::Scope profileScope(driver->isrProfiler, slot);
+#endif
+
+    if constexpr(Type == InterruptType::Event)
+        driver->eventCallback();
+    else if constexpr(Type == InterruptType::Error)
+        driver->errorCallback();
+    else
+        driver->dmaRxCallback();
+}
\ No newline at end of file
@@ -16,7 +16,11 @@ struct I2cBus::Config
     Set<I2cDevice*>* devicesSet = nullptr;
     I2cSlave* slave = nullptr;
     Timer* timer = nullptr;
-    uint16_t retryIntervalMs = 10;
+    TimerWheel* timerWheel = nullptr;
+    RetryPolicy retryPolicy;
+    uint8_t arbitrationRetries = 3;
+    bool dma = false;
+    uint32_t (*timestampSource)() = nullptr;
 };
 
 
@@ -26,7 +30,7 @@ class I2cBus::Builder
         Config config;
 
     public:
-        void buildIn(I2cBus& target);
+        DRIVER_RESULT(void) buildIn(I2cBus& target);
 
         Config buildConfig();
 
@@ -54,5 +58,30 @@ class I2cBus::Builder
 
         Builder& withTimer(Timer& timer);
 
+        /*
+         *  @brief Uses a software timer of a shared TimerWheel for the busy-retry instead of
+         *  a dedicated hardware Timer.
+         */
+        Builder& withTimerWheel(TimerWheel& timerWheel);
+
+        /*
+         *  @brief Fixed busy-retry interval, shorthand for a RetryPolicy without backoff.
+         */
         Builder& setRetryIntervalMs(uint16_t retryIntervalMs);
+
+        Builder& withRetryPolicy(const RetryPolicy& retryPolicy);
+
+        /*
+         *  @brief How many times a transaction that lost arbitration to another master is
+         *  sent again before failing with its error callback. 0 fails it right away.
+         */
+        Builder& withArbitrationRetries(uint8_t arbitrationRetries);
+
+        Builder& enableDma();
+
+        /*
+         *  @brief Free-running time source used to measure how long transactions wait in
+         *  the queue (see Statistics). Differences must be wrap-safe in 32 bits.
+         */
+        Builder& withTimestampSource(uint32_t (*timestampSource)());
 };
\ No newline at end of file
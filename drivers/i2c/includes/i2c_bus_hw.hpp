@@ -2,6 +2,8 @@
 
 #include "i2c_bus.hpp"   // I2cBus::Selection, and (via stm32f4xx.h) HAL types/macros
 
+#include "stm32f4xx_ll_dma.h"
+
 // ============================================================================
 // Per-bus hardware descriptor for the STM32F401 I2C peripherals.
 //
@@ -10,6 +12,12 @@
 //
 // F401 note: I2C2/I2C3 SDA use AF9 (PB3, PB4), NOT AF4. SCLs and I2C1 use AF4.
 // (On our clone boards PB9-AF9 is broken, which is why I2C2 SDA is PB3.)
+//
+// DMA (RM0368 table 28, all on DMA1). Streams are picked so that the three buses
+// never share one: I2C1 RX S0 / TX S6, I2C2 RX S3 / TX S7, I2C3 RX S2 / TX S4.
+// Timer requests can use the same streams, so they're claimed per transfer (DmaStreams).
+// Only the RX stream needs an interrupt (the STOP must be issued on its TC);
+// TX completion is detected through BTF on the EV interrupt.
 // ============================================================================
 struct I2cBusHw
 {
@@ -26,30 +34,50 @@ struct I2cBusHw
     uint8_t       sdaAf;
 
     void        (*enableClocks)();   // enables the I2C peripheral + GPIO port clock(s)
+
+    DMA_TypeDef*  dma;
+    uint32_t      dmaTxStream;
+    uint32_t      dmaTxChannel;
+    uint32_t      dmaRxStream;
+    uint32_t      dmaRxChannel;
+    IRQn_Type     dmaRxIrq;
+
+    void        (*enableDmaClock)(); // only called when the bus is configured in DMA mode
+};
+
+// At namespace scope, unlike a function-local static, it needs no init guard check on
+// every access.
+inline const I2cBusHw i2cBusHwTable[] =
+{
+    // Bus1 - panel / ESP32 link: SCL PB6 (AF4), SDA PB7 (AF4)
+    { I2C1, I2C1_EV_IRQn, I2C1_ER_IRQn,
+      GPIOB, GPIO_PIN_6, GPIO_AF4_I2C1,
+      GPIOB, GPIO_PIN_7, GPIO_AF4_I2C1,
+      []{ __HAL_RCC_I2C1_CLK_ENABLE(); __HAL_RCC_GPIOB_CLK_ENABLE(); },
+      DMA1, LL_DMA_STREAM_6, LL_DMA_CHANNEL_1,
+            LL_DMA_STREAM_0, LL_DMA_CHANNEL_1, DMA1_Stream0_IRQn,
+      []{ __HAL_RCC_DMA1_CLK_ENABLE(); } },
+
+    // Bus2 - inter-MCU: SCL PB10 (AF4), SDA PB3 (AF9)   [NOT PB9 on the clone]
+    { I2C2, I2C2_EV_IRQn, I2C2_ER_IRQn,
+      GPIOB, GPIO_PIN_10, GPIO_AF4_I2C2,
+      GPIOB, GPIO_PIN_3,  GPIO_AF9_I2C2,
+      []{ __HAL_RCC_I2C2_CLK_ENABLE(); __HAL_RCC_GPIOB_CLK_ENABLE(); },
+      DMA1, LL_DMA_STREAM_7, LL_DMA_CHANNEL_7,
+            LL_DMA_STREAM_3, LL_DMA_CHANNEL_7, DMA1_Stream3_IRQn,
+      []{ __HAL_RCC_DMA1_CLK_ENABLE(); } },
+
+    // Bus3 - ADC: SCL PA8 (AF4), SDA PB4 (AF9)
+    { I2C3, I2C3_EV_IRQn, I2C3_ER_IRQn,
+      GPIOA, GPIO_PIN_8, GPIO_AF4_I2C3,
+      GPIOB, GPIO_PIN_4, GPIO_AF9_I2C3,
+      []{ __HAL_RCC_I2C3_CLK_ENABLE(); __HAL_RCC_GPIOA_CLK_ENABLE(); __HAL_RCC_GPIOB_CLK_ENABLE(); },
+      DMA1, LL_DMA_STREAM_4, LL_DMA_CHANNEL_3,
+            LL_DMA_STREAM_2, LL_DMA_CHANNEL_3, DMA1_Stream2_IRQn,
+      []{ __HAL_RCC_DMA1_CLK_ENABLE(); } },
 };
 
 inline const I2cBusHw& i2cBusHw(I2cBus::Selection bus)
 {
-    static const I2cBusHw table[] =
-    {
-        // Bus1 - panel / ESP32 link: SCL PB6 (AF4), SDA PB7 (AF4)
-        { I2C1, I2C1_EV_IRQn, I2C1_ER_IRQn,
-          GPIOB, GPIO_PIN_6, GPIO_AF4_I2C1,
-          GPIOB, GPIO_PIN_7, GPIO_AF4_I2C1,
-          []{ __HAL_RCC_I2C1_CLK_ENABLE(); __HAL_RCC_GPIOB_CLK_ENABLE(); } },
-
-        // Bus2 - inter-MCU: SCL PB10 (AF4), SDA PB3 (AF9)   [NOT PB9 on the clone]
-        { I2C2, I2C2_EV_IRQn, I2C2_ER_IRQn,
-          GPIOB, GPIO_PIN_10, GPIO_AF4_I2C2,
-          GPIOB, GPIO_PIN_3,  GPIO_AF9_I2C2,
-          []{ __HAL_RCC_I2C2_CLK_ENABLE(); __HAL_RCC_GPIOB_CLK_ENABLE(); } },
-
-        // Bus3 - ADC: SCL PA8 (AF4), SDA PB4 (AF9)
-        { I2C3, I2C3_EV_IRQn, I2C3_ER_IRQn,
-          GPIOA, GPIO_PIN_8, GPIO_AF4_I2C3,
-          GPIOB, GPIO_PIN_4, GPIO_AF9_I2C3,
-          []{ __HAL_RCC_I2C3_CLK_ENABLE(); __HAL_RCC_GPIOA_CLK_ENABLE(); __HAL_RCC_GPIOB_CLK_ENABLE(); } },
-    };
-
-    return table[static_cast<int>(bus)];
+    return i2cBusHwTable[static_cast<int>(bus)];
 }
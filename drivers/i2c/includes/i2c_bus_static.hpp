@@ -1,12 +1,24 @@
 #pragma once
+#include <type_traits>
+
 #include "i2c_bus.hpp"
 #include "i2c_bus_builder.hpp"
+#include "priority_queue.hpp"
+#include "intrusive_queue.hpp"
 
-template <size_t TransactionsBufferSize, size_t DevicesBufferSize>
+/*
+ *  @brief I2C bus with statically allocated transaction queue and devices set.
+ *
+ *  With PriorityScheduling the queue serves transactions by I2cTransaction::PriorityOrder
+ *  (O(log n) enqueue/dequeue) instead of strict FIFO.
+ */
+template <size_t TransactionsBufferSize, size_t DevicesBufferSize, bool PriorityScheduling = false>
 class I2cBusStatic : public I2cBus
 {
     protected:
-        StaticQueue<I2cTransaction*, TransactionsBufferSize> queue;
+        std::conditional_t<PriorityScheduling,
+            StaticPriorityQueue<I2cTransaction*, TransactionsBufferSize, I2cTransaction::PriorityOrder>,
+            StaticQueue<I2cTransaction*, TransactionsBufferSize>> queue;
         StaticSet<I2cDevice*, DevicesBufferSize> devicesSet;
 
     public:
@@ -14,17 +26,48 @@ class I2cBusStatic : public I2cBus
         I2cBusStatic(const Config& config)
         {
             Config modifiableConfig = config;
-            init(modifiableConfig);
+            (void)init(modifiableConfig);
+        }
+
+        DRIVER_RESULT(void) init(Config& config)
+        {
+            if(config.queue)
+                DRIVER_FAIL(DriverError::InvalidConfig, std::logic_error("Pre-Configured queue for static I2C Bus."));
+
+            config.queue = &queue;
+            config.devicesSet = &devicesSet;
+
+            return I2cBus::init(config);
+        }
+};
+
+/*
+ *  @brief I2C bus that queues the transactions through their own links (IntrusiveQueue):
+ *  FIFO without a queue buffer or depth limit, and O(1) cancel().
+ */
+template <size_t DevicesBufferSize>
+class I2cBusIntrusive : public I2cBus
+{
+    protected:
+        IntrusiveQueue<I2cTransaction> queue;
+        StaticSet<I2cDevice*, DevicesBufferSize> devicesSet;
+
+    public:
+        I2cBusIntrusive() = default;
+        I2cBusIntrusive(const Config& config)
+        {
+            Config modifiableConfig = config;
+            (void)init(modifiableConfig);
         }
 
-        void init(Config& config)
+        DRIVER_RESULT(void) init(Config& config)
         {
             if(config.queue)
-                throw std::logic_error("Pre-Configured queue for static I2C Bus.");
+                DRIVER_FAIL(DriverError::InvalidConfig, std::logic_error("Pre-Configured queue for intrusive I2C Bus."));
 
             config.queue = &queue;
             config.devicesSet = &devicesSet;
 
-            I2cBus::init(config);
+            return I2cBus::init(config);
         }
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "i2c_bus.hpp"
 
+class I2cAwaitable;
+
 class I2cDevice
 {
     protected:
@@ -10,16 +12,34 @@ class I2cDevice
         std::string name;
 
     public:
+        /*
+         *  @brief Without exceptions, a device that can't be attached to `bus` is left
+         *  detached (its transactions are rejected).
+         */
         I2cDevice(uint16_t address, I2cBus* bus = nullptr, std::string name = "");
         ~I2cDevice();
 
         uint16_t getAddress();
 
-        void attachBus(I2cBus* bus);
+        DRIVER_RESULT(void) attachBus(I2cBus* bus);
 
         void detachBus();
 
-        void setTransaction(I2cTransaction& transaction);
+        DRIVER_RESULT(void) setTransaction(I2cTransaction& transaction);
+
+        /*
+         *  @brief See I2cBus::cancel().
+         */
+        bool cancel(I2cTransaction& transaction);
 
         I2cDevice& operator<<(I2cTransaction& transaction);
+
+        /*
+         *  @brief Transfers to co_await from an I2cTask (see i2c_async.hpp). The buffers
+         *  must stay valid until the transfer is done.
+         */
+        I2cAwaitable read(uint8_t* data, uint16_t length);
+        I2cAwaitable read(uint32_t deviceRegister, uint8_t* data, uint16_t length, uint8_t registerLength = 1);
+        I2cAwaitable write(uint8_t* data, uint16_t length);
+        I2cAwaitable write(uint32_t deviceRegister, uint8_t* data, uint16_t length, uint8_t registerLength = 1);
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "i2c_device.hpp"
+#include "timer.hpp"
+
+class I2cPoller;
+
+/*
+ *  @brief A register read repeated at a fixed rate by an I2cPoller. Owned by the caller,
+ *  like I2C transactions: it must outlive its time in the poller (remove it first).
+ *
+ *  Results are double-buffered: each read lands in the buffer the consumer isn't looking
+ *  at, and only replaces the published sample once it has completed without error.
+ */
+class I2cPoll
+{
+    public:
+        /*
+         *	@param buffers 2 * length bytes, used as the two sample buffers.
+         *	@param periodTicks Poller ticks between reads.
+         *	@param phaseTicks Ticks before the first read, to spread polls with the same
+         *	period over different ticks.
+         */
+        I2cPoll(I2cDevice& device, uint32_t deviceRegister, uint8_t* buffers, uint16_t length,
+                uint32_t periodTicks, uint32_t phaseTicks = 0, uint8_t registerLength = 1);
+
+        /*
+         *  @brief Copies the latest complete sample to `data` (length bytes).
+         *
+         *  @return false if no read has completed yet.
+         */
+        bool read(uint8_t* data);
+
+        // Completed reads, so consumers can tell a new sample from the one they have.
+        uint32_t getSampleCount();
+
+        // Reads skipped because the previous one was still queued or running.
+        uint32_t getSkippedCount();
+
+        uint32_t getErrorCount();
+
+    protected:
+        I2cPoll* next = nullptr;
+
+        I2cDevice& device;
+        I2cTransaction transaction;
+        uint8_t* buffers;
+        uint16_t length;
+
+        uint32_t period;
+        uint32_t phase;
+        uint32_t due = 0;
+
+        volatile uint8_t front = 0;
+        volatile bool pending = false;
+
+        volatile uint32_t samples = 0;
+        uint32_t skipped = 0;
+        uint32_t errors = 0;
+
+        void submit();
+
+        static void onFinished(void* parameters);
+        static void onFailed(void* parameters);
+
+    friend class I2cPoller;
+};
+
+/*
+ *  @brief Runs any number of I2cPoll reads from one Timer, without the application
+ *  re-submitting them: every alarm of the timer is one poller tick (set its period with
+ *  Timer::setAlarm() before start()).
+ *
+ *  A poll whose previous read hasn't finished when it's due is skipped instead of being
+ *  queued again, and a poll that fell several periods behind fires once and keeps its
+ *  rate from then on: a slow bus never piles up polls in its queue.
+ */
+class I2cPoller
+{
+    public:
+        I2cPoller() = default;
+        I2cPoller(Timer& timer);
+
+        void init(Timer& timer);
+
+        void start();
+        void pause();
+
+        // Any context. The first read is phaseTicks from now.
+        void add(I2cPoll& poll);
+
+        // Any context. A read in progress is cancelled.
+        void remove(I2cPoll& poll);
+
+        uint32_t getTicks();
+
+    protected:
+        Timer* timer = nullptr;
+        I2cPoll* first = nullptr;
+        volatile uint32_t now = 0;
+
+        static void tickCallback(void* argument);
+};
\ No newline at end of file
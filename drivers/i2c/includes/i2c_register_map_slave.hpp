@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <string.h>
+
+#include "stm32f4xx.h"
+
+#include "i2c_slave.hpp"
+#include "inplace_function.hpp"
+
+/*
+ *  @brief Slave exposing a register file, like most I2C peripherals do:
+ *
+ *      Write: START addr+W  reg  data...                       STOP
+ *      Read:  START addr+W  reg  REPEATED-START addr+R  data...  STOP
+ *
+ *  The first byte of a write sets the register pointer and the rest are stored from it
+ *  on (auto-increment). A read starts at the pointer. Bytes go through the I2cSlave
+ *  windows, so there are no per-byte virtual calls within the register file: reads are
+ *  served from a snapshot taken at the address match (multi-byte values read
+ *  atomically), and writes are staged and applied at once when the transaction ends,
+ *  filtered by the write mask, with a single onMasterWrite() notification.
+ *
+ *  Reads past the end return 0xFF, writes past the end and to registers out of range
+ *  are ignored.
+ */
+template <size_t Size>
+class I2cRegisterMapSlave : public I2cSlave
+{
+    static_assert(Size > 0 && Size <= 256, "Register addresses are one byte.");
+
+    public:
+        // Called from the I2C interrupt once a master write was applied.
+        using WriteCallback = InplaceFunction<void(uint8_t firstRegister, uint16_t length)>;
+
+        I2cRegisterMapSlave()
+        {
+            writeMask.fill(0xFF);
+        }
+
+        /*
+         *  @brief Application side update, atomic with respect to a master read.
+         */
+        void write(uint8_t firstRegister, const uint8_t* data, uint16_t length)
+        {
+            length = clip(firstRegister, length);
+
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            memcpy(&registers[firstRegister], data, length);
+            __set_PRIMASK(primask);
+        }
+
+        void read(uint8_t firstRegister, uint8_t* data, uint16_t length)
+        {
+            length = clip(firstRegister, length);
+
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            memcpy(data, &registers[firstRegister], length);
+            __set_PRIMASK(primask);
+        }
+
+        /*
+         *  @brief Bits the master can change (1: writable). All writable by default.
+         */
+        void setWriteMask(uint8_t firstRegister, uint8_t mask, uint16_t count = 1)
+        {
+            count = clip(firstRegister, count);
+            for(uint16_t i = 0; i < count; i++)
+                writeMask[firstRegister + i] = mask;
+        }
+
+        void onMasterWrite(WriteCallback callback)
+        {
+            writeCallback = callback;
+        }
+
+        void onAddressMatch(Direction direction) override
+        {
+            // A write followed by a REPEATED-START (register pointer set for a read) never
+            // gets a STOP, so it's applied here.
+            commitStagedWrite();
+
+            if(direction == Direction::TX)
+            {
+                uint16_t length = Size - pointer;
+                memcpy(snapshot.data(), &registers[pointer], length);
+                txWindow = snapshot.data();
+                txWindowLength = length;
+            }
+            else
+            {
+                rxWindow = staging.data();
+                rxWindowLength = staging.size();
+            }
+        }
+
+        void onWriteByte(const uint8_t) override
+        {
+        }
+
+        uint8_t onReadByte() override
+        {
+            return 0xFF;
+        }
+
+        void onEndTransaction() override
+        {
+            commitStagedWrite();
+            txWindowLength = 0;
+        }
+
+        void onError() override
+        {
+            rxWindow = nullptr;
+            rxWindowLength = 0;
+            txWindowLength = 0;
+        }
+
+    protected:
+        std::array<uint8_t, Size> registers = {};
+        std::array<uint8_t, Size> writeMask;
+        std::array<uint8_t, Size> snapshot;
+
+        // Register address + data of the write in progress.
+        std::array<uint8_t, Size + 1> staging;
+
+        uint8_t pointer = 0;
+        WriteCallback writeCallback;
+
+        static uint16_t clip(uint8_t firstRegister, uint16_t length)
+        {
+            if(firstRegister >= Size)
+                return 0;
+            return length < Size - firstRegister ? length : Size - firstRegister;
+        }
+
+        void commitStagedWrite()
+        {
+            if(!rxWindow)
+                return;
+
+            uint16_t received = rxWindow - staging.data();
+            rxWindow = nullptr;
+            rxWindowLength = 0;
+
+            if(received == 0 || staging[0] >= Size)
+                return;
+
+            pointer = staging[0];
+            uint16_t length = clip(pointer, received - 1);
+            for(uint16_t i = 0; i < length; i++)
+            {
+                uint8_t& reg = registers[pointer + i];
+                uint8_t mask = writeMask[pointer + i];
+                reg = (reg & ~mask) | (staging[1 + i] & mask);
+            }
+
+            if(length && writeCallback)
+                writeCallback(pointer, length);
+        }
+};
\ No newline at end of file
@@ -23,13 +23,56 @@ class I2cSlave
 
         virtual void onError() = 0;
 
+        /*
+         *  @brief Called once the RX window is used up. A new window can be set from here,
+         *  e.g. the payload window once a header byte holding the frame length is in.
+         */
+        virtual void onRxWindowFull()
+        {
+        }
+
     protected:
         I2cBus* bus;
 
+        /*
+         *  @brief Optional byte windows, set up from onAddressMatch(). While they last the
+         *  bus moves the bytes straight from/to memory, and only calls onReadByte() /
+         *  onWriteByte() once they're used up. Both advance as bytes are moved. On a bus with
+         *  DMA enabled, windows of 2+ bytes are moved by DMA while a stream is available.
+         */
+        const uint8_t* txWindow = nullptr;
+        uint16_t txWindowLength = 0;
+        uint8_t* rxWindow = nullptr;
+        uint16_t rxWindowLength = 0;
+
+        // Bytes received in the current write transaction, valid in onEndTransaction().
+        uint16_t receivedLength = 0;
+
         void setBus(I2cBus& bus)
         {
             this->bus = &bus;
         }
 
+    private:
+        uint8_t nextTxByte()
+        {
+            if(!txWindowLength)
+                return onReadByte();
+
+            txWindowLength--;
+            return *txWindow++;
+        }
+
+        void pushRxByte(uint8_t data)
+        {
+            receivedLength++;
+            if(!rxWindowLength)
+                return onWriteByte(data);
+
+            *rxWindow++ = data;
+            if(!--rxWindowLength)
+                onRxWindowFull();
+        }
+
     friend class I2cBus;
 };
\ No newline at end of file
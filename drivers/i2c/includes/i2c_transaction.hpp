@@ -1,16 +1,27 @@
 #pragma once
 
 #include <stdint.h>
-#include <functional>
+#include "inplace_function.hpp"
+#include "driver_result.hpp"
+#include "intrusive_queue.hpp"
+#include "buffer_publisher.hpp"
 
 class I2cDevice;
 class I2cBus;
 
-class I2cTransaction
+// The node lets a transaction be queued in an IntrusiveQueue without any buffer.
+class I2cTransaction : public IntrusiveQueueNode<I2cTransaction>
 {
     public:
         class Builder;
 
+        struct PriorityOrder;
+
+        // Non-allocating, safe to build and call from ISR context. The context comes in
+        // the parameter, so one pointer of storage is enough: a function pointer or a
+        // lambda capturing one pointer.
+        using Callback = InplaceFunction<void(void*), sizeof(void*)>;
+
         enum Direction
         {
             RX,
@@ -25,13 +36,14 @@ class I2cTransaction
             EXCHANGING_DATA,
             FINISHED,
             ERROR,
+            CANCELLED,
         };
 
         uint16_t getAddress();
 
-        uint8_t getByte(uint16_t index);
+        DRIVER_RESULT(uint8_t) getByte(uint16_t index);
 
-        void setByte(uint8_t byte, uint16_t index);
+        DRIVER_RESULT(void) setByte(uint8_t byte, uint16_t index);
 
         uint8_t* getDataPointer();
 
@@ -41,7 +53,7 @@ class I2cTransaction
 
         bool hasRegister();
 
-        uint8_t getRegisterByte(uint8_t index);
+        DRIVER_RESULT(uint8_t) getRegisterByte(uint8_t index);
 
         uint8_t getRegisterLengthBytes();
 
@@ -49,6 +61,14 @@ class I2cTransaction
 
         void setState(State state);
 
+        uint8_t getPriority();
+
+        bool hasDeadline();
+
+        uint32_t getDeadline();
+
+        I2cTransaction* getNextSegment();
+
         bool isTx();
 
         bool isRx();
@@ -60,7 +80,7 @@ class I2cTransaction
         void errorCallback();
 
     protected:
-        I2cDevice* device;
+        I2cDevice* device = nullptr;
         Direction direction;
         State state;
 
@@ -69,14 +89,42 @@ class I2cTransaction
         uint32_t deviceRegister;
         uint8_t deviceRegisterBytes;
 
+        uint8_t priority = 0;
+        bool deadlineSet = false;
+        uint32_t deadline = 0;
+
+        I2cTransaction* nextSegment = nullptr;
+
+        uint32_t enqueueTimestamp = 0;
+        uint8_t arbitrationRetries = 0;
+
+        BufferPublisher* publisher = nullptr;
+
         void* preCallbackParameters = nullptr;
         void* postCallbackParameters = nullptr;
         void* errorCallbackParameters = nullptr;
-        std::function<void(void*)> preCallbackFunction = nullptr;
-        std::function<void(void*)> postCallbackFunction = nullptr;
-        std::function<void(void*)> errorCallbackFunction = nullptr;
+        Callback preCallbackFunction = nullptr;
+        Callback postCallbackFunction = nullptr;
+        Callback errorCallbackFunction = nullptr;
+
+        // Unchecked, for the interrupt path: the bus state machine keeps the index in range.
+        uint8_t registerByteAt(uint8_t index) const noexcept;
 
     friend class I2cDevice;
+    friend class I2cBus;
+    friend class I2cAwaitable;
+    friend class I2cPoll;
+};
+
+/*
+ *  @brief Service order used by the bus priority queue (see I2cBusStatic). Higher priority
+ *  first; within the same priority, transactions with a deadline go first, earliest
+ *  deadline first. Deadlines are compared wrap-safe, in whatever time base the
+ *  application uses for all of them.
+ */
+struct I2cTransaction::PriorityOrder
+{
+    bool operator()(I2cTransaction* a, I2cTransaction* b) const;
 };
 
 class I2cTransaction::Builder
@@ -86,13 +134,37 @@ class I2cTransaction::Builder
 
         Builder& withData(uint8_t* data, uint16_t sizeBytes);
 
+        /*
+         *  @brief Receives into the write buffer of `publisher` (e.g. a TripleBuffer)
+         *  instead of a fixed buffer, and publishes it when the transaction finishes, right
+         *  after the post callback. Readers then get complete samples without masking
+         *  interrupts, while the next run of the transaction fills another buffer. Replaces
+         *  withData(). RX only.
+         */
+        Builder& publishTo(BufferPublisher& publisher);
+
         Builder& withRegister(uint32_t deviceRegister, uint8_t length = 1);
 
-        Builder& withPreCallback(std::function<void(void*)> function, void* parameters = nullptr);
+        Builder& withPreCallback(Callback function, void* parameters = nullptr);
+
+        Builder& withPostCallback(Callback function, void* parameters = nullptr);
+
+        Builder& withErrorCallback(Callback function, void* parameters = nullptr);
+
+        Builder& withPriority(uint8_t priority);
 
-        Builder& withPostCallback(std::function<void(void*)> function, void* parameters = nullptr);
+        Builder& withDeadline(uint32_t deadline);
 
-        Builder& withErrorCallback(std::function<void(void*)> function, void* parameters = nullptr);
+        /*
+         *  @brief Chains `next` after this transaction: it's sent right after it with a
+         *  REPEATED-START instead of a STOP, and no other queued transaction can run in
+         *  between. Only the head of the chain is queued; `next` can be chained in turn.
+         *  Each segment gets its own callbacks. If a segment fails, the remaining ones are
+         *  marked as ERROR without running.
+         *
+         *	@param next Next segment. Must outlive the chain, like the data buffers.
+         */
+        Builder& chainWith(I2cTransaction& next);
 
         I2cTransaction build();
 
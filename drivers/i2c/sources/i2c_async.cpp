@@ -0,0 +1,216 @@
+#include "i2c_async.hpp"
+
+#include <exception>
+
+#include "stm32f4xx.h"
+
+namespace
+{
+    alignas(std::max_align_t) uint8_t frames[I2C_TASK_POOL_SIZE][I2C_TASK_FRAME_SIZE];
+    uint32_t usedFrames = 0;
+
+    constexpr uint32_t allFrames = I2C_TASK_POOL_SIZE == 32 ? ~0U : (1U << I2C_TASK_POOL_SIZE) - 1;
+}
+
+void* I2cTask::promise_type::operator new(size_t size) noexcept
+{
+    if(size > I2C_TASK_FRAME_SIZE)
+        return nullptr;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    void* frame = nullptr;
+    if(usedFrames != allFrames)
+    {
+        uint32_t index = __builtin_ctz(~usedFrames);
+        usedFrames |= 1U << index;
+        frame = frames[index];
+    }
+
+    __set_PRIMASK(primask);
+    return frame;
+}
+
+void I2cTask::promise_type::operator delete(void* frame) noexcept
+{
+    uint32_t index = (static_cast<uint8_t*>(frame) - &frames[0][0]) / I2C_TASK_FRAME_SIZE;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    usedFrames &= ~(1U << index);
+    __set_PRIMASK(primask);
+}
+
+void I2cTask::promise_type::unhandled_exception()
+{
+#ifdef DRIVERS_NO_EXCEPTIONS
+    std::terminate();
+#else
+    // Out of the poll() (or spawn()) that resumed the task.
+    throw;
+#endif
+}
+
+std::coroutine_handle<> I2cTask::FinalAwaiter::await_suspend(Handle handle) noexcept
+{
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+
+    // Spawned tasks have no owner left to destroy them.
+    if(handle.promise().detached)
+        handle.destroy();
+
+    if(continuation)
+        return continuation;
+    return std::noop_coroutine();
+}
+
+std::coroutine_handle<> I2cTask::Awaiter::await_suspend(Handle parent) noexcept
+{
+    child.promise().continuation = parent;
+    child.promise().executor = parent.promise().executor;
+    return child;
+}
+
+I2cTask::I2cTask(I2cTask&& other) noexcept : handle(other.handle)
+{
+    other.handle = nullptr;
+}
+
+I2cTask::~I2cTask()
+{
+    if(handle)
+        handle.destroy();
+}
+
+bool I2cTask::isValid() const
+{
+    return static_cast<bool>(handle);
+}
+
+bool I2cTask::isDone() const
+{
+    return !handle || handle.done();
+}
+
+I2cTask::Awaiter I2cTask::operator co_await() && noexcept
+{
+    return Awaiter{handle};
+}
+
+bool I2cExecutor::spawn(I2cTask&& task)
+{
+    if(!task.handle)
+        return false;
+
+    task.handle.promise().executor = this;
+    task.handle.promise().detached = true;
+    post(task.handle);
+    task.handle = nullptr;
+    return true;
+}
+
+void I2cExecutor::poll()
+{
+    while(true)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        bool empty = ready.isEmpty();
+        std::coroutine_handle<> handle;
+        if(!empty)
+            handle = DRIVER_VALUE(ready.dequeue());
+        __set_PRIMASK(primask);
+
+        if(empty)
+            return;
+
+        handle.resume();
+    }
+}
+
+void I2cExecutor::post(std::coroutine_handle<> handle)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    // Can't be full, see `ready`.
+    (void)ready.enqueue(handle);
+    __set_PRIMASK(primask);
+}
+
+I2cAwaitable I2cDevice::read(uint8_t* data, uint16_t length)
+{
+    return read(0, data, length, 0);
+}
+
+I2cAwaitable I2cDevice::read(uint32_t deviceRegister, uint8_t* data, uint16_t length, uint8_t registerLength)
+{
+    I2cTransaction::Builder builder{};
+    builder.setDirection(I2cTransaction::RX)
+           .withData(data, length)
+           .withRegister(deviceRegister, registerLength);
+    return I2cAwaitable(*this, builder);
+}
+
+I2cAwaitable I2cDevice::write(uint8_t* data, uint16_t length)
+{
+    return write(0, data, length, 0);
+}
+
+I2cAwaitable I2cDevice::write(uint32_t deviceRegister, uint8_t* data, uint16_t length, uint8_t registerLength)
+{
+    I2cTransaction::Builder builder{};
+    builder.setDirection(I2cTransaction::TX)
+           .withData(data, length)
+           .withRegister(deviceRegister, registerLength);
+    return I2cAwaitable(*this, builder);
+}
+
+I2cAwaitable::I2cAwaitable(I2cDevice& device, I2cTransaction::Builder& builder)
+    : device(device),
+      transaction(builder.withPostCallback(onFinished, this).withErrorCallback(onFailed, this).build())
+{
+    transaction.device = &device;
+}
+
+I2cAwaitable::~I2cAwaitable()
+{
+    // The task was destroyed while the transfer was still queued or running.
+    if(pending)
+        device.cancel(transaction);
+}
+
+bool I2cAwaitable::await_suspend(I2cTask::Handle handle)
+{
+    this->executor = handle.promise().executor;
+    this->handle = handle;
+    pending = true;
+
+#ifdef DRIVERS_NO_EXCEPTIONS
+    if(!device.setTransaction(transaction))
+    {
+        // Rejected, resume right away with false.
+        pending = false;
+        return false;
+    }
+#else
+    device.setTransaction(transaction);
+#endif
+    return true;
+}
+
+void I2cAwaitable::onFinished(void* parameters)
+{
+    I2cAwaitable* awaitable = static_cast<I2cAwaitable*>(parameters);
+    awaitable->succeeded = true;
+    awaitable->pending = false;
+    awaitable->executor->post(awaitable->handle);
+}
+
+void I2cAwaitable::onFailed(void* parameters)
+{
+    I2cAwaitable* awaitable = static_cast<I2cAwaitable*>(parameters);
+    awaitable->succeeded = false;
+    awaitable->pending = false;
+    awaitable->executor->post(awaitable->handle);
+}
\ No newline at end of file
@@ -5,7 +5,6 @@
 
 #include "stm32f4xx_ll_i2c.h"
 
-#define EXPECTED_TIMER_TOLERANCE_PERIOD_US 100
 #define I2C_FAST_MODE_CUTOFF_FREQUENCY 100000
 #define I2C_EVENT_IRQ_PRIORITY 1
 #define I2C_ERROR_IRQ_PRIORITY 1
@@ -18,116 +17,264 @@ I2C_TypeDef* I2cBus::getInstance()
     return instance;
 }
 
-void I2cBus::timerCallback(void* argument)
+void I2cBus::timerCallback(void* argument) noexcept
 {
     I2cBus* bus = static_cast<I2cBus*>(argument);
 
-    bool sent = bus->sendNextTransaction();
-    if(!sent)
-        bus->scheduleTimer();
+    bus->statistics.busyRetries++;
+    bus->retryPending = false;
+
+    // Reschedules itself (scheduleRetry) if the bus is still BUSY.
+    bus->sendNextTransaction();
 }
 
-void I2cBus::scheduleTimer()
+void I2cBus::scheduleRetry()
 {
-    auto ticks = verifyTimer();
+    if(retryPending)
+        return;
+
+    if(retryPolicy.maxAttempts && retryAttempts >= retryPolicy.maxAttempts)
+    {
+        giveUpPendingTransaction();
+        if(!hasPendingTransaction())
+            return;
+    }
+
+    if(retryAttempts == 0)
+        retryDelayUs = retryPolicy.initialDelayUs;
+    retryAttempts++;
+
+    auto ticks = retryDelayToTicks(nextRetryDelayUs());
+    retryPending = true;
+
+    if(timerWheel)
+    {
+        timerWheel->start(retryTimer, ticks, timerCallback, this);
+        return;
+    }
+
     timer->setCallback(timerCallback, this);
     timer->setAlarm(ticks, true);
     timer->start();
 }
 
+uint32_t I2cBus::nextRetryDelayUs()
+{
+    uint32_t delayUs = retryDelayUs;
+
+    uint64_t grownUs = static_cast<uint64_t>(retryDelayUs) * retryPolicy.multiplierPercent / 100;
+    retryDelayUs = grownUs > retryPolicy.maxDelayUs ? retryPolicy.maxDelayUs : grownUs;
+
+    if(retryPolicy.jitterPercent)
+    {
+        // xorshift32: cheap enough for the ISR, only needs to decorrelate the masters.
+        jitterState ^= jitterState << 13;
+        jitterState ^= jitterState >> 17;
+        jitterState ^= jitterState << 5;
+
+        uint32_t spanUs = static_cast<uint64_t>(delayUs) * retryPolicy.jitterPercent / 100;
+        delayUs -= jitterState % (spanUs + 1);
+    }
+
+    return delayUs;
+}
+
+uint32_t I2cBus::retryDelayToTicks(uint32_t delayUs)
+{
+    uint32_t tickPeriodUs = timerWheel ? timerWheel->getTickPeriodUs() : timer->getPeriodUs();
+
+    // Rounded up, waiting a bit longer is harmless. A delay longer than the counter
+    // range of a dedicated timer is cut down to it (a TimerWheel has no such limit).
+    uint32_t ticks = delayUs / tickPeriodUs + (delayUs % tickPeriodUs != 0);
+    if(ticks == 0)
+        ticks = 1;
+    if(!timerWheel && ticks > timer->getMaxCount())
+        ticks = timer->getMaxCount();
+
+    return ticks;
+}
+
+void I2cBus::giveUpPendingTransaction()
+{
+    I2cTransaction* transaction = takePendingTransaction();
+
+    statistics.retryGiveUps++;
+    statistics.transactionsFailed++;
+    transaction->setState(I2cTransaction::ERROR);
+    transaction->errorCallback();
+
+    for(auto segment = transaction->getNextSegment(); segment; segment = segment->getNextSegment())
+        segment->setState(I2cTransaction::ERROR);
+
+    // The next transaction waits from the initial delay again.
+    retryAttempts = 0;
+}
+
 bool I2cBus::verifyPendingTransaction()
 {
     return sendNextTransaction();
 }
 
+bool I2cBus::hasPendingTransaction()
+{
+    return arbitrationLostTransaction || queue->peek();
+}
+
+I2cTransaction* I2cBus::takePendingTransaction()
+{
+    I2cTransaction* transaction = arbitrationLostTransaction;
+    if(transaction)
+    {
+        arbitrationLostTransaction = nullptr;
+        return transaction;
+    }
+
+    return DRIVER_VALUE(queue->dequeue());
+}
+
 bool I2cBus::sendNextTransaction()
 {
-    auto newTransaction = queue->peek();
-    if(!newTransaction)
+    if(currentTransaction)
         return false;
 
-    currentTransaction = *newTransaction;
+    if(!hasPendingTransaction())
+        return false;
 
     if(LL_I2C_IsActiveFlag_BUSY(instance))
     {
-        if(timer)
-            scheduleTimer();
+        if(timer || timerWheel)
+            scheduleRetry();
         return false;
     }
 
+    retryAttempts = 0;
+
+    // The in-flight transaction leaves the queue when it starts, so a higher priority
+    // one enqueued meanwhile can't take its place at the front.
+    bool retry = arbitrationLostTransaction != nullptr;
+    currentTransaction = takePendingTransaction();
+    currentChainHead = currentTransaction;
+
+    if(timestampSource && !retry)
+    {
+        uint32_t queueTime = timestampSource() - currentTransaction->enqueueTimestamp;
+        if(queueTime > statistics.maxQueueTime)
+            statistics.maxQueueTime = queueTime;
+        statistics.totalQueueTime += queueTime;
+        statistics.queueTimeSamples++;
+    }
+
     LL_I2C_GenerateStartCondition(instance);
     currentTransaction->setState(I2cTransaction::STARTING);
     state = State::StartAttempt;
     return true;
 }
 
-void I2cBus::setTransaction(I2cTransaction& transaction)
+DRIVER_RESULT(void) I2cBus::setTransaction(I2cTransaction& transaction)
 {
+    if(timestampSource)
+        transaction.enqueueTimestamp = timestampSource();
+    transaction.arbitrationRetries = 0;
+
+#ifdef DRIVERS_NO_EXCEPTIONS
+    auto enqueued = queue->enqueue(&transaction);
+    if(!enqueued)
+    {
+        transaction.setState(I2cTransaction::ERROR);
+        return enqueued;
+    }
+#else
     queue->enqueue(&transaction);
+#endif
 
-    if(queue->size() == 1 && state == State::Idle)
+    uint16_t depth = queue->size();
+    if(depth > statistics.maxQueueDepth)
+        statistics.maxQueueDepth = depth;
+
+    // Taking the transaction is on the consumer side of the queue, like the bus ISRs.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if(depth == 1 && state == State::Idle)
         sendNextTransaction();
+    __set_PRIMASK(primask);
+
+    return DRIVER_OK;
 }
 
 void I2cBus::eventCallback()
 {
-    switch(state)
+    // Single dispatch on the state, one entry per State in declaration order.
+    static constexpr void (I2cBus::*handlers[])() =
     {
-        case State::Idle:
-        case State::SlaveTransmit:
-        case State::SlaveReceive:
-            eventSlaveCallback();
-            break;
+        &I2cBus::eventSlaveCallback,                // Idle
+        &I2cBus::eventSlaveCallback,                // SlaveTransmit
+        &I2cBus::eventSlaveCallback,                // SlaveReceive
+        &I2cBus::masterStateStartAttemp,            // StartAttempt
+        &I2cBus::masterStateSendSlaveAddress,       // SendSlaveAddress
+        &I2cBus::masterStateSendRegister,           // SendRegister
+        &I2cBus::masterStateSendData,               // SendData
+        &I2cBus::masterStateSendLastDataByte,       // SendLastDataByte
+        &I2cBus::masterStateSendLastRegisterByte,   // LastRegisterByte
+        &I2cBus::masterStateRepeatedStart,          // RepeatedStart
+        &I2cBus::masterStateRepeatedStartAckAddr,   // RepeatedStartAckAddr
+        &I2cBus::masterStateReceiveData,            // ReceiveData
+        &I2cBus::masterStateSendDataDma,            // SendDataDma
+        &I2cBus::masterStateReceiveDataDma,         // ReceiveDataDma
+    };
+    static_assert(std::size(handlers) == static_cast<size_t>(State::ReceiveDataDma) + 1,
+                  "One event handler per bus state");
+
+    (this->*handlers[static_cast<size_t>(state)])();
+}
 
-        case State::StartAttempt:
-        case State::SendSlaveAddress:
-        case State::SendRegister:
-        case State::SendData:
-        case State::SendLastDataByte:
-        case State::LastRegisterByte:
-        case State::RepeatedStart:
-        case State::RepeatedStartAckAddr:
-        case State::ReceiveData:
-            eventMasterCallback();
-            break;
-    }
+#ifdef ISR_PROFILING
+const IsrStats& I2cBus::getIsrEventStats(State state)
+{
+    return isrProfiler.get(static_cast<size_t>(state));
 }
 
-void I2cBus::handleInterrupt(Selection bus, InterruptType type)
+const IsrStats& I2cBus::getIsrErrorStats()
 {
-    I2cBus *driver = I2cBus::drivers[getBusDriverNumber(bus)];
-    if(driver)
-    {
-        switch(type)
-        {
-        case InterruptType::Event:
-            driver->eventCallback();
-            break;
-        case InterruptType::Error:
-            driver->errorCallback();
-            break;
-        }
-    }
+    return isrProfiler.get(ISR_PROFILE_ERROR_SLOT);
 }
 
-uint32_t I2cBus::verifyTimer()
+const IsrStats& I2cBus::getIsrDmaStats()
 {
-    uint32_t timerPeriodUs = timer->getPeriodUs();
+    return isrProfiler.get(ISR_PROFILE_DMA_SLOT);
+}
+
+void I2cBus::resetIsrStats()
+{
+    isrProfiler.reset();
+}
+#endif
+
+DRIVER_RESULT(void) I2cBus::verifyRetryPolicy()
+{
+    if(retryPolicy.initialDelayUs == 0 || retryPolicy.maxDelayUs < retryPolicy.initialDelayUs)
+        DRIVER_FAIL(DriverError::InvalidConfig, I2cException("Invalid retry delays"));
 
-    uint32_t retryIntervalUs = retryIntervalMs * 1000;
-    uint32_t expectedTicks = retryIntervalUs / timerPeriodUs;
-    uint32_t actualRetryTimeUs  = timerPeriodUs * expectedTicks;
+    if(retryPolicy.multiplierPercent < 100 || retryPolicy.jitterPercent > 100)
+        DRIVER_FAIL(DriverError::InvalidConfig, I2cException("Invalid retry backoff"));
 
-    if (expectedTicks == 0)
-        throw I2cException("Retry interval too short for timer resolution");
+    uint32_t tickPeriodUs = timerWheel ? timerWheel->getTickPeriodUs() : timer->getPeriodUs();
+    if(tickPeriodUs == 0)
+        DRIVER_FAIL(DriverError::InvalidConfig, I2cException("Misconfigured timer"));
 
-    if (abs((int32_t)(actualRetryTimeUs  - retryIntervalUs)) > EXPECTED_TIMER_TOLERANCE_PERIOD_US)
-        throw I2cException("Misconfigured timer");
+    jitterState = retryPolicy.jitterSeed;
+    if(!jitterState)
+    {
+        const uint32_t* uid = reinterpret_cast<const uint32_t*>(UID_BASE);
+        jitterState = uid[0] ^ uid[1] ^ uid[2];
+    }
+    jitterState ^= static_cast<uint32_t>(bus) * 0x9E3779B9U;
+    if(!jitterState)
+        jitterState = 1;
 
-    return expectedTicks;
+    return DRIVER_OK;
 }
 
-void I2cBus::init(const Config& config)
+DRIVER_RESULT(void) I2cBus::init(const Config& config)
 {
     bus = config.bus;
     name = config.name;
@@ -135,7 +282,11 @@ void I2cBus::init(const Config& config)
     queue = config.queue;
     attachedDevices = config.devicesSet;
     timer = config.timer;
-    retryIntervalMs = config.retryIntervalMs;
+    timerWheel = config.timerWheel;
+    retryPolicy = config.retryPolicy;
+    maxArbitrationRetries = config.arbitrationRetries;
+    dmaMode = config.dma;
+    timestampSource = config.timestampSource;
 
     // Save init parameters so resetBus() can reconfigure the peripheral.
     clockSpeed      = config.clockSpeed;
@@ -151,16 +302,20 @@ void I2cBus::init(const Config& config)
 
     if(timer)
     {
-        verifyTimer();
+        DRIVER_TRY(verifyRetryPolicy());
         timer->setCallback(timerCallback, this);
     }
-    registerDriver(this->bus);
+    else if(timerWheel)
+    {
+        DRIVER_TRY(verifyRetryPolicy());
+    }
+    DRIVER_TRY(registerDriver(this->bus));
 
     this->fastMode = config.clockSpeed >= I2C_FAST_MODE_CUTOFF_FREQUENCY;
 
     bool masterOnly = (config.ownAddress1 == 0x0) && (config.ownAddress2 == 0x0);
     if(!masterOnly)
-        areAddressesValid(config.ownAddress1, config.ownAddress2, config.addressing7Bit);
+        DRIVER_TRY(areAddressesValid(config.ownAddress1, config.ownAddress2, config.addressing7Bit));
 
     // Free the bus in case it got stuck (a slave holding SDA, or the peripheral
     // with BUSY latched) BEFORE configuring the pins as I2C.
@@ -169,26 +324,32 @@ void I2cBus::init(const Config& config)
     // GPIO must be configured BEFORE enabling the peripheral: if the I2C is enabled
     // while SDA/SCL are low, the BUSY flag latches and won't clear without a peripheral reset.
     initGpio();
-    initInstance();
+    if(dmaMode)
+        i2cBusHw(bus).enableDmaClock();
+    DRIVER_TRY(initInstance());
     enableInterrupts();
+
+    return DRIVER_OK;
 }
 
 I2cBus::I2cBus(const Config& config)
 {
-    init(config);
+    (void)init(config);
 }
 
-void I2cBus::areAddressesValid(uint16_t ownAddress1, uint16_t ownAddress2, bool addressing7bit)
+DRIVER_RESULT(void) I2cBus::areAddressesValid(uint16_t ownAddress1, uint16_t ownAddress2, bool addressing7bit)
 {
     if(!checkAddressValidity(ownAddress1, addressing7bit))
-        throw I2cException("The provided I2C address 1 is not valid");
+        DRIVER_FAIL(DriverError::InvalidArgument, I2cException("The provided I2C address 1 is not valid"));
 
     // If ownAddress 2 is 0x00, single address is used.
     if(ownAddress2 == 0x00)
-        return;
+        return DRIVER_OK;
 
     if(!checkAddressValidity(ownAddress2, addressing7bit))
-        throw I2cException("The provided I2C address 2 is not valid");
+        DRIVER_FAIL(DriverError::InvalidArgument, I2cException("The provided I2C address 2 is not valid"));
+
+    return DRIVER_OK;
 }
 
 bool I2cBus::checkAddressValidity(uint16_t address, bool addressing7bit)
@@ -214,22 +375,41 @@ I2cBus::State I2cBus::getState()
     return state;
 }
 
+I2cBus::Statistics I2cBus::getStatistics()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Statistics snapshot = statistics;
+    __set_PRIMASK(primask);
+
+    return snapshot;
+}
+
+void I2cBus::resetStatistics()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    statistics = Statistics();
+    __set_PRIMASK(primask);
+}
+
 uint32_t I2cBus::getCurrentIndex()
 {
     return currentIndex;
 }
 
-void I2cBus::registerDriver(Selection bus)
+DRIVER_RESULT(void) I2cBus::registerDriver(Selection bus)
 {
     uint16_t i = getBusDriverNumber(bus);
 
     if(drivers[i] != nullptr)
-        throw I2cException("Bus already in use");
+        DRIVER_FAIL(DriverError::InUse, I2cException("Bus already in use"));
 
     drivers[i] = this;
+    return DRIVER_OK;
 }
 
-void I2cBus::initInstance()
+DRIVER_RESULT(void) I2cBus::initInstance()
 {
     instance = i2cBusHw(bus).instance;
 
@@ -251,7 +431,7 @@ void I2cBus::initInstance()
 
     auto initStatus = LL_I2C_Init(instance, &i2cInit);
     if(initStatus != SUCCESS)
-        throw I2cException("Error initializing I2C.");
+        DRIVER_FAIL(DriverError::Hardware, I2cException("Error initializing I2C."));
 
     // Dual address
     LL_I2C_SetOwnAddress2(instance, ownAddress2);
@@ -274,6 +454,8 @@ void I2cBus::initInstance()
 
     LL_I2C_Enable(instance);
     LL_I2C_AcknowledgeNextData(instance, LL_I2C_ACK);
+
+    return DRIVER_OK;
 }
 
 namespace
@@ -282,8 +464,12 @@ namespace
     // It doesn't need to be precise; slower is safe.
     inline void i2cBusDelay()
     {
-        for(volatile uint32_t i = 0; i < 200; i++)
+        volatile uint32_t i = 0;
+        while(i < 200)
+        {
             __NOP();
+            i = i + 1;
+        }
     }
 }
 
@@ -332,16 +518,22 @@ void I2cBus::resetBus()
 {
     // Full bus recovery WITHOUT an MCU reset. Used when the peripheral gets stuck
     // (BUSY/BERR latched) or a slave holds SDA.
+    statistics.busResets++;
+
     disableInterrupts();
+    stopDma();
     LL_I2C_Disable(instance);
 
     recoverBus();      // free the lines via bit-bang (SCL + STOP)
     initGpio();        // pins back to I2C alternate-function
-    initInstance();    // LL_I2C_DeInit (RCC reset, clears BUSY) + reconfigure + enable
+    // LL_I2C_DeInit (RCC reset, clears BUSY) + reconfigure + enable. Same config that
+    // already went through init(), so it can't fail here.
+    (void)initInstance();
     enableInterrupts();
 
     currentIndex = 0;
     currentTransaction = nullptr;
+    currentChainHead = nullptr;
     state = State::Idle;
 }
 
@@ -385,6 +577,12 @@ void I2cBus::enableInterrupts()
     NVIC_SetPriority(hw.erIrq, I2C_ERROR_IRQ_PRIORITY);
     NVIC_EnableIRQ(hw.evIrq);
     NVIC_EnableIRQ(hw.erIrq);
+
+    if(dmaMode)
+    {
+        NVIC_SetPriority(hw.dmaRxIrq, I2C_EVENT_IRQ_PRIORITY);
+        NVIC_EnableIRQ(hw.dmaRxIrq);
+    }
 }
 
 void I2cBus::disableInterrupts()
@@ -392,30 +590,49 @@ void I2cBus::disableInterrupts()
     const I2cBusHw& hw = i2cBusHw(bus);
     NVIC_DisableIRQ(hw.evIrq);
     NVIC_DisableIRQ(hw.erIrq);
+
+    if(dmaMode)
+        NVIC_DisableIRQ(hw.dmaRxIrq);
 }
 
-void I2cBus::attachDevice(I2cDevice& device)
+DRIVER_RESULT(void) I2cBus::attachDevice(I2cDevice& device)
 {
-    attachedDevices->add(&device);
+    return attachedDevices->add(&device);
 }
 
 void I2cBus::detachDevice(I2cDevice& device)
 {
-    int length = static_cast<int>(queue->size());
-    for(auto i = length - 1; i >= 0; i--)
+    // The queue and the in-flight transaction are also handled by the I2C and retry
+    // timer interrupts, as in cancel().
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint16_t address = device.getAddress();
+    queue->removeIf([](I2cTransaction* const& transaction, void* context)
     {
-        auto transaction = *queue->peek(i);
-        if(transaction->getAddress() == device.getAddress())
-        {
-            // If the transaction to remove is the current one, stop it.
-            if(i == 0 && state != State::Idle)
-                finishCurrentTransaction(false);
-            else
-                queue->dequeue(i);
-        }
+        if(transaction->getAddress() != *static_cast<uint16_t*>(context))
+            return false;
+
+        for(auto segment = transaction; segment; segment = segment->getNextSegment())
+            segment->setState(I2cTransaction::CANCELLED);
+        return true;
+    }, &address);
+
+    if(arbitrationLostTransaction && arbitrationLostTransaction->getAddress() == address)
+    {
+        for(auto segment = arbitrationLostTransaction; segment; segment = segment->getNextSegment())
+            segment->setState(I2cTransaction::CANCELLED);
+        arbitrationLostTransaction = nullptr;
     }
 
+    // If the current transaction belongs to the device, stop it with a STOP. Done after
+    // emptying the queue so the next transaction started isn't one of the device's.
+    if(currentTransaction && currentTransaction->getAddress() == address)
+        cancelCurrentTransaction();
+
     attachedDevices->remove(&device);
+
+    __set_PRIMASK(primask);
 }
 
 uint16_t I2cBus::getBusDriverNumber(Selection bus)
@@ -431,7 +648,10 @@ I2cBus::~I2cBus()
     disableInterrupts();
     LL_I2C_Disable(this->instance);
 
-    auto length = attachedDevices->getLength();
-    for(uint16_t i = 0; i < length; i++)
-        attachedDevices->pop()->detachBus();
+    if(timerWheel)
+        timerWheel->cancel(retryTimer);
+
+    for(I2cDevice* device : *attachedDevices)
+        device->detachBus();
+    attachedDevices->clear();
 }
\ No newline at end of file
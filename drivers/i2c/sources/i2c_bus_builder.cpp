@@ -73,13 +73,45 @@ I2cBus::Builder& I2cBus::Builder::withTimer(Timer& timer)
     return *this;
 }
 
+I2cBus::Builder& I2cBus::Builder::withTimerWheel(TimerWheel& timerWheel)
+{
+    config.timerWheel = &timerWheel;
+    return *this;
+}
+
 I2cBus::Builder& I2cBus::Builder::setRetryIntervalMs(uint16_t retryIntervalMs)
 {
-    config.retryIntervalMs = retryIntervalMs;
+    config.retryPolicy.initialDelayUs = retryIntervalMs * 1000;
+    config.retryPolicy.maxDelayUs = config.retryPolicy.initialDelayUs;
+    config.retryPolicy.multiplierPercent = 100;
+    return *this;
+}
+
+I2cBus::Builder& I2cBus::Builder::withRetryPolicy(const RetryPolicy& retryPolicy)
+{
+    config.retryPolicy = retryPolicy;
+    return *this;
+}
+
+I2cBus::Builder& I2cBus::Builder::withArbitrationRetries(uint8_t arbitrationRetries)
+{
+    config.arbitrationRetries = arbitrationRetries;
+    return *this;
+}
+
+I2cBus::Builder& I2cBus::Builder::enableDma()
+{
+    config.dma = true;
+    return *this;
+}
+
+I2cBus::Builder& I2cBus::Builder::withTimestampSource(uint32_t (*timestampSource)())
+{
+    config.timestampSource = timestampSource;
     return *this;
 }
 
-void I2cBus::Builder::buildIn(I2cBus& target)
+DRIVER_RESULT(void) I2cBus::Builder::buildIn(I2cBus& target)
 {
     return target.init(config);
 }
@@ -0,0 +1,289 @@
+#include "i2c_bus.hpp"
+#include "i2c_bus_hw.hpp"
+
+#include "stm32f4xx_ll_i2c.h"
+#include "stm32f4xx_ll_dma.h"
+
+#include "dma_streams.hpp"
+
+// ============================================================================
+// DMA data phase for master transfers and slave windows (see the DMA notes in
+// i2c_bus_master_events.cpp).
+//
+// The LL library only exposes per-stream flag functions (LL_DMA_IsActiveFlag_TC0 ...
+// TC7), so the stream flags are accessed through LISR/LIFCR (streams 0-3) and
+// HISR/HIFCR (streams 4-7) with the per-stream bit offset instead.
+//
+// Some of the streams are shared with timer requests (e.g. I2C3 TX and TIM3 CH1 on DMA1
+// stream 4), so each one is claimed through DmaStreams for the length of a transfer.
+// When the other driver holds it, the transfer takes the interrupt path, and stopDma()
+// only disables the streams this bus claimed.
+// ============================================================================
+
+namespace
+{
+    constexpr uint32_t DMA_FLAG_TE  = 1U << 3;
+    constexpr uint32_t DMA_FLAG_TC  = 1U << 5;
+    constexpr uint32_t DMA_FLAG_ALL = 0x3DU;   // FE, DME, TE, HT, TC
+
+    constexpr uint8_t streamFlagOffset[] = { 0, 6, 16, 22 };
+
+    inline bool isStreamFlagActive(DMA_TypeDef* dma, uint32_t stream, uint32_t flag)
+    {
+        uint32_t status = stream < 4 ? dma->LISR : dma->HISR;
+        return status & (flag << streamFlagOffset[stream % 4]);
+    }
+
+    inline void clearStreamFlags(DMA_TypeDef* dma, uint32_t stream)
+    {
+        uint32_t mask = DMA_FLAG_ALL << streamFlagOffset[stream % 4];
+        if(stream < 4)
+            dma->LIFCR = mask;
+        else
+            dma->HIFCR = mask;
+    }
+
+    inline void disableStream(DMA_TypeDef* dma, uint32_t stream)
+    {
+        LL_DMA_DisableStream(dma, stream);
+        // EN only reads back as 0 once the current beat has finished.
+        while(LL_DMA_IsEnabledStream(dma, stream));
+        clearStreamFlags(dma, stream);
+    }
+
+    void configureStream(DMA_TypeDef* dma, uint32_t stream, uint32_t channel, uint32_t direction,
+                         uintptr_t memoryAddress, uintptr_t peripheralAddress, uint16_t length)
+    {
+        disableStream(dma, stream);
+
+        LL_DMA_SetChannelSelection(dma, stream, channel);
+        LL_DMA_SetDataTransferDirection(dma, stream, direction);
+        LL_DMA_SetMode(dma, stream, LL_DMA_MODE_NORMAL);
+        LL_DMA_SetStreamPriorityLevel(dma, stream, LL_DMA_PRIORITY_HIGH);
+        LL_DMA_SetPeriphIncMode(dma, stream, LL_DMA_PERIPH_NOINCREMENT);
+        LL_DMA_SetMemoryIncMode(dma, stream, LL_DMA_MEMORY_INCREMENT);
+        LL_DMA_SetPeriphSize(dma, stream, LL_DMA_PDATAALIGN_BYTE);
+        LL_DMA_SetMemorySize(dma, stream, LL_DMA_MDATAALIGN_BYTE);
+
+        if(direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH)
+            LL_DMA_ConfigAddresses(dma, stream, memoryAddress, peripheralAddress, direction);
+        else
+            LL_DMA_ConfigAddresses(dma, stream, peripheralAddress, memoryAddress, direction);
+
+        LL_DMA_SetDataLength(dma, stream, length);
+    }
+}
+
+bool I2cBus::isDmaTransfer()
+{
+    return dmaMode && currentTransaction->getDataLengthBytes() >= 2;
+}
+
+bool I2cBus::startDmaTx()
+{
+    const I2cBusHw& hw = i2cBusHw(bus);
+    if(!DmaStreams::claim(hw.dma, hw.dmaTxStream))
+        return false;
+    dmaTxClaimed = true;
+
+    configureStream(hw.dma, hw.dmaTxStream, hw.dmaTxChannel, LL_DMA_DIRECTION_MEMORY_TO_PERIPH,
+                    reinterpret_cast<uintptr_t>(currentTransaction->getDataPointer()),
+                    LL_I2C_DMA_GetRegAddr(instance),
+                    currentTransaction->getDataLengthBytes());
+
+    // No stream interrupt: the end of the transfer is seen as BTF on the EV interrupt.
+    LL_DMA_EnableStream(hw.dma, hw.dmaTxStream);
+    LL_I2C_EnableDMAReq_TX(instance);
+    return true;
+}
+
+bool I2cBus::startDmaRx()
+{
+    const I2cBusHw& hw = i2cBusHw(bus);
+    if(!DmaStreams::claim(hw.dma, hw.dmaRxStream))
+        return false;
+    dmaRxClaimed = true;
+
+    configureStream(hw.dma, hw.dmaRxStream, hw.dmaRxChannel, LL_DMA_DIRECTION_PERIPH_TO_MEMORY,
+                    reinterpret_cast<uintptr_t>(currentTransaction->getDataPointer()),
+                    LL_I2C_DMA_GetRegAddr(instance),
+                    currentTransaction->getDataLengthBytes());
+
+    LL_DMA_EnableIT_TC(hw.dma, hw.dmaRxStream);
+    LL_DMA_EnableIT_TE(hw.dma, hw.dmaRxStream);
+    LL_DMA_EnableStream(hw.dma, hw.dmaRxStream);
+
+    // ACK every byte but the last one, which the peripheral NACKs by itself with LAST set.
+    LL_I2C_AcknowledgeNextData(instance, LL_I2C_ACK);
+    LL_I2C_EnableLastDMA(instance);
+    LL_I2C_EnableDMAReq_RX(instance);
+    return true;
+}
+
+void I2cBus::stopDma()
+{
+    if(!dmaMode)
+        return;
+
+    const I2cBusHw& hw = i2cBusHw(bus);
+
+    LL_I2C_DisableDMAReq_TX(instance);
+    LL_I2C_DisableDMAReq_RX(instance);
+    LL_I2C_DisableLastDMA(instance);
+
+    if(dmaTxClaimed)
+    {
+        disableStream(hw.dma, hw.dmaTxStream);
+        DmaStreams::release(hw.dma, hw.dmaTxStream);
+        dmaTxClaimed = false;
+    }
+    if(dmaRxClaimed)
+    {
+        disableStream(hw.dma, hw.dmaRxStream);
+        DmaStreams::release(hw.dma, hw.dmaRxStream);
+        dmaRxClaimed = false;
+    }
+    slaveDmaLength = 0;
+}
+
+bool I2cBus::startSlaveDma(bool transmit)
+{
+    uint16_t length = transmit ? slave->txWindowLength : slave->rxWindowLength;
+    if(!dmaMode || length < 2)
+        return false;
+
+    const I2cBusHw& hw = i2cBusHw(bus);
+
+    // Stream held by another peripheral: per-byte mode.
+    if(!DmaStreams::claim(hw.dma, transmit ? hw.dmaTxStream : hw.dmaRxStream))
+        return false;
+    (transmit ? dmaTxClaimed : dmaRxClaimed) = true;
+
+    LL_I2C_DisableIT_BUF(instance);
+
+    if(transmit)
+    {
+        configureStream(hw.dma, hw.dmaTxStream, hw.dmaTxChannel, LL_DMA_DIRECTION_MEMORY_TO_PERIPH,
+                        reinterpret_cast<uintptr_t>(slave->txWindow),
+                        LL_I2C_DMA_GetRegAddr(instance), length);
+
+        LL_DMA_EnableStream(hw.dma, hw.dmaTxStream);
+        LL_I2C_EnableDMAReq_TX(instance);
+    }
+    else
+    {
+        configureStream(hw.dma, hw.dmaRxStream, hw.dmaRxChannel, LL_DMA_DIRECTION_PERIPH_TO_MEMORY,
+                        reinterpret_cast<uintptr_t>(slave->rxWindow),
+                        LL_I2C_DMA_GetRegAddr(instance), length);
+
+        LL_DMA_EnableIT_TC(hw.dma, hw.dmaRxStream);
+        LL_DMA_EnableIT_TE(hw.dma, hw.dmaRxStream);
+        LL_DMA_EnableStream(hw.dma, hw.dmaRxStream);
+        LL_I2C_EnableDMAReq_RX(instance);
+    }
+
+    slaveDmaLength = length;
+    slaveDmaTx = transmit;
+    return true;
+}
+
+void I2cBus::stopSlaveDma()
+{
+    if(!slaveDmaLength)
+        return;
+
+    const I2cBusHw& hw = i2cBusHw(bus);
+    uint32_t stream = slaveDmaTx ? hw.dmaTxStream : hw.dmaRxStream;
+
+    LL_I2C_DisableDMAReq_TX(instance);
+    LL_I2C_DisableDMAReq_RX(instance);
+    disableStream(hw.dma, stream);
+
+    // NDTR keeps the count of bytes not moved once the stream is disabled.
+    uint16_t moved = slaveDmaLength - LL_DMA_GetDataLength(hw.dma, stream);
+    slaveDmaLength = 0;
+
+    DmaStreams::release(hw.dma, stream);
+    (slaveDmaTx ? dmaTxClaimed : dmaRxClaimed) = false;
+
+    if(slaveDmaTx)
+    {
+        slave->txWindow += moved;
+        slave->txWindowLength -= moved;
+    }
+    else
+    {
+        slave->rxWindow += moved;
+        slave->rxWindowLength -= moved;
+        slave->receivedLength += moved;
+    }
+}
+
+void I2cBus::continueSlaveReceive()
+{
+    stopSlaveDma();
+
+    if(!slave->rxWindowLength)
+        slave->onRxWindowFull();
+
+    if(!startSlaveDma(false))
+        LL_I2C_EnableIT_BUF(instance);
+}
+
+void I2cBus::masterStateSendDataDma()
+{
+    if(!LL_I2C_IsActiveFlag_BTF(instance))
+        return;
+
+    // BTF can also show up mid-transfer if the DMA request is delayed by another master
+    // on the AHB. It clears as soon as the stream writes DR, so just wait for the next one.
+    const I2cBusHw& hw = i2cBusHw(bus);
+    if(LL_DMA_GetDataLength(hw.dma, hw.dmaTxStream) != 0)
+        return;
+
+    stopDma();
+    issueEndCondition();
+    finishCurrentTransaction(true);
+}
+
+void I2cBus::dmaRxCallback()
+{
+    // The stream (and its flags) belongs to another driver right now.
+    if(!dmaRxClaimed)
+        return;
+
+    const I2cBusHw& hw = i2cBusHw(bus);
+
+    bool transferComplete = isStreamFlagActive(hw.dma, hw.dmaRxStream, DMA_FLAG_TC);
+    bool transferError    = isStreamFlagActive(hw.dma, hw.dmaRxStream, DMA_FLAG_TE);
+    clearStreamFlags(hw.dma, hw.dmaRxStream);
+
+    // Slave window filled (or a stream error): the rest goes to the next window or
+    // through RXNE.
+    if(state == State::SlaveReceive && !slaveDmaTx && slaveDmaLength)
+    {
+        if(transferComplete || transferError)
+            continueSlaveReceive();
+        return;
+    }
+
+    if(state != State::ReceiveDataDma)
+        return;
+
+    if(transferError)
+    {
+        abortCurrentTransaction();
+        sendNextTransaction();
+        return;
+    }
+
+    if(!transferComplete)
+        return;
+
+    // The last byte was already NACKed by the peripheral (LAST), the STOP (or the
+    // repeated START of a chain) must be requested from here (RM0368, I2C master
+    // receiver with DMA).
+    issueEndCondition();
+    stopDma();
+    finishCurrentTransaction(true);
+}
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "i2c_bus.hpp"
 
+#include "i2c_bus_hw.hpp"
+
 #include "stm32f4xx_ll_i2c.h"
+#include "stm32f4xx_ll_dma.h"
 
 #define READ false
 #define WRITE true
@@ -17,6 +20,10 @@
 //   Register read:  START addr+W  reg  REPEATED-START addr+R  data...  STOP
 //   Register write: START addr+W  reg  data...                  STOP
 //
+// Chained transactions (I2cTransaction::Builder::chainWith) replace the STOP of every
+// segment but the last one with a REPEATED-START and go straight back to StartAttempt
+// with the next segment, without releasing the bus or going through Idle.
+//
 // Key I2Cv1 flags and the timing rules the FSM relies on:
 //   SB    - Start Bit sent -> send the slave address now.
 //   ADDR  - address ACKed  -> clear it (read SR1 then SR2) to proceed.
@@ -33,6 +40,16 @@
 // set before reading so the last byte is NACKed and a STOP is issued. See
 // prepareMasterRx().
 //
+// DMA mode (Config::dma): for transfers of 2+ bytes the payload is moved by DMA and
+// the FSM only sees SB, ADDR and the end of the transfer. BUF IT stays disabled.
+//   TX: SendDataDma waits for BTF with the stream drained, then issues the STOP.
+//   RX: I2C_CR2_LAST makes the peripheral NACK the last byte by itself; the STOP is
+//       issued from the DMA TC interrupt (dmaRxCallback()), see i2c_bus_dma.cpp.
+// As a slave, the I2cSlave windows of 2+ bytes are moved by DMA the same way, with BUF
+// IT disabled. What doesn't fit in the window falls back to the per-byte interrupts:
+//   TX: a drained stream shows up as BTF (the clock is stretched until DR is written).
+//   RX: the stream TC interrupt calls onRxWindowFull(), which may set a new window.
+//
 // STOP is a MASTER-only action: generating a STOP while addressed as a slave latches
 // the STOP bit and breaks the slave. So error handling must deal with the slave/idle
 // cases and return BEFORE the master recovery path (which issues a STOP to release the
@@ -60,7 +77,7 @@ void I2cBus::prepareMasterRx(uint8_t remainingBytes)
     if(remainingBytes == 1)
     {
         LL_I2C_AcknowledgeNextData(instance, LL_I2C_NACK);
-        LL_I2C_GenerateStopCondition(instance);
+        issueEndCondition();
     }
     else if(remainingBytes == 2)
     {
@@ -73,21 +90,172 @@ void I2cBus::prepareMasterRx(uint8_t remainingBytes)
     }
 }
 
+void I2cBus::issueEndCondition()
+{
+    if(currentTransaction->getNextSegment())
+        LL_I2C_GenerateStartCondition(instance);
+    else
+        LL_I2C_GenerateStopCondition(instance);
+}
+
 void I2cBus::finishCurrentTransaction(bool postCallback)
 {
     if(postCallback)
     {
+        statistics.transactionsCompleted++;
+        statistics.bytesTx += currentTransaction->getRegisterLengthBytes();
+        if(currentTransaction->isTx())
+            statistics.bytesTx += currentTransaction->getDataLengthBytes();
+        else
+            statistics.bytesRx += currentTransaction->getDataLengthBytes();
+
         currentTransaction->postCallback();
+
+        // The completed buffer goes to the readers, the next run fills another one.
+        if(currentTransaction->publisher && currentTransaction->isRx())
+            currentTransaction->data = currentTransaction->publisher->publish();
+
         currentTransaction->setState(I2cTransaction::FINISHED);
+
+        // Chained segment: the repeated START is already on its way (issueEndCondition),
+        // keep the bus and continue with the next segment.
+        auto next = currentTransaction->getNextSegment();
+        if(next)
+        {
+            currentTransaction = next;
+            currentTransaction->setState(I2cTransaction::STARTING);
+            state = State::StartAttempt;
+            return;
+        }
     }
-    queue->dequeue();
     currentTransaction = nullptr;
+    currentChainHead = nullptr;
     state = State::Idle;
     sendNextTransaction();
 }
 
+void I2cBus::abortCurrentTransaction()
+{
+    LL_I2C_DisableIT_BUF(instance);
+    stopDma();
+
+    statistics.transactionsFailed++;
+    currentTransaction->setState(I2cTransaction::ERROR);
+    currentTransaction->errorCallback();
+
+    // The rest of a chain is never run.
+    for(auto segment = currentTransaction->getNextSegment(); segment; segment = segment->getNextSegment())
+        segment->setState(I2cTransaction::ERROR);
+
+    currentTransaction = nullptr;
+    currentChainHead = nullptr;
+    state = State::Idle;
+
+    // Release the bus with a STOP (required after a NACK as master).
+    LL_I2C_GenerateStopCondition(instance);
+}
+
+bool I2cBus::cancel(I2cTransaction& transaction)
+{
+    // The queue and the in-flight transaction are also handled by the I2C and retry
+    // timer interrupts.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool cancelled = false;
+    if(arbitrationLostTransaction == &transaction)
+    {
+        arbitrationLostTransaction = nullptr;
+        cancelled = true;
+    }
+    else if(queue->remove(&transaction))
+    {
+        cancelled = true;
+    }
+    else
+    {
+        // Any segment of the chain in progress, including the ones already sent.
+        for(auto segment = currentChainHead; segment; segment = segment->getNextSegment())
+        {
+            if(segment == &transaction)
+            {
+                cancelCurrentTransaction();
+                __set_PRIMASK(primask);
+                return true;
+            }
+        }
+    }
+
+    if(cancelled)
+    {
+        for(auto segment = &transaction; segment; segment = segment->getNextSegment())
+            segment->setState(I2cTransaction::CANCELLED);
+    }
+
+    __set_PRIMASK(primask);
+    return cancelled;
+}
+
+void I2cBus::retryLostArbitration()
+{
+    LL_I2C_DisableIT_BUF(instance);
+    stopDma();
+    LL_I2C_DisableBitPOS(instance);
+    LL_I2C_AcknowledgeNextData(instance, LL_I2C_ACK);
+
+    statistics.arbitrationRetries++;
+    currentChainHead->arbitrationRetries++;
+
+    // The whole chain is sent again from its head: the other master may have changed the
+    // slave state the later segments rely on (e.g. the register pointer of a read).
+    for(auto segment = currentChainHead; segment; segment = segment->getNextSegment())
+        segment->setState(I2cTransaction::IDLE);
+
+    arbitrationLostTransaction = currentChainHead;
+    currentTransaction = nullptr;
+    currentChainHead = nullptr;
+    state = State::Idle;
+
+    // Most likely BUSY until the other master's STOP: waits on the retry timer, or for
+    // the STOP if this bus is the one being addressed.
+    sendNextTransaction();
+}
+
+void I2cBus::cancelCurrentTransaction()
+{
+    LL_I2C_DisableIT_BUF(instance);
+    stopDma();
+    // A read may be cancelled in its NACK/POS tail.
+    LL_I2C_DisableBitPOS(instance);
+    LL_I2C_AcknowledgeNextData(instance, LL_I2C_ACK);
+
+    for(auto segment = currentTransaction; segment; segment = segment->getNextSegment())
+        segment->setState(I2cTransaction::CANCELLED);
+
+    bool startPending = state == State::StartAttempt || state == State::RepeatedStart;
+
+    currentTransaction = nullptr;
+    currentChainHead = nullptr;
+    state = State::Idle;
+
+    // Only a (repeated) START on the wire: SB only clears by sending an address and would
+    // keep the event interrupt firing, so the peripheral is reset instead (recoverBus()
+    // releases the bus with a STOP). Otherwise, same as an abort: the STOP goes out after
+    // the byte on the wire.
+    if(startPending)
+        resetBus();
+    else
+        LL_I2C_GenerateStopCondition(instance);
+    sendNextTransaction();
+}
+
 void I2cBus::masterStateStartAttemp()
 {
+    // A read cancelled on the wire still receives the byte in flight before its STOP; it
+    // would be taken for the first byte of this transfer.
+    if(LL_I2C_IsActiveFlag_RXNE(instance))
+        LL_I2C_ReceiveData8(instance);
+
     bool readBit = currentTransaction->isRx() && !currentTransaction->hasRegister();
     bool sentAddress = sendSlaveAddress(readBit);
     if(sentAddress)
@@ -107,18 +275,34 @@ void I2cBus::masterStateSendSlaveAddress()
     }
     else if(currentTransaction->isTx())
     {
-        state = State::SendData;
         currentTransaction->setState(I2cTransaction::EXCHANGING_DATA);
+        // DMA must be armed before ADDR is cleared, TXE raises the first request.
+        if(isDmaTransfer() && startDmaTx())
+        {
+            state = State::SendDataDma;
+        }
+        else
+        {
+            state = State::SendData;
+        }
     }
     else
     {
-        prepareMasterRx(currentTransaction->getDataLengthBytes());
         currentTransaction->setState(I2cTransaction::EXCHANGING_DATA);
-        state = State::ReceiveData;
+        if(isDmaTransfer() && startDmaRx())
+        {
+            state = State::ReceiveDataDma;
+        }
+        else
+        {
+            prepareMasterRx(currentTransaction->getDataLengthBytes());
+            state = State::ReceiveData;
+        }
     }
 
     LL_I2C_ClearFlag_ADDR(instance);
-    LL_I2C_EnableIT_BUF(instance);
+    if(state != State::SendDataDma && state != State::ReceiveDataDma)
+        LL_I2C_EnableIT_BUF(instance);
     currentIndex = 0;
     return;
 }
@@ -128,7 +312,7 @@ void I2cBus::masterStateSendRegister()
     if(!LL_I2C_IsActiveFlag_TXE(instance))
         return;
 
-    LL_I2C_TransmitData8(instance, currentTransaction->getRegisterByte(currentIndex++));
+    LL_I2C_TransmitData8(instance, currentTransaction->registerByteAt(currentIndex++));
 
     if(currentIndex < currentTransaction->getRegisterLengthBytes())
         return;
@@ -143,7 +327,17 @@ void I2cBus::masterStateSendRegister()
     }
 
     if(currentTransaction->isTx())
-        state = State::SendData;
+    {
+        if(isDmaTransfer() && startDmaTx())
+        {
+            LL_I2C_DisableIT_BUF(instance);
+            state = State::SendDataDma;
+        }
+        else
+        {
+            state = State::SendData;
+        }
+    }
 
     currentIndex = 0;
 }
@@ -153,7 +347,7 @@ void I2cBus::masterStateSendData()
     if(!LL_I2C_IsActiveFlag_TXE(instance))
         return;
 
-    LL_I2C_TransmitData8(instance, currentTransaction->getByte(currentIndex++));
+    LL_I2C_TransmitData8(instance, currentTransaction->data[currentIndex++]);
 
     if(currentIndex >= currentTransaction->getDataLengthBytes())
     {
@@ -167,7 +361,7 @@ void I2cBus::masterStateSendLastDataByte()
     if(!LL_I2C_IsActiveFlag_BTF(instance))
         return;
 
-    LL_I2C_GenerateStopCondition(instance);
+    issueEndCondition();
     finishCurrentTransaction(true);
 }
 
@@ -193,10 +387,18 @@ void I2cBus::masterStateRepeatedStartAckAddr()
     if(!LL_I2C_IsActiveFlag_ADDR(instance))
         return;
 
+    currentIndex = 0;
+
+    if(isDmaTransfer() && startDmaRx())
+    {
+        LL_I2C_ClearFlag_ADDR(instance);
+        state = State::ReceiveDataDma;
+        return;
+    }
+
     prepareMasterRx(currentTransaction->getDataLengthBytes());
     LL_I2C_ClearFlag_ADDR(instance);
     LL_I2C_EnableIT_BUF(instance);
-    currentIndex = 0;
 
     state = State::ReceiveData;
 }
@@ -207,7 +409,7 @@ void I2cBus::masterStateReceiveData()
         return;
 
     uint8_t readByte = LL_I2C_ReceiveData8(instance);
-    currentTransaction->setByte(readByte, currentIndex++);
+    currentTransaction->data[currentIndex++] = readByte;
 
     uint8_t remainingBytes = currentTransaction->getDataLengthBytes() - currentIndex;
     prepareMasterRx(remainingBytes);
@@ -224,77 +426,65 @@ void I2cBus::eventSlaveCallback()
     {
         LL_I2C_ReadReg(instance, SR1);
         uint32_t sr2 = LL_I2C_ReadReg(instance, SR2);
-        if(sr2 & I2C_SR2_TRA)
+
+        // Repeated START: account for what the previous phase moved by DMA first.
+        stopSlaveDma();
+
+        bool transmit = sr2 & I2C_SR2_TRA;
+        if(transmit)
+        {
             state = State::SlaveTransmit;
+        }
         else
+        {
             state = State::SlaveReceive;
+            slave->receivedLength = 0;
+        }
 
+        slave->onAddressMatch(transmit ? I2cSlave::Direction::TX : I2cSlave::Direction::RX);
+
+        if(!startSlaveDma(transmit))
+            LL_I2C_EnableIT_BUF(instance);
+    }
+
+    if(state == State::SlaveTransmit && slaveDmaLength && LL_I2C_IsActiveFlag_BTF(instance))
+    {
+        // Only once the window is drained, as in masterStateSendDataDma().
+        if(LL_DMA_GetDataLength(i2cBusHw(bus).dma, i2cBusHw(bus).dmaTxStream) != 0)
+            return;
+
+        stopSlaveDma();
         LL_I2C_EnableIT_BUF(instance);
-        slave->onAddressMatch(sr2 & I2C_SR2_TRA ? I2cSlave::Direction::TX : I2cSlave::Direction::RX);
     }
 
-    if(state == State::SlaveTransmit && LL_I2C_IsActiveFlag_TXE(instance))
-        LL_I2C_TransmitData8(instance, slave->onReadByte());
+    if(state == State::SlaveTransmit && !slaveDmaLength && LL_I2C_IsActiveFlag_TXE(instance))
+        LL_I2C_TransmitData8(instance, slave->nextTxByte());
 
-    while(state == State::SlaveReceive && LL_I2C_IsActiveFlag_RXNE(instance))
-        slave->onWriteByte(LL_I2C_ReceiveData8(instance));
+    while(state == State::SlaveReceive && !slaveDmaLength && LL_I2C_IsActiveFlag_RXNE(instance))
+    {
+        slave->pushRxByte(LL_I2C_ReceiveData8(instance));
+
+        // A window set from onRxWindowFull() may be long enough for DMA.
+        if(slave->rxWindowLength >= 2 && startSlaveDma(false))
+            break;
+    }
 
     if(LL_I2C_IsActiveFlag_STOP(instance))
     {
         LL_I2C_ClearFlag_STOP(instance);
         LL_I2C_DisableIT_BUF(instance);
+        stopSlaveDma();
         slave->onEndTransaction();
         state = State::Idle;
+
+        // The bus is free again: run what waited for it (e.g. after losing arbitration).
+        sendNextTransaction();
     }
 }
 
-void I2cBus::eventMasterCallback()
+void I2cBus::masterStateReceiveDataDma()
 {
-    switch(state)
-    {
-        case State::Idle:
-            // Slave behaviour only
-            break;
-
-        case State::StartAttempt:
-            masterStateStartAttemp();
-            break;
-
-        case State::SendSlaveAddress:
-            masterStateSendSlaveAddress();
-            break;
-
-        case State::SendRegister:
-            masterStateSendRegister();
-            break;
-
-        case State::SendData:
-            masterStateSendData();
-            break;
-
-        case State::SendLastDataByte:
-            masterStateSendLastDataByte();
-            break;
-
-        case State::LastRegisterByte:
-            masterStateSendLastRegisterByte();
-            break;
-
-        case State::RepeatedStart:
-            masterStateRepeatedStart();
-            break;
-
-        case State::RepeatedStartAckAddr:
-            masterStateRepeatedStartAckAddr();
-            break;
-
-        case State::ReceiveData:
-            masterStateReceiveData();
-            break;
-
-        default:
-            break;
-    }
+    // Driven by the DMA TC interrupt (dmaRxCallback).
 }
 
 void I2cBus::errorCallback()
@@ -310,6 +500,11 @@ void I2cBus::errorCallback()
     if(berr) LL_I2C_ClearFlag_BERR(instance);
     if(ovr) { LL_I2C_ReceiveData8(instance); LL_I2C_ClearFlag_OVR(instance); }
 
+    statistics.acknowledgeFailures += af;
+    statistics.arbitrationLosses += arlo;
+    statistics.busErrors += berr;
+    statistics.overruns += ovr;
+
     // Handle slave-side and idle errors first, then return: the master recovery below
     // issues a STOP, which is master-only (see file header).
 
@@ -317,6 +512,7 @@ void I2cBus::errorCallback()
     if(state == State::SlaveTransmit || state == State::SlaveReceive)
     {
         LL_I2C_DisableIT_BUF(instance);
+        stopSlaveDma();
 
         // AF during SlaveTransmit is the NORMAL end: the master NACKs the last byte.
         if(af && state == State::SlaveTransmit)
@@ -343,18 +539,14 @@ void I2cBus::errorCallback()
         return;
     }
 
-    // Master-side error with a transaction in progress
-    LL_I2C_DisableIT_BUF(instance);
-
-    currentTransaction->setState(I2cTransaction::ERROR);
-    currentTransaction->errorCallback();
-    if(queue && queue->hasData())
-        queue->dequeue();
-    currentTransaction = nullptr;
-    state = State::Idle;
+    if(arlo && !berr && currentChainHead->arbitrationRetries < maxArbitrationRetries)
+    {
+        retryLostArbitration();
+        return;
+    }
 
-    // Release the bus with a STOP (required after a NACK as master).
-    LL_I2C_GenerateStopCondition(instance);
+    // Master-side error with a transaction in progress
+    abortCurrentTransaction();
 
     // Full recovery (no MCU reset) ONLY on a real bus error.
     if(berr)
@@ -4,7 +4,15 @@
 I2cDevice::I2cDevice(uint16_t address, I2cBus* bus, std::string name)
     : address(address), bus(bus), name(name)
 {
+    if(!bus)
+        return;
+
+#ifdef DRIVERS_NO_EXCEPTIONS
+    if(!bus->attachDevice(*this))
+        this->bus = nullptr;
+#else
     bus->attachDevice(*this);
+#endif
 }
 
 I2cDevice::~I2cDevice()
@@ -18,12 +26,13 @@ uint16_t I2cDevice::getAddress()
     return address;
 }
 
-void I2cDevice::attachBus(I2cBus* bus)
+DRIVER_RESULT(void) I2cDevice::attachBus(I2cBus* bus)
 {
     if(this->bus != nullptr)
-        throw I2cException("Device already attached to a bus");
+        DRIVER_FAIL(DriverError::InUse, I2cException("Device already attached to a bus"));
 
     this->bus = bus;
+    return DRIVER_OK;
 }
 
 void I2cDevice::detachBus()
@@ -31,14 +40,29 @@ void I2cDevice::detachBus()
     this->bus = nullptr;
 }
 
-void I2cDevice::setTransaction(I2cTransaction& transaction)
+DRIVER_RESULT(void) I2cDevice::setTransaction(I2cTransaction& transaction)
 {
-    bus->setTransaction(transaction);
+    if(!bus)
+        DRIVER_FAIL(DriverError::InvalidArgument, I2cException("Device not attached to a bus"));
+
+    return bus->setTransaction(transaction);
+}
+
+bool I2cDevice::cancel(I2cTransaction& transaction)
+{
+    if(!bus)
+        return false;
+
+    return bus->cancel(transaction);
 }
 
 I2cDevice& I2cDevice::operator<<(I2cTransaction& transaction)
 {
-    transaction.device = this;
-    bus->setTransaction(transaction);
+    // The whole chain goes to this device, even if it was sent through another one before.
+    for(auto segment = &transaction; segment; segment = segment->nextSegment)
+        segment->device = this;
+
+    // Without exceptions a rejected transaction is left in the ERROR state.
+    (void)setTransaction(transaction);
     return *this;
 }
\ No newline at end of file
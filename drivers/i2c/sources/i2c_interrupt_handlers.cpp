@@ -5,30 +5,48 @@
  */
 extern "C" void I2C1_EV_IRQHandler()
 {
-    I2cBus::handleInterrupt(I2cBus::Selection::Bus1, I2cBus::InterruptType::Event);
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus1, I2cBus::InterruptType::Event>();
 }
 
 extern "C" void I2C2_EV_IRQHandler()
 {
-    I2cBus::handleInterrupt(I2cBus::Selection::Bus2, I2cBus::InterruptType::Event);
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus2, I2cBus::InterruptType::Event>();
 }
 
 extern "C" void I2C3_EV_IRQHandler()
 {
-    I2cBus::handleInterrupt(I2cBus::Selection::Bus3, I2cBus::InterruptType::Event);
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus3, I2cBus::InterruptType::Event>();
 }
 
 extern "C" void I2C1_ER_IRQHandler()
 {
-    I2cBus::handleInterrupt(I2cBus::Selection::Bus1, I2cBus::InterruptType::Error);
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus1, I2cBus::InterruptType::Error>();
 }
 
 extern "C" void I2C2_ER_IRQHandler()
 {
-    I2cBus::handleInterrupt(I2cBus::Selection::Bus2, I2cBus::InterruptType::Error);
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus2, I2cBus::InterruptType::Error>();
 }
 
 extern "C" void I2C3_ER_IRQHandler()
 {
-    I2cBus::handleInterrupt(I2cBus::Selection::Bus3, I2cBus::InterruptType::Error);
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus3, I2cBus::InterruptType::Error>();
+}
+
+/*
+ *  DMA RX stream handlers (see i2c_bus_hw.hpp). Only used by buses in DMA mode.
+ */
+extern "C" void DMA1_Stream0_IRQHandler()
+{
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus1, I2cBus::InterruptType::DmaRx>();
+}
+
+extern "C" void DMA1_Stream3_IRQHandler()
+{
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus2, I2cBus::InterruptType::DmaRx>();
+}
+
+extern "C" void DMA1_Stream2_IRQHandler()
+{
+    I2cBus::handleInterrupt<I2cBus::Selection::Bus3, I2cBus::InterruptType::DmaRx>();
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "i2c_poller.hpp"
+
+#include <string.h>
+
+#include "stm32f4xx.h"
+
+I2cPoll::I2cPoll(I2cDevice& device, uint32_t deviceRegister, uint8_t* buffers, uint16_t length,
+                 uint32_t periodTicks, uint32_t phaseTicks, uint8_t registerLength)
+    : device(device), buffers(buffers), length(length), period(periodTicks ? periodTicks : 1), phase(phaseTicks)
+{
+    I2cTransaction::Builder builder{};
+    transaction = builder.setDirection(I2cTransaction::RX)
+                         .withData(buffers, length)
+                         .withRegister(deviceRegister, registerLength)
+                         .withPostCallback(onFinished, this)
+                         .withErrorCallback(onFailed, this)
+                         .build();
+}
+
+bool I2cPoll::read(uint8_t* data)
+{
+    // The published buffer is only written again once the next read is submitted, from
+    // the timer interrupt, so masking interrupts is enough even with DMA.
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool available = samples != 0;
+    if(available)
+        memcpy(data, buffers + front * length, length);
+    __set_PRIMASK(primask);
+
+    return available;
+}
+
+uint32_t I2cPoll::getSampleCount()
+{
+    return samples;
+}
+
+uint32_t I2cPoll::getSkippedCount()
+{
+    return skipped;
+}
+
+uint32_t I2cPoll::getErrorCount()
+{
+    return errors;
+}
+
+void I2cPoll::submit()
+{
+    // Into the buffer that isn't published.
+    transaction.data = buffers + (front ^ 1) * length;
+    transaction.setState(I2cTransaction::IDLE);
+    pending = true;
+
+#ifdef DRIVERS_NO_EXCEPTIONS
+    device << transaction;
+    if(transaction.getState() == I2cTransaction::ERROR)
+    {
+        pending = false;
+        errors++;
+    }
+#else
+    // Runs in the timer interrupt: a full queue only costs this sample.
+    try
+    {
+        device << transaction;
+    }
+    catch(...)
+    {
+        pending = false;
+        errors++;
+    }
+#endif
+}
+
+void I2cPoll::onFinished(void* parameters)
+{
+    I2cPoll* poll = static_cast<I2cPoll*>(parameters);
+    poll->front = poll->front ^ 1;
+    poll->samples = poll->samples + 1;
+    poll->pending = false;
+}
+
+void I2cPoll::onFailed(void* parameters)
+{
+    I2cPoll* poll = static_cast<I2cPoll*>(parameters);
+    poll->errors++;
+    poll->pending = false;
+}
+
+I2cPoller::I2cPoller(Timer& timer)
+{
+    init(timer);
+}
+
+void I2cPoller::init(Timer& timer)
+{
+    this->timer = &timer;
+    timer.setCallback(tickCallback, this);
+}
+
+void I2cPoller::start()
+{
+    timer->start();
+}
+
+void I2cPoller::pause()
+{
+    timer->pause();
+}
+
+void I2cPoller::add(I2cPoll& poll)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    poll.due = now + (poll.phase ? poll.phase : 1);
+    poll.next = first;
+    first = &poll;
+
+    __set_PRIMASK(primask);
+}
+
+void I2cPoller::remove(I2cPoll& poll)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for(I2cPoll** link = &first; *link; link = &(*link)->next)
+    {
+        if(*link == &poll)
+        {
+            *link = poll.next;
+            poll.next = nullptr;
+            break;
+        }
+    }
+
+    if(poll.pending)
+    {
+        poll.device.cancel(poll.transaction);
+        poll.pending = false;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+uint32_t I2cPoller::getTicks()
+{
+    return now;
+}
+
+void I2cPoller::tickCallback(void* argument)
+{
+    I2cPoller* poller = static_cast<I2cPoller*>(argument);
+    uint32_t now = poller->now + 1;
+    poller->now = now;
+
+    for(I2cPoll* poll = poller->first; poll; poll = poll->next)
+    {
+        if(static_cast<int32_t>(now - poll->due) < 0)
+            continue;
+
+        // Fell behind (e.g. the timer was paused): fire once and realign from now on,
+        // instead of catching up with a burst.
+        poll->due += poll->period;
+        if(static_cast<int32_t>(now - poll->due) >= 0)
+            poll->due = now + poll->period;
+
+        if(poll->pending)
+        {
+            poll->skipped++;
+            continue;
+        }
+
+        poll->submit();
+    }
+}
\ No newline at end of file
@@ -25,18 +25,19 @@ uint16_t I2cTransaction::getAddress()
     return device->getAddress();
 }
 
-uint8_t I2cTransaction::getByte(uint16_t index)
+DRIVER_RESULT(uint8_t) I2cTransaction::getByte(uint16_t index)
 {
     if(index >= this->dataBytes)
-        throw I2cException("No more data in transaction");
+        DRIVER_FAIL(DriverError::OutOfRange, I2cException("No more data in transaction"));
     return data[index];
 }
 
-void I2cTransaction::setByte(uint8_t byte, uint16_t index)
+DRIVER_RESULT(void) I2cTransaction::setByte(uint8_t byte, uint16_t index)
 {
     if(index >= this->dataBytes)
-        throw I2cException("Out of bounds");
+        DRIVER_FAIL(DriverError::OutOfRange, I2cException("Out of bounds"));
     data[index] = byte;
+    return DRIVER_OK;
 }
 
 uint8_t* I2cTransaction::getDataPointer()
@@ -59,13 +60,17 @@ bool I2cTransaction::hasRegister()
     return deviceRegisterBytes > 0;
 }
 
-uint8_t I2cTransaction::getRegisterByte(uint8_t index)
+DRIVER_RESULT(uint8_t) I2cTransaction::getRegisterByte(uint8_t index)
 {
-    uint8_t registerLengthBytes = getRegisterLengthBytes();
-    if (index >= registerLengthBytes)
-        throw std::out_of_range("Index out of register length");
+    if (index >= getRegisterLengthBytes())
+        DRIVER_FAIL(DriverError::OutOfRange, std::out_of_range("Index out of register length"));
 
-    uint8_t shift = 8 * (registerLengthBytes - index - 1);
+    return registerByteAt(index);
+}
+
+uint8_t I2cTransaction::registerByteAt(uint8_t index) const noexcept
+{
+    uint8_t shift = 8 * (deviceRegisterBytes - index - 1);
     return static_cast<uint8_t>((deviceRegister >> shift) & 0xFF);
 }
 
@@ -84,6 +89,37 @@ I2cTransaction::State I2cTransaction::getState()
     return state;
 }
 
+uint8_t I2cTransaction::getPriority()
+{
+    return priority;
+}
+
+bool I2cTransaction::hasDeadline()
+{
+    return deadlineSet;
+}
+
+uint32_t I2cTransaction::getDeadline()
+{
+    return deadline;
+}
+
+I2cTransaction* I2cTransaction::getNextSegment()
+{
+    return nextSegment;
+}
+
+bool I2cTransaction::PriorityOrder::operator()(I2cTransaction* a, I2cTransaction* b) const
+{
+    if(a->priority != b->priority)
+        return a->priority > b->priority;
+
+    if(a->deadlineSet != b->deadlineSet)
+        return a->deadlineSet;
+
+    return a->deadlineSet && static_cast<int32_t>(a->deadline - b->deadline) < 0;
+}
+
 bool I2cTransaction::isTx()
 {
     return direction == TX;
@@ -107,6 +143,14 @@ I2cTransaction::Builder& I2cTransaction::Builder::withData(uint8_t* data, uint16
     return *this;
 }
 
+I2cTransaction::Builder& I2cTransaction::Builder::publishTo(BufferPublisher& publisher)
+{
+    transaction.publisher = &publisher;
+    transaction.data = publisher.writeBuffer();
+    transaction.dataBytes = publisher.bufferSize();
+    return *this;
+}
+
 I2cTransaction::Builder& I2cTransaction::Builder::withRegister(uint32_t deviceRegister, uint8_t length)
 {
     transaction.deviceRegister = deviceRegister;
@@ -114,27 +158,46 @@ I2cTransaction::Builder& I2cTransaction::Builder::withRegister(uint32_t deviceRe
     return *this;
 }
 
-I2cTransaction::Builder& I2cTransaction::Builder::withPreCallback(std::function<void(void*)> function, void* parameters)
+I2cTransaction::Builder& I2cTransaction::Builder::withPreCallback(Callback function, void* parameters)
 {
     transaction.preCallbackParameters = parameters;
     transaction.preCallbackFunction = function;
     return *this;
 }
 
-I2cTransaction::Builder& I2cTransaction::Builder::withPostCallback(std::function<void(void*)> function, void* parameters)
+I2cTransaction::Builder& I2cTransaction::Builder::withPostCallback(Callback function, void* parameters)
 {
     transaction.postCallbackParameters = parameters;
     transaction.postCallbackFunction = function;
     return *this;
 }
 
-I2cTransaction::Builder& I2cTransaction::Builder::withErrorCallback(std::function<void(void*)> function, void* parameters)
+I2cTransaction::Builder& I2cTransaction::Builder::withErrorCallback(Callback function, void* parameters)
 {
     transaction.errorCallbackParameters = parameters;
     transaction.errorCallbackFunction = function;
     return *this;
 }
 
+I2cTransaction::Builder& I2cTransaction::Builder::withPriority(uint8_t priority)
+{
+    transaction.priority = priority;
+    return *this;
+}
+
+I2cTransaction::Builder& I2cTransaction::Builder::withDeadline(uint32_t deadline)
+{
+    transaction.deadlineSet = true;
+    transaction.deadline = deadline;
+    return *this;
+}
+
+I2cTransaction::Builder& I2cTransaction::Builder::chainWith(I2cTransaction& next)
+{
+    transaction.nextSegment = &next;
+    return *this;
+}
+
 I2cTransaction I2cTransaction::Builder::build()
 {
     return transaction;
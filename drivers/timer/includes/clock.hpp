@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "timer.hpp"
+
+/*
+ *  @brief Monotonic 64 bit timebase: a free-running Timer extended with an overflow
+ *  count. Use a 32 bit timer (TIM2/TIM5) so it only interrupts once every 2^32 ticks; a
+ *  16 bit one works too, overflowing every 2^16 ticks.
+ *
+ *  The timer is owned by the clock (its callback and alarm are taken over). Its
+ *  prescaler sets the tick. getTicks() is lock-free and can be called from any context,
+ *  including ISRs, as long as none has a higher priority than the timer interrupt (see
+ *  clock.cpp).
+ */
+class Clock
+{
+    public:
+        Clock() = default;
+        Clock(Timer& timer);
+
+        void init(Timer& timer);
+
+        uint64_t getTicks();
+
+        uint64_t getNanoseconds();
+
+        uint64_t getMicroseconds();
+
+        // Tick rate, exact (Timer::getPeriodUs() is truncated to whole microseconds).
+        uint32_t getFrequency();
+
+        uint64_t ticksToNanoseconds(uint64_t ticks);
+        uint64_t ticksToMicroseconds(uint64_t ticks);
+        uint64_t nanosecondsToTicks(uint64_t nanoseconds);
+        uint64_t microsecondsToTicks(uint64_t microseconds);
+
+    protected:
+        Timer* timer = nullptr;
+        uint32_t frequency = 1;
+        uint32_t maxCount = 0;
+        uint8_t countBits = 0;
+
+        std::atomic<uint32_t> overflows = 0;
+
+        static void overflowCallback(void* argument);
+
+        static uint64_t scale(uint64_t value, uint32_t multiplier, uint32_t divisor);
+};
\ No newline at end of file
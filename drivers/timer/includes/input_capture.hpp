@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "timer.hpp"
+#include "driver_result.hpp"
+
+/*
+ *  @brief Input capture on one channel of a Timer: every selected edge latches the
+ *  counter, and the timestamps are collected in a ring buffer, by DMA when the channel
+ *  has a free DMA stream (no interrupt per edge) or by the capture interrupt otherwise.
+ *  measure() then turns everything captured since the last call into a mean period,
+ *  frequency and duty cycle.
+ *
+ *  The timer must count over its full range (ARR at its maximum), so timestamp
+ *  differences are wrap-safe: it's started that way if it isn't running, and it can be
+ *  shared with a Clock. The channel pin must be configured as its timer alternate
+ *  function by the application.
+ */
+class InputCapture
+{
+    public:
+        struct Config;
+
+        enum class Channel : uint8_t
+        {
+            Ch1,
+            Ch2,
+            Ch3,
+            Ch4
+        };
+
+        enum class Edge : uint8_t
+        {
+            Rising,
+            Falling,
+            Both
+        };
+
+        /*
+         *  @brief Means over a batch of captures, in timer ticks. highTicks and
+         *  dutyPermille are only measured with Edge::Both.
+         */
+        struct Measurement
+        {
+            uint32_t periodTicks = 0;
+            uint32_t highTicks = 0;
+            uint32_t frequencyMilliHz = 0;
+            uint16_t dutyPermille = 0;
+            uint16_t periods = 0;
+        };
+
+        InputCapture() = default;
+
+        /*
+         *  @brief Without exceptions the init status is lost, use init() to get it.
+         */
+        InputCapture(Timer& timer, const Config& config);
+
+        DRIVER_RESULT(void) init(Timer& timer, const Config& config);
+
+        void start();
+        void stop();
+
+        bool isDmaFed();
+
+        // Captures not read yet.
+        uint16_t available();
+
+        /*
+         *  @brief Copies up to `maxCount` raw timestamps, oldest first.
+         *
+         *  @return Number of timestamps copied.
+         */
+        uint16_t read(uint32_t* timestamps, uint16_t maxCount);
+
+        /*
+         *  @brief Consumes every capture available and measures over them. The last one
+         *  is kept as the start of the next batch.
+         *
+         *  @return false if there weren't enough edges for a whole period.
+         */
+        bool measure(Measurement& measurement);
+
+        /*
+         *  @brief Captures lost: ring buffer full (interrupt mode) or edges faster than
+         *  the capture path (CCxOF).
+         */
+        uint32_t getOverruns();
+
+    protected:
+        Timer* timer = nullptr;
+        TIM_TypeDef* registers = nullptr;
+        uint8_t channel = 0;
+        Edge edge = Edge::Rising;
+        uint8_t prescaler = 0;
+        bool startsHigh = false;
+
+        uint32_t* buffer = nullptr;
+        uint16_t length = 0;
+        volatile uint16_t head = 0;     // Interrupt mode write index
+        uint16_t tail = 0;
+
+        // DMA stream fed by the channel request, if any.
+        DMA_TypeDef* dma = nullptr;
+        uint32_t stream = 0;
+        uint32_t dmaChannel = 0;
+        bool dmaFed = false;
+        bool streamClaimed = false;     // Held from start() to stop(), see DmaStreams
+
+        // Last capture of the previous batch, and whether it's a rising edge (Edge::Both).
+        bool hasReference = false;
+        uint32_t reference = 0;
+        bool referenceRising = true;
+
+        volatile uint32_t overruns = 0;
+
+        volatile uint32_t* captureRegister();
+        uint16_t writeIndex();
+        uint32_t interval(uint32_t from, uint32_t to);
+
+        // Interrupt path (Timer::handleInterrupt()), never throws.
+        void onCapture() noexcept;
+
+    friend class Timer;
+};
+
+struct InputCapture::Config
+{
+    Channel channel = Channel::Ch1;
+    Edge edge = Edge::Rising;
+
+    // Captures every 1, 2, 4 or 8 edges (ICxPSC 0-3). Only with Rising or Falling.
+    uint8_t prescaler = 0;
+
+    // Digital filter ICxF (0-15): samples needed to validate an edge.
+    uint8_t filter = 0;
+
+    // Ring buffer of timestamps: read or measure() at least once per `length` captures.
+    uint32_t* buffer = nullptr;
+    uint16_t length = 0;
+
+    // Use the channel DMA request when it has a stream (TIM1-TIM5), if it's free.
+    bool dma = true;
+
+    // Edge::Both: signal level at start(), so the first captured edge is known.
+    bool startsHigh = false;
+};
\ No newline at end of file
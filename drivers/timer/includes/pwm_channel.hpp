@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "timer.hpp"
+#include "driver_result.hpp"
+
+/*
+ *  @brief PWM output on one channel of a Timer (PWM mode 1, preloaded, so duty and period
+ *  changes take effect at the next update event without glitches).
+ *
+ *  The channel sets the timer period (ARR), which is shared by every channel of the
+ *  timer. On TIM1 channels 1-3 can also drive their complementary output with dead-time.
+ *  startWaveform() streams duty cycles from memory into the compare registers through
+ *  the timer DMA burst (DCR/DMAR) on every update event, with no CPU involvement.
+ *
+ *  The channel pins must be configured as their timer alternate function by the
+ *  application.
+ */
+class PwmChannel
+{
+    public:
+        struct Config;
+
+        enum class Channel : uint8_t
+        {
+            Ch1,
+            Ch2,
+            Ch3,
+            Ch4
+        };
+
+        enum class Alignment : uint8_t
+        {
+            Edge,       // Period of ARR + 1 ticks
+            Center      // Counts up and down, period of 2 * ARR ticks. TIM1-TIM5 only.
+        };
+
+        PwmChannel() = default;
+
+        /*
+         *  @brief Without exceptions the init status is lost, use init() to get it.
+         */
+        PwmChannel(Timer& timer, const Config& config);
+
+        DRIVER_RESULT(void) init(Timer& timer, const Config& config);
+
+        /*
+         *  @brief Enables the output(s), and starts the timer if it isn't running.
+         */
+        void start();
+        void stop();
+
+        // Compare value: the output is active while the counter is below it.
+        void setDuty(uint32_t ticks);
+        void setDutyPermille(uint16_t permille);
+        uint32_t getDuty();
+
+        void setPeriod(uint32_t ticks);
+        uint32_t getPeriod();
+
+        /*
+         *  @brief Loads one frame of compare values per update event from `frames`, each
+         *  frame holding `channelsPerFrame` values for this channel and the ones after it
+         *  (e.g. 3 for an RGB LED on channels 1-3). The buffer must stay valid while the
+         *  waveform runs. Without `repeat` the last frame holds once the waveform is over.
+         *
+         *  Needs the timer update DMA request (TIM1-TIM5) and its stream free.
+         */
+        DRIVER_RESULT(void) startWaveform(const uint32_t* frames, uint16_t frameCount,
+                                          uint8_t channelsPerFrame = 1, bool repeat = true);
+        void stopWaveform();
+        bool isWaveformRunning();
+
+        /*
+         *  @brief Dead-time encoding (BDTR DTG) of at least `ticks` timer clock ticks.
+         *
+         *  @return -1 above 1008 ticks, the longest dead-time available.
+         */
+        static constexpr int16_t deadTimeGenerator(uint32_t ticks)
+        {
+            if(ticks <= 127)
+                return ticks;
+            if(ticks <= 254)
+                return 0x80 | ((ticks + 1) / 2 - 64);
+            if(ticks <= 504)
+                return 0xC0 | ((ticks + 7) / 8 - 32);
+            if(ticks <= 1008)
+                return 0xE0 | ((ticks + 15) / 16 - 32);
+            return -1;
+        }
+
+    protected:
+        Timer* timer = nullptr;
+        TIM_TypeDef* registers = nullptr;
+        uint8_t channel = 0;
+        bool complementary = false;
+
+        // Update DMA stream, if the waveform is running.
+        DMA_TypeDef* dma = nullptr;
+        uint32_t stream = 0;
+
+        volatile uint32_t* compareRegister();
+};
+
+struct PwmChannel::Config
+{
+    Channel channel = Channel::Ch1;
+    Alignment alignment = Alignment::Edge;
+
+    // ARR, in timer ticks. 0 keeps the period already set on the timer.
+    uint32_t period = 0;
+
+    // Initial compare value, in timer ticks.
+    uint32_t duty = 0;
+
+    bool activeLow = false;
+
+    // TIM1 channels 1-3: also drive the CHxN output, with `deadTime` timer clock ticks
+    // (before the prescaler, up to 1008) between one output going inactive and the other
+    // going active.
+    bool complementary = false;
+    bool complementaryActiveLow = false;
+    uint16_t deadTime = 0;
+};
\ No newline at end of file
@@ -27,15 +27,21 @@ void TIM1_CC_IRQHandler();
 void TIM2_IRQHandler();
 void TIM3_IRQHandler();
 void TIM4_IRQHandler();
+void TIM5_IRQHandler();
 #ifdef __cplusplus
 }
 #endif
 
 #include <array>
-#include <functional>
+#include "inplace_function.hpp"
+#include "driver_result.hpp"
 
 #include "stm32f401xc.h"
 
+#ifdef ISR_PROFILING
+#include "isr_profiler.hpp"
+#endif
+
 typedef enum
 {
     TIMER_1,
@@ -50,6 +56,20 @@ typedef enum
 }
 TimerSelection;
 
+/*
+ *  @brief One timer behind an interrupt vector, and the SR flags it routes there. TIM1
+ *  spreads its sources over four vectors, three of them shared with TIM9-TIM11.
+ */
+struct TimerInterruptSource
+{
+    TimerSelection timer;
+    uint32_t flags;
+};
+
+class InputCapture;
+class PwmChannel;
+struct TimerSolution;
+
 class Timer
 {
     public:
@@ -57,21 +77,53 @@ class Timer
 
         struct Config;
 
+        // Non-allocating, safe to build and call from ISR context.
+        using Callback = InplaceFunction<void(void*)>;
+
         Timer() = default;
+
+        /*
+         *  @brief Without exceptions the init status is lost, use Builder::buildIn() to get it.
+         */
         Timer(const Config& config);
 
         void start();
         void pause();
-        void setCallback(std::function<void(void*)> callback, void* argument);
+        void setCallback(Callback callback, void* argument);
         void setAlarm(uint32_t count, bool oneShot = false);
         void resetAlarm();
         bool isRunning();
         uint32_t getCount();
 
+        /*
+         *  @brief Whether the update event flag is set and its interrupt hasn't been
+         *  handled yet.
+         */
+        bool isAlarmPending();
+        void clearAlarmPending();
+
+        /*
+         *  @brief Largest value the counter can hold: TIM2 and TIM5 are 32 bits, the rest 16.
+         */
+        uint32_t getMaxCount();
+
+        /*
+         *  @brief Capture/compare channels: 4 on TIM1-TIM5, 2 on TIM9, 1 on TIM10 and TIM11.
+         */
+        uint8_t getChannelCount();
+
         void setCount(uint32_t count);
         void setFrequency(uint32_t frequency);
         void setPrescaler(uint32_t prescaler);
 
+        /*
+         *  @brief Alarm every `periodNs`, with the prescaler and reload that get closest
+         *  to it (see TimerSolver). Replaces the prescaler set so far.
+         *
+         *  @return The values used, to check the period achieved (timer_solver.hpp).
+         */
+        DRIVER_RESULT(TimerSolution) setAlarmPeriod(uint64_t periodNs, bool oneShot = false);
+
         uint32_t getPrescaler();
         uint32_t getFrequency();
         uint32_t getPeriodUs();
@@ -83,8 +135,19 @@ class Timer
 
         static uint32_t getBaseClockFrequency();
 
+        /*
+         *  @brief Clock the timer counts, before its prescaler: its APB clock, doubled
+         *  when the APB prescaler isn't 1.
+         */
+        uint32_t getClockFrequency();
+
         static bool isTimerUsed(TimerSelection timer);
 
+#ifdef ISR_PROFILING
+        const IsrStats& getIsrStats();
+        void resetIsrStats();
+#endif
+
     protected:
         TimerSelection timer;
         TIM_TypeDef* timerRegister;
@@ -92,24 +155,51 @@ class Timer
         bool alarmOn = false;
         bool oneShotAlarm = false;
 
+#ifdef ISR_PROFILING
+        IsrProfiler<1> isrProfiler;
+#endif
+
         static std::array<Timer*, TIMER_MAX> drivers;
 
-        void init(const Config& config);
+        // Channels in input capture mode fed by the capture interrupt.
+        std::array<InputCapture*, 4> captureChannels = {};
+        std::array<PwmChannel*, 4> pwmChannels = {};
+
+        DRIVER_RESULT(void) init(const Config& config);
 
-        void registerTimer(TimerSelection timer);
+        DRIVER_RESULT(void) registerTimer(TimerSelection timer);
 
         void* callbackArguments;
-        std::function<void(void*)> callback;
+        Callback callback;
 
         void initializePrescaler(uint32_t prescaler, uint32_t frequency);
 
         TIM_TypeDef* getTimerRegisters(TimerSelection timer);
-        void enableClock(TimerSelection timer);
-
-        void handleInterrupt();
+        DRIVER_RESULT(void) enableClock(TimerSelection timer);
+
+        // Interrupt path, never throws. Only handles the `flags` sources (SR bits).
+        void handleInterrupt(uint32_t flags) noexcept;
+
+        /*
+         *  @brief Hands a vector to every timer sharing it, in a fixed number of steps.
+         *  Timers without a driver are skipped.
+         */
+        template <size_t Count>
+        static void dispatchInterrupt(const std::array<TimerInterruptSource, Count>& sources) noexcept
+        {
+            for(const auto& source : sources)
+            {
+                Timer* driver = drivers[source.timer];
+                if(driver)
+                    driver->handleInterrupt(source.flags);
+            }
+        }
 
         void forceUpdate();
 
+    friend class InputCapture;
+    friend class PwmChannel;
+
     // Interrupt handlers declared as friends
     friend void TIM1_UP_TIM10_IRQHandler();
     friend void TIM1_BRK_TIM9_IRQHandler();
@@ -118,4 +208,5 @@ class Timer
     friend void TIM2_IRQHandler();
     friend void TIM3_IRQHandler();
     friend void TIM4_IRQHandler();
+    friend void TIM5_IRQHandler();
 };
\ No newline at end of file
@@ -8,10 +8,11 @@ struct Timer::Config
     uint32_t count = 0;
     uint32_t frequency = 0;
     uint32_t prescaler = 0;
+    uint64_t periodNs = 0;
     bool autoStart = false;
     bool enableInterrupt = false;
     bool oneShotAlarm = false;
-    std::function<void(void*)> callback = nullptr;
+    Callback callback = nullptr;
     void* callbackArguments = nullptr;
     TimerSelection timer = TIMER_MAX;
 };
@@ -22,7 +23,7 @@ class Timer::Builder
         Config config;
 
     public:
-        void buildIn(Timer& target);
+        DRIVER_RESULT(void) buildIn(Timer& target);
 
         Config buildConfig();
 
@@ -44,6 +45,12 @@ class Timer::Builder
 
         Builder& setAlarm(uint32_t count);
 
+        /*
+         *  @brief Alarm period instead of a count: the prescaler and reload are solved for
+         *  it, and the frequency or prescaler set are ignored.
+         */
+        Builder& setAlarmPeriod(uint64_t periodNs);
+
         Builder& oneShot();
 
         Builder& periodic();
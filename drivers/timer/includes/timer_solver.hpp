@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "timer.hpp"
+
+/*
+ *  @brief Timer register values for an update period.
+ */
+struct TimerSolution
+{
+    uint32_t prescaler = 0;     // PSC
+    uint32_t reload = 0;        // ARR
+    bool valid = false;         // False if the period is 0 or out of range.
+
+    // Timer clock ticks per update period.
+    constexpr uint64_t ticks() const
+    {
+        return (static_cast<uint64_t>(prescaler) + 1) * (static_cast<uint64_t>(reload) + 1);
+    }
+
+    // Achieved period, rounded to the nearest nanosecond.
+    constexpr uint64_t periodNs(uint32_t timerClock) const
+    {
+        uint64_t total = ticks();
+        return total / timerClock * 1000000000ULL +
+               (total % timerClock * 1000000000ULL + timerClock / 2) / timerClock;
+    }
+
+    // Achieved update frequency, rounded to the nearest millihertz.
+    constexpr uint64_t frequencyMilliHz(uint32_t timerClock) const
+    {
+        uint64_t total = ticks();
+        return (timerClock * 1000ULL + total / 2) / total;
+    }
+};
+
+/*
+ *  @brief Prescaler (PSC) and auto-reload (ARR) values for a timer update period, chosen
+ *  to minimise the period error instead of truncating. Everything is constexpr, so with a
+ *  known clock tree the registers can be computed at compile time:
+ *
+ *      constexpr auto tick = TimerSolver::solvePeriodNs(
+ *          TimerSolver::timerClock(84000000, 2), 1000000, TimerSolver::maxReload(TIMER_3));
+ *      static_assert(tick.valid && tick.periodNs(84000000) == 1000000);
+ *
+ *  At run time Timer::setAlarmPeriod() does the same with the current clock tree.
+ */
+class TimerSolver
+{
+    public:
+        static constexpr uint32_t MAX_PRESCALER = UINT16_MAX;
+
+        /*
+         *  @brief Timer kernel clock: the APB clock, doubled whenever the APB prescaler
+         *  isn't 1 (RM0368 6.2).
+         */
+        static constexpr uint32_t timerClock(uint32_t hclk, uint32_t apbDivider)
+        {
+            return apbDivider == 1 ? hclk : hclk / apbDivider * 2;
+        }
+
+        // TIM1 and TIM9-TIM11 are on APB2, TIM2-TIM5 on APB1.
+        static constexpr bool isOnApb2(TimerSelection timer)
+        {
+            return timer == TIMER_1 || timer == TIMER_9 || timer == TIMER_10 || timer == TIMER_11;
+        }
+
+        // Largest ARR: TIM2 and TIM5 are 32 bits, the rest 16.
+        static constexpr uint32_t maxReload(TimerSelection timer)
+        {
+            return timer == TIMER_2 || timer == TIMER_5 ? UINT32_MAX : UINT16_MAX;
+        }
+
+        /*
+         *  @brief PSC giving the tick frequency closest to `tickFrequency`.
+         */
+        static constexpr uint32_t solvePrescaler(uint32_t timerClock, uint32_t tickFrequency)
+        {
+            uint32_t divisor = (timerClock + tickFrequency / 2) / tickFrequency;
+            if(divisor < 1)
+                divisor = 1;
+            if(divisor > MAX_PRESCALER + 1)
+                divisor = MAX_PRESCALER + 1;
+            return divisor - 1;
+        }
+
+        /*
+         *  @brief PSC and ARR whose product is closest to `ticks`, with the smallest
+         *  prescaler among equally close ones (finest duty/compare resolution).
+         */
+        static constexpr TimerSolution solveTicks(uint64_t ticks, uint32_t maxReload)
+        {
+            TimerSolution best;
+            uint64_t reloadRange = static_cast<uint64_t>(maxReload) + 1;
+            uint64_t maxTicks = (MAX_PRESCALER + 1ULL) * reloadRange;
+
+            if(ticks == 0 || ticks > maxTicks)
+                return best;
+
+            // Smaller prescalers can't reach the period. The largest of them, with the
+            // reload at its maximum, is still the closest from below and may tie.
+            uint64_t bestError = UINT64_MAX;
+            uint32_t firstDivisor = (ticks + reloadRange - 1) / reloadRange;
+            if(firstDivisor > 1)
+                firstDivisor--;
+
+            for(uint32_t divisor = firstDivisor; divisor <= MAX_PRESCALER + 1; divisor++)
+            {
+                // Past this point the reload is stuck at 1 and the error only grows.
+                if(divisor > ticks && divisor - ticks > bestError)
+                    break;
+
+                // 32 bit division where it's enough, it's a single instruction on the M4.
+                uint64_t reload = ticks <= UINT32_MAX - MAX_PRESCALER
+                    ? static_cast<uint32_t>(ticks + divisor / 2) / divisor
+                    : (ticks + divisor / 2) / divisor;
+                if(reload < 1)
+                    reload = 1;
+                if(reload > reloadRange)
+                    reload = reloadRange;
+
+                uint64_t product = reload * divisor;
+                uint64_t error = product > ticks ? product - ticks : ticks - product;
+                if(error < bestError)
+                {
+                    bestError = error;
+                    best = { divisor - 1, static_cast<uint32_t>(reload - 1), true };
+                    if(!error)
+                        break;
+                }
+            }
+
+            return best;
+        }
+
+        static constexpr TimerSolution solvePeriodNs(uint32_t timerClock, uint64_t periodNs, uint32_t maxReload)
+        {
+            // Split so that the product doesn't overflow for long periods.
+            uint64_t ticks = periodNs / 1000000000ULL * timerClock +
+                             (periodNs % 1000000000ULL * timerClock + 500000000ULL) / 1000000000ULL;
+            return solveTicks(ticks, maxReload);
+        }
+
+        static constexpr TimerSolution solveFrequency(uint32_t timerClock, uint32_t frequency, uint32_t maxReload)
+        {
+            if(frequency == 0)
+                return TimerSolution();
+            return solveTicks((timerClock + frequency / 2ULL) / frequency, maxReload);
+        }
+};
\ No newline at end of file
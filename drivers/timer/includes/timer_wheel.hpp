@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <stdint.h>
+
+#include "timer.hpp"
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1U << TIMER_WHEEL_SLOT_BITS)
+
+class TimerWheel;
+
+/*
+ *  @brief Software timer handle. Owned by the caller, like I2C transactions: it must
+ *  outlive its time in the wheel (cancel it before destroying it).
+ */
+class SoftTimer
+{
+    public:
+        bool isActive();
+
+    protected:
+        SoftTimer* next = nullptr;
+        SoftTimer* previous = nullptr;
+
+        uint32_t expiry = 0;
+        uint32_t period = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        bool active = false;
+
+        Timer::Callback callback = nullptr;
+        void* callbackArguments = nullptr;
+
+    friend class TimerWheel;
+};
+
+/*
+ *  @brief Multiplexes any number of one-shot/periodic software timers onto one hardware
+ *  Timer, using a hierarchical timing wheel (4 levels of 64 slots, O(1) start/cancel).
+ *
+ *  A tick is one count of the hardware timer, so its resolution is set through the
+ *  Timer prescaler/frequency. The wheel is tickless: the hardware alarm is programmed to
+ *  the next expiry (or the next cascade between levels), capped at the counter range.
+ *  The counter runs freely once started and is reprogrammed on the fly, so getTicks()
+ *  doesn't slip behind it.
+ *
+ *  Callbacks run in the timer interrupt. start()/cancel() can be called from any
+ *  context; if an alarm is already due when they reprogram the timer, its callbacks run
+ *  right there with interrupts masked.
+ */
+class TimerWheel
+{
+    public:
+        TimerWheel() = default;
+        TimerWheel(Timer& timer);
+
+        void init(Timer& timer);
+
+        /*
+         *  @brief Starts (or restarts) a one-shot software timer.
+         *
+         *	@param delayTicks Ticks until expiry. 0 is handled as 1.
+         */
+        void start(SoftTimer& softTimer, uint32_t delayTicks, Timer::Callback callback, void* callbackArguments = nullptr);
+
+        /*
+         *  @brief Starts (or restarts) a periodic software timer. Periods are counted from
+         *  the scheduled expiry, so they don't drift with the interrupt latency.
+         */
+        void startPeriodic(SoftTimer& softTimer, uint32_t periodTicks, Timer::Callback callback, void* callbackArguments = nullptr);
+
+        void cancel(SoftTimer& softTimer);
+
+        uint32_t getTicks();
+
+        uint32_t getTickPeriodUs();
+
+    protected:
+        Timer* timer = nullptr;
+
+        // Wheel time, only moved forward by advance(). The hardware counts from here.
+        uint32_t now = 0;
+        uint32_t armedTicks = 0;
+        // ARR of the alarm, kept across advance() (which clears armedTicks).
+        uint32_t armedReload = 0;
+
+        // Counter value that went with `now`, and whether the update flag was set then.
+        uint32_t syncedCount = 0;
+        bool syncedPending = false;
+
+        std::array<std::array<SoftTimer*, TIMER_WHEEL_SLOTS>, TIMER_WHEEL_LEVELS> slots = {};
+        std::array<uint64_t, TIMER_WHEEL_LEVELS> occupied = {};
+
+        static void alarmCallback(void* argument);
+
+        void schedule(SoftTimer& softTimer, uint32_t delayTicks, uint32_t periodTicks, Timer::Callback callback, void* callbackArguments);
+
+        void insert(SoftTimer& softTimer);
+        void unlink(SoftTimer& softTimer);
+
+        void cascade(uint8_t level);
+        void expire();
+
+        void readCounter(uint32_t& count, bool& pending);
+        uint32_t elapsedTicks(uint32_t& count, bool& pending);
+        void sync();
+        void advance(uint32_t elapsed);
+        void catchUp(uint32_t elapsed);
+        uint32_t nextEventDelay();
+        void arm();
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "clock.hpp"
+
+// ============================================================================
+// The counter runs down from maxCount to 0 (alarms count down, see
+// Timer::enableInterrupt()), so the ticks within the current period are
+// maxCount - CNT, and every update event adds a full period to `overflows`.
+//
+// A read combines `overflows` and CNT, which can't be sampled together. The update flag
+// tells whether the counter wrapped and the interrupt hasn't counted it yet (it's
+// masked, or the reader is a higher priority ISR): then CNT is read again, after the
+// flag, so it's the post-wrap value that goes with overflows + 1. If the interrupt ran
+// in the middle, `overflows` changed and the read starts over.
+//
+// The only window left is inside the interrupt itself, between Timer::handleInterrupt()
+// clearing the flag and the callback counting the wrap: a reader preempting it there
+// would read a period short. Hence no reader may have a higher priority than the timer
+// interrupt (the NVIC default, 0, is the highest).
+// ============================================================================
+
+Clock::Clock(Timer& timer)
+{
+    init(timer);
+}
+
+void Clock::init(Timer& timer)
+{
+    this->timer = &timer;
+    timer.pause();
+
+    frequency = timer.getFrequency();
+    maxCount = timer.getMaxCount();
+    countBits = maxCount == UINT32_MAX ? 32 : 16;
+    overflows = 0;
+
+    timer.setCallback(overflowCallback, this);
+    timer.setAlarm(maxCount);
+    timer.start();
+}
+
+void Clock::overflowCallback(void* argument)
+{
+    Clock* clock = static_cast<Clock*>(argument);
+    clock->overflows.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t Clock::getTicks()
+{
+    uint32_t high;
+    uint32_t low;
+    uint32_t wraps;
+
+    do
+    {
+        wraps = overflows.load(std::memory_order_acquire);
+        high = wraps;
+        low = maxCount - timer->getCount();
+
+        if(timer->isAlarmPending())
+        {
+            low = maxCount - timer->getCount();
+            high++;
+        }
+    }
+    while(wraps != overflows.load(std::memory_order_acquire));
+
+    return (static_cast<uint64_t>(high) << countBits) | low;
+}
+
+uint64_t Clock::getNanoseconds()
+{
+    return ticksToNanoseconds(getTicks());
+}
+
+uint64_t Clock::getMicroseconds()
+{
+    return ticksToMicroseconds(getTicks());
+}
+
+uint32_t Clock::getFrequency()
+{
+    return frequency;
+}
+
+uint64_t Clock::scale(uint64_t value, uint32_t multiplier, uint32_t divisor)
+{
+    // value * multiplier / divisor without the 64 bit overflow of the product: the
+    // remainder is below 2^32, so its product with a 32 bit multiplier fits.
+    return (value / divisor) * multiplier + (value % divisor) * multiplier / divisor;
+}
+
+uint64_t Clock::ticksToNanoseconds(uint64_t ticks)
+{
+    return scale(ticks, 1000000000, frequency);
+}
+
+uint64_t Clock::ticksToMicroseconds(uint64_t ticks)
+{
+    return scale(ticks, 1000000, frequency);
+}
+
+uint64_t Clock::nanosecondsToTicks(uint64_t nanoseconds)
+{
+    return scale(nanoseconds, frequency, 1000000000);
+}
+
+uint64_t Clock::microsecondsToTicks(uint64_t microseconds)
+{
+    return scale(microseconds, frequency, 1000000);
+}
\ No newline at end of file
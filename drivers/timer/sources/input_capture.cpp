@@ -0,0 +1,342 @@
+#include "input_capture.hpp"
+
+#include <stdexcept>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_dma.h"
+
+#include "dma_streams.hpp"
+
+// ============================================================================
+// Every channel register field is at a fixed offset from its channel 1 counterpart:
+//   CCMR1/CCMR2: 8 bits per channel (CCxS, ICxPSC, ICxF), channels 1-2 / 3-4.
+//   CCER:        4 bits per channel (CCxE, CCxP, CCxNP).
+//   SR/DIER:     CCxIF/CCxIE at bit 1 + channel, CCxOF/CCxDE at bit 9 + channel.
+//
+// DMA mode: the channel request copies CCRx into the ring buffer in circular mode, so
+// the write position is length - NDTR and the CPU is only involved when reading.
+// ============================================================================
+
+namespace
+{
+    constexpr uint32_t CCMR_INPUT_TI = 0x1;            // CCxS = 01: ICx mapped on TIx
+    constexpr uint32_t CCER_RISING = 0x0;
+    constexpr uint32_t CCER_FALLING = TIM_CCER_CC1P;
+    constexpr uint32_t CCER_BOTH = TIM_CCER_CC1P | TIM_CCER_CC1NP;
+    constexpr uint32_t CCER_CHANNEL_MASK = TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP;
+
+    struct CaptureDma
+    {
+        DMA_TypeDef* dma;
+        uint32_t stream;
+        uint32_t channel;
+    };
+
+    // RM0368 DMA request mapping. TIM4_CH4 and TIM9-TIM11 have no request.
+    CaptureDma captureDma(TimerSelection timer, uint8_t channel)
+    {
+        switch(timer)
+        {
+            case TIMER_1:
+            {
+                constexpr uint32_t streams[] = { LL_DMA_STREAM_1, LL_DMA_STREAM_2, LL_DMA_STREAM_6, LL_DMA_STREAM_4 };
+                return { DMA2, streams[channel], LL_DMA_CHANNEL_6 };
+            }
+            case TIMER_2:
+            {
+                constexpr uint32_t streams[] = { LL_DMA_STREAM_5, LL_DMA_STREAM_6, LL_DMA_STREAM_1, LL_DMA_STREAM_7 };
+                return { DMA1, streams[channel], LL_DMA_CHANNEL_3 };
+            }
+            case TIMER_3:
+            {
+                constexpr uint32_t streams[] = { LL_DMA_STREAM_4, LL_DMA_STREAM_5, LL_DMA_STREAM_7, LL_DMA_STREAM_2 };
+                return { DMA1, streams[channel], LL_DMA_CHANNEL_5 };
+            }
+            case TIMER_4:
+            {
+                if(channel == 3)
+                    return { nullptr, 0, 0 };
+                constexpr uint32_t streams[] = { LL_DMA_STREAM_0, LL_DMA_STREAM_3, LL_DMA_STREAM_7 };
+                return { DMA1, streams[channel], LL_DMA_CHANNEL_2 };
+            }
+            case TIMER_5:
+            {
+                constexpr uint32_t streams[] = { LL_DMA_STREAM_2, LL_DMA_STREAM_4, LL_DMA_STREAM_0, LL_DMA_STREAM_1 };
+                return { DMA1, streams[channel], LL_DMA_CHANNEL_6 };
+            }
+            default:
+                return { nullptr, 0, 0 };
+        }
+    }
+
+    IRQn_Type captureIrq(TimerSelection timer)
+    {
+        switch(timer)
+        {
+            case TIMER_1:   return TIM1_CC_IRQn;
+            case TIMER_2:   return TIM2_IRQn;
+            case TIMER_3:   return TIM3_IRQn;
+            case TIMER_4:   return TIM4_IRQn;
+            case TIMER_5:   return TIM5_IRQn;
+            case TIMER_9:   return TIM1_BRK_TIM9_IRQn;
+            case TIMER_10:  return TIM1_UP_TIM10_IRQn;
+            default:        return TIM1_TRG_COM_TIM11_IRQn;
+        }
+    }
+}
+
+InputCapture::InputCapture(Timer& timer, const Config& config)
+{
+    (void)init(timer, config);
+}
+
+DRIVER_RESULT(void) InputCapture::init(Timer& timer, const Config& config)
+{
+    uint8_t channel = static_cast<uint8_t>(config.channel);
+
+    if(!config.buffer || config.length < 2 || config.prescaler > 3 || config.filter > 15 ||
+       channel >= timer.getChannelCount())
+        DRIVER_FAIL(DriverError::InvalidConfig, std::invalid_argument("Invalid input capture configuration"));
+    // With a prescaler the edges captured aren't alternating anymore.
+    if(config.prescaler && config.edge == Edge::Both)
+        DRIVER_FAIL(DriverError::InvalidConfig, std::invalid_argument("Input capture prescaler needs a single edge"));
+    if((timer.captureChannels[channel] && timer.captureChannels[channel] != this) || timer.pwmChannels[channel])
+        DRIVER_FAIL(DriverError::InUse, std::invalid_argument("Timer channel already capturing"));
+
+    this->timer = &timer;
+    this->registers = timer.timerRegister;
+    this->channel = channel;
+    edge = config.edge;
+    prescaler = config.prescaler;
+    startsHigh = config.startsHigh;
+    buffer = config.buffer;
+    length = config.length;
+
+    CaptureDma mapping = config.dma ? captureDma(timer.timer, channel) : CaptureDma{ nullptr, 0, 0 };
+    dma = mapping.dma;
+    stream = mapping.stream;
+    dmaChannel = mapping.channel;
+
+    volatile uint32_t& ccmr = channel < 2 ? registers->CCMR1 : registers->CCMR2;
+    uint32_t ccmrShift = 8 * (channel % 2);
+    uint32_t input = CCMR_INPUT_TI | (config.prescaler << TIM_CCMR1_IC1PSC_Pos) | (config.filter << TIM_CCMR1_IC1F_Pos);
+    ccmr = (ccmr & ~(0xFFU << ccmrShift)) | (input << ccmrShift);
+
+    uint32_t polarity = edge == Edge::Rising ? CCER_RISING : edge == Edge::Falling ? CCER_FALLING : CCER_BOTH;
+    registers->CCER = (registers->CCER & ~(CCER_CHANNEL_MASK << (4 * channel))) | (polarity << (4 * channel));
+
+    timer.captureChannels[channel] = this;
+    return DRIVER_OK;
+}
+
+void InputCapture::start()
+{
+    // A restart without stop() quiesces the channel first: the ring indexes are reset
+    // below and a DMA stream ignores its configuration writes while it's enabled.
+    registers->CCER &= ~(TIM_CCER_CC1E << (4 * channel));
+    registers->DIER &= ~((TIM_DIER_CC1IE | TIM_DIER_CC1DE) << channel);
+    if(streamClaimed)
+    {
+        LL_DMA_DisableStream(dma, stream);
+        while(LL_DMA_IsEnabledStream(dma, stream));
+    }
+
+    head = 0;
+    tail = 0;
+    hasReference = false;
+    // The edge before the first capture: measure() flips it on every capture.
+    referenceRising = startsHigh;
+
+    // Free-running over the full range, so the differences are wrap-safe.
+    if(!timer->isRunning())
+    {
+        registers->ARR = timer->getMaxCount();
+        registers->CR1 &= ~TIM_CR1_DIR;
+        timer->start();
+    }
+
+    // The stream may belong to another peripheral (e.g. an I2C bus in DMA mode). A
+    // restart keeps the claim it already holds.
+    if(dma && !streamClaimed)
+        streamClaimed = DmaStreams::claim(dma, stream);
+    dmaFed = streamClaimed;
+
+    if(dmaFed)
+    {
+        RCC->AHB1ENR |= dma == DMA1 ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+
+        LL_DMA_SetChannelSelection(dma, stream, dmaChannel);
+        LL_DMA_SetDataTransferDirection(dma, stream, LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+        LL_DMA_SetMode(dma, stream, LL_DMA_MODE_CIRCULAR);
+        LL_DMA_SetStreamPriorityLevel(dma, stream, LL_DMA_PRIORITY_HIGH);
+        LL_DMA_SetPeriphIncMode(dma, stream, LL_DMA_PERIPH_NOINCREMENT);
+        LL_DMA_SetMemoryIncMode(dma, stream, LL_DMA_MEMORY_INCREMENT);
+        // CCRx of the 16 bit timers reads as a zero-extended word.
+        LL_DMA_SetPeriphSize(dma, stream, LL_DMA_PDATAALIGN_WORD);
+        LL_DMA_SetMemorySize(dma, stream, LL_DMA_MDATAALIGN_WORD);
+        LL_DMA_ConfigAddresses(dma, stream, reinterpret_cast<uintptr_t>(captureRegister()),
+                               reinterpret_cast<uintptr_t>(buffer), LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+        LL_DMA_SetDataLength(dma, stream, length);
+        LL_DMA_EnableStream(dma, stream);
+
+        registers->DIER |= TIM_DIER_CC1DE << channel;
+    }
+    else
+    {
+        registers->DIER |= TIM_DIER_CC1IE << channel;
+        NVIC_EnableIRQ(captureIrq(timer->timer));
+    }
+
+    registers->SR = ~((TIM_SR_CC1IF | TIM_SR_CC1OF) << channel);
+    registers->CCER |= TIM_CCER_CC1E << (4 * channel);
+}
+
+void InputCapture::stop()
+{
+    registers->CCER &= ~(TIM_CCER_CC1E << (4 * channel));
+    registers->DIER &= ~((TIM_DIER_CC1IE | TIM_DIER_CC1DE) << channel);
+
+    if(streamClaimed)
+    {
+        LL_DMA_DisableStream(dma, stream);
+        while(LL_DMA_IsEnabledStream(dma, stream));
+        DmaStreams::release(dma, stream);
+        streamClaimed = false;
+    }
+}
+
+bool InputCapture::isDmaFed()
+{
+    return dmaFed;
+}
+
+volatile uint32_t* InputCapture::captureRegister()
+{
+    return &registers->CCR1 + channel;
+}
+
+uint16_t InputCapture::writeIndex()
+{
+    if(!dmaFed)
+        return head;
+
+    return (length - LL_DMA_GetDataLength(dma, stream)) % length;
+}
+
+uint16_t InputCapture::available()
+{
+    return (writeIndex() + length - tail) % length;
+}
+
+uint16_t InputCapture::read(uint32_t* timestamps, uint16_t maxCount)
+{
+    uint16_t count = available();
+    if(count > maxCount)
+        count = maxCount;
+
+    for(uint16_t i = 0; i < count; i++)
+    {
+        timestamps[i] = buffer[tail];
+        tail = (tail + 1) % length;
+    }
+
+    return count;
+}
+
+uint32_t InputCapture::interval(uint32_t from, uint32_t to)
+{
+    // A timer shared with a Clock counts down.
+    uint32_t ticks = registers->CR1 & TIM_CR1_DIR ? from - to : to - from;
+    return ticks & timer->getMaxCount();
+}
+
+bool InputCapture::measure(Measurement& measurement)
+{
+    uint64_t highTicks = 0;
+    uint64_t lowTicks = 0;
+    uint32_t highIntervals = 0;
+    uint32_t lowIntervals = 0;
+
+    uint16_t count = available();
+    for(uint16_t i = 0; i < count; i++)
+    {
+        uint32_t capture = buffer[tail];
+        tail = (tail + 1) % length;
+
+        if(hasReference)
+        {
+            // With a single edge every interval is a whole period, counted as "high".
+            uint32_t ticks = interval(reference, capture);
+            if(edge != Edge::Both || referenceRising)
+            {
+                highTicks += ticks;
+                highIntervals++;
+            }
+            else
+            {
+                lowTicks += ticks;
+                lowIntervals++;
+            }
+        }
+
+        reference = capture;
+        hasReference = true;
+        if(edge == Edge::Both)
+            referenceRising = !referenceRising;
+    }
+
+    measurement = Measurement();
+
+    if(edge == Edge::Both)
+    {
+        if(!highIntervals || !lowIntervals)
+            return false;
+
+        measurement.highTicks = highTicks / highIntervals;
+        measurement.periodTicks = measurement.highTicks + lowTicks / lowIntervals;
+        measurement.periods = highIntervals < lowIntervals ? highIntervals : lowIntervals;
+    }
+    else
+    {
+        if(!highIntervals)
+            return false;
+
+        // Each capture is 2^prescaler edges apart.
+        measurement.periodTicks = highTicks / (static_cast<uint64_t>(highIntervals) << prescaler);
+        measurement.periods = highIntervals << prescaler;
+    }
+
+    if(!measurement.periodTicks)
+        return false;
+
+    measurement.frequencyMilliHz = static_cast<uint64_t>(timer->getFrequency()) * 1000 / measurement.periodTicks;
+    measurement.dutyPermille = static_cast<uint64_t>(measurement.highTicks) * 1000 / measurement.periodTicks;
+    return true;
+}
+
+uint32_t InputCapture::getOverruns()
+{
+    return overruns;
+}
+
+void InputCapture::onCapture() noexcept
+{
+    // Reading CCRx clears CCxIF.
+    uint32_t capture = *captureRegister();
+
+    if(registers->SR & (TIM_SR_CC1OF << channel))
+    {
+        registers->SR = ~(TIM_SR_CC1OF << channel);
+        overruns = overruns + 1;
+    }
+
+    uint16_t next = (head + 1) % length;
+    if(next == tail)
+    {
+        overruns = overruns + 1;
+        return;
+    }
+
+    buffer[head] = capture;
+    head = next;
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "pwm_channel.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "stm32f4xx.h"
+#include "stm32f4xx_ll_dma.h"
+
+#include "dma_streams.hpp"
+
+// ============================================================================
+// Channel fields are at a fixed offset from their channel 1 counterpart:
+//   CCMR1/CCMR2: 8 bits per channel (CCxS, OCxPE, OCxM), channels 1-2 / 3-4.
+//   CCER:        4 bits per channel (CCxE, CCxP, CCxNE, CCxNP).
+//
+// Waveform: the update event DMA request writes DMAR, which the timer redirects to
+// DBL + 1 consecutive registers starting at DBA (a burst), here the compare registers
+// from this channel on. The preload makes them effective at the next update event, so
+// every PWM period gets one frame.
+// ============================================================================
+
+namespace
+{
+    constexpr uint32_t CCMR_PWM_MODE_1 = TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1PE;
+    constexpr uint32_t CCER_CHANNEL_MASK = TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NE | TIM_CCER_CC1NP;
+    constexpr uint32_t DBA_CCR1 = offsetof(TIM_TypeDef, CCR1) / sizeof(uint32_t);
+
+    struct UpdateDma
+    {
+        DMA_TypeDef* dma;
+        uint32_t stream;
+        uint32_t channel;
+    };
+
+    // RM0368 DMA request mapping (TIMx_UP). TIM9-TIM11 have no request.
+    UpdateDma updateDma(TimerSelection timer)
+    {
+        switch(timer)
+        {
+            case TIMER_1:   return { DMA2, LL_DMA_STREAM_5, LL_DMA_CHANNEL_6 };
+            case TIMER_2:   return { DMA1, LL_DMA_STREAM_1, LL_DMA_CHANNEL_3 };
+            case TIMER_3:   return { DMA1, LL_DMA_STREAM_2, LL_DMA_CHANNEL_5 };
+            case TIMER_4:   return { DMA1, LL_DMA_STREAM_6, LL_DMA_CHANNEL_2 };
+            case TIMER_5:   return { DMA1, LL_DMA_STREAM_0, LL_DMA_CHANNEL_6 };
+            default:        return { nullptr, 0, 0 };
+        }
+    }
+}
+
+PwmChannel::PwmChannel(Timer& timer, const Config& config)
+{
+    (void)init(timer, config);
+}
+
+DRIVER_RESULT(void) PwmChannel::init(Timer& timer, const Config& config)
+{
+    uint8_t channel = static_cast<uint8_t>(config.channel);
+    bool hasCenterAlignment = timer.timer != TIMER_9 && timer.timer != TIMER_10 && timer.timer != TIMER_11;
+    int16_t deadTime = deadTimeGenerator(config.deadTime);
+
+    if(channel >= timer.getChannelCount())
+        DRIVER_FAIL(DriverError::InvalidConfig, std::invalid_argument("Timer has no such channel"));
+    if(config.alignment == Alignment::Center && !hasCenterAlignment)
+        DRIVER_FAIL(DriverError::InvalidConfig, std::invalid_argument("Timer has no center-aligned mode"));
+    if(config.complementary && (timer.timer != TIMER_1 || channel > 2 || deadTime < 0))
+        DRIVER_FAIL(DriverError::InvalidConfig, std::invalid_argument("Invalid complementary output configuration"));
+    if((timer.captureChannels[channel]) || (timer.pwmChannels[channel] && timer.pwmChannels[channel] != this))
+        DRIVER_FAIL(DriverError::InUse, std::invalid_argument("Timer channel already in use"));
+
+    // The counter mode can only be changed while it's stopped.
+    TIM_TypeDef* registers = timer.timerRegister;
+    uint32_t counterMode = config.alignment == Alignment::Center ? TIM_CR1_CMS_0 : 0;
+    if((registers->CR1 & TIM_CR1_CMS) != counterMode)
+    {
+        if(timer.isRunning())
+            DRIVER_FAIL(DriverError::InUse, std::invalid_argument("Timer running with another alignment"));
+        registers->CR1 = (registers->CR1 & ~TIM_CR1_CMS) | counterMode;
+    }
+
+    this->timer = &timer;
+    this->registers = registers;
+    this->channel = channel;
+    complementary = config.complementary;
+
+    registers->CR1 |= TIM_CR1_ARPE;
+    if(config.period)
+        registers->ARR = config.period;
+
+    volatile uint32_t& ccmr = channel < 2 ? registers->CCMR1 : registers->CCMR2;
+    uint32_t ccmrShift = 8 * (channel % 2);
+    ccmr = (ccmr & ~(0xFFU << ccmrShift)) | (CCMR_PWM_MODE_1 << ccmrShift);
+    *compareRegister() = config.duty;
+
+    uint32_t ccer = config.activeLow ? TIM_CCER_CC1P : 0;
+    if(complementary)
+    {
+        ccer |= config.complementaryActiveLow ? TIM_CCER_CC1NP : 0;
+        registers->BDTR = (registers->BDTR & ~TIM_BDTR_DTG) | static_cast<uint32_t>(deadTime);
+    }
+    registers->CCER = (registers->CCER & ~(CCER_CHANNEL_MASK << (4 * channel))) | (ccer << (4 * channel));
+
+    // Load the preloaded period and duty right away.
+    if(!timer.isRunning())
+        timer.forceUpdate();
+
+    timer.pwmChannels[channel] = this;
+    return DRIVER_OK;
+}
+
+void PwmChannel::start()
+{
+    uint32_t outputs = TIM_CCER_CC1E | (complementary ? TIM_CCER_CC1NE : 0);
+    registers->CCER |= outputs << (4 * channel);
+
+    // Advanced timer outputs are also gated by the main output enable.
+    if(timer->timer == TIMER_1)
+        registers->BDTR |= TIM_BDTR_MOE;
+
+    if(!timer->isRunning())
+        timer->start();
+}
+
+void PwmChannel::stop()
+{
+    stopWaveform();
+    registers->CCER &= ~((TIM_CCER_CC1E | TIM_CCER_CC1NE) << (4 * channel));
+}
+
+volatile uint32_t* PwmChannel::compareRegister()
+{
+    return &registers->CCR1 + channel;
+}
+
+void PwmChannel::setDuty(uint32_t ticks)
+{
+    *compareRegister() = ticks;
+}
+
+void PwmChannel::setDutyPermille(uint16_t permille)
+{
+    // Edge-aligned the output is active for CCR of ARR + 1 ticks, center-aligned for
+    // 2 * CCR of 2 * ARR.
+    uint64_t top = registers->ARR;
+    if(!(registers->CR1 & TIM_CR1_CMS))
+        top++;
+
+    setDuty(top * permille / 1000);
+}
+
+uint32_t PwmChannel::getDuty()
+{
+    return *compareRegister();
+}
+
+void PwmChannel::setPeriod(uint32_t ticks)
+{
+    registers->ARR = ticks;
+}
+
+uint32_t PwmChannel::getPeriod()
+{
+    return registers->ARR;
+}
+
+DRIVER_RESULT(void) PwmChannel::startWaveform(const uint32_t* frames, uint16_t frameCount,
+                                              uint8_t channelsPerFrame, bool repeat)
+{
+    uint32_t transfers = static_cast<uint32_t>(frameCount) * channelsPerFrame;
+
+    if(!frames || !frameCount || !channelsPerFrame || transfers > UINT16_MAX ||
+       channel + channelsPerFrame > timer->getChannelCount())
+        DRIVER_FAIL(DriverError::InvalidArgument, std::invalid_argument("Invalid PWM waveform"));
+
+    UpdateDma mapping = updateDma(timer->timer);
+    if(!mapping.dma)
+        DRIVER_FAIL(DriverError::InvalidConfig, std::invalid_argument("Timer has no update DMA request"));
+
+    stopWaveform();
+    if(!DmaStreams::claim(mapping.dma, mapping.stream))
+        DRIVER_FAIL(DriverError::InUse, std::invalid_argument("Timer update DMA stream in use"));
+
+    dma = mapping.dma;
+    stream = mapping.stream;
+
+    RCC->AHB1ENR |= dma == DMA1 ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+
+    LL_DMA_SetChannelSelection(dma, stream, mapping.channel);
+    LL_DMA_SetDataTransferDirection(dma, stream, LL_DMA_DIRECTION_MEMORY_TO_PERIPH);
+    LL_DMA_SetMode(dma, stream, repeat ? LL_DMA_MODE_CIRCULAR : LL_DMA_MODE_NORMAL);
+    LL_DMA_SetStreamPriorityLevel(dma, stream, LL_DMA_PRIORITY_HIGH);
+    LL_DMA_SetPeriphIncMode(dma, stream, LL_DMA_PERIPH_NOINCREMENT);
+    LL_DMA_SetMemoryIncMode(dma, stream, LL_DMA_MEMORY_INCREMENT);
+    LL_DMA_SetPeriphSize(dma, stream, LL_DMA_PDATAALIGN_WORD);
+    LL_DMA_SetMemorySize(dma, stream, LL_DMA_MDATAALIGN_WORD);
+    LL_DMA_ConfigAddresses(dma, stream, reinterpret_cast<uintptr_t>(frames),
+                           reinterpret_cast<uintptr_t>(&registers->DMAR), LL_DMA_DIRECTION_MEMORY_TO_PERIPH);
+    LL_DMA_SetDataLength(dma, stream, transfers);
+
+    registers->DCR = ((channelsPerFrame - 1U) << TIM_DCR_DBL_Pos) | (DBA_CCR1 + channel);
+    LL_DMA_EnableStream(dma, stream);
+    registers->DIER |= TIM_DIER_UDE;
+
+    return DRIVER_OK;
+}
+
+void PwmChannel::stopWaveform()
+{
+    if(!dma)
+        return;
+
+    registers->DIER &= ~TIM_DIER_UDE;
+    LL_DMA_DisableStream(dma, stream);
+    while(LL_DMA_IsEnabledStream(dma, stream));
+    DmaStreams::release(dma, stream);
+    dma = nullptr;
+}
+
+bool PwmChannel::isWaveformRunning()
+{
+    return dma && LL_DMA_IsEnabledStream(dma, stream);
+}
\ No newline at end of file
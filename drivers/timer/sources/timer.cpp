@@ -1,5 +1,9 @@
 #include "timer.hpp"
 #include "timer_builder.hpp"
+#include "input_capture.hpp"
+#include "timer_solver.hpp"
+
+#include <stdexcept>
 
 #include "stm32f4xx.h"
 
@@ -8,37 +12,44 @@ std::array<Timer*, TIMER_MAX> Timer::drivers = {};
 
 void Timer::initializePrescaler(uint32_t prescaler, uint32_t frequency)
 {
-    if(!prescaler)
-    {
-        auto baseClock = this->getBaseClockFrequency();
-        prescaler = baseClock/frequency - 1;
-    }
+    if(!prescaler && frequency)
+        prescaler = TimerSolver::solvePrescaler(this->getClockFrequency(), frequency);
     this->timerRegister->PSC = prescaler;
     this->forceUpdate();
 }
 
 Timer::Timer(const Config& config)
 {
-    init(config);
+    (void)init(config);
 }
 
-void Timer::init(const Config& config)
+DRIVER_RESULT(void) Timer::init(const Config& config)
 {
     timer = config.timer;
     timerRegister = this->getTimerRegisters(config.timer);
     callback = config.callback;
+    callbackArguments = config.callbackArguments;
 
-    this->registerTimer(config.timer);
+    DRIVER_TRY(this->registerTimer(config.timer));
 
-    this->enableClock(config.timer);
+    DRIVER_TRY(this->enableClock(config.timer));
 
-    this->initializePrescaler(config.prescaler, config.frequency);
+    if(config.periodNs)
+    {
+        DRIVER_TRY(this->setAlarmPeriod(config.periodNs, config.oneShotAlarm));
+    }
+    else
+    {
+        this->initializePrescaler(config.prescaler, config.frequency);
 
-    if(config.enableInterrupt)
-        this->setAlarm(config.count, config.oneShotAlarm);
+        if(config.enableInterrupt)
+            this->setAlarm(config.count, config.oneShotAlarm);
+    }
 
     if(config.autoStart)
         this->start();
+
+    return DRIVER_OK;
 }
 
 void Timer::forceUpdate()
@@ -56,8 +67,7 @@ void Timer::setCount(uint32_t count)
 
 void Timer::setFrequency(uint32_t frequency)
 {
-    auto baseClock = this->getBaseClockFrequency();
-    this->timerRegister->PSC = baseClock/frequency - 1;
+    this->timerRegister->PSC = TimerSolver::solvePrescaler(this->getClockFrequency(), frequency);
 }
 
 void Timer::setPrescaler(uint32_t prescaler)
@@ -67,13 +77,13 @@ void Timer::setPrescaler(uint32_t prescaler)
 
 uint32_t Timer::getFrequency()
 {
-    auto baseClock = this->getBaseClockFrequency();
+    auto baseClock = this->getClockFrequency();
     return baseClock / (this->timerRegister->PSC + 1);
 }
 
 uint32_t Timer::getPeriodUs()
 {
-    auto baseClock = getBaseClockFrequency();
+    auto baseClock = this->getClockFrequency();
     return (this->timerRegister->PSC + 1) / (baseClock / 1000000);
 }
 
@@ -82,7 +92,7 @@ uint32_t Timer::getPrescaler()
     return this->timerRegister->PSC;
 }
 
-void Timer::setCallback(std::function<void(void*)> callback, void* argument)
+void Timer::setCallback(Callback callback, void* argument)
 {
     this->callback = callback;
     this->callbackArguments = argument;
@@ -104,6 +114,19 @@ void Timer::setAlarm(uint32_t count, bool oneShot)
     this->enableInterrupt();
 }
 
+DRIVER_RESULT(TimerSolution) Timer::setAlarmPeriod(uint64_t periodNs, bool oneShot)
+{
+    TimerSolution solution = TimerSolver::solvePeriodNs(this->getClockFrequency(), periodNs, this->getMaxCount());
+    if(!solution.valid)
+        DRIVER_FAIL(DriverError::OutOfRange, std::out_of_range("Timer period out of range"));
+
+    this->timerRegister->PSC = solution.prescaler;
+    this->forceUpdate();
+    this->setAlarm(solution.reload, oneShot);
+
+    return solution;
+}
+
 void Timer::resetAlarm()
 {
     if(this->oneShotAlarm)
@@ -111,14 +134,15 @@ void Timer::resetAlarm()
     this->setCount(this->resetCount);
 }
 
-void Timer::registerTimer(TimerSelection timer)
+DRIVER_RESULT(void) Timer::registerTimer(TimerSelection timer)
 {
     if(timer == TIMER_MAX)
-        throw std::exception(); // TODO custom exception
+        DRIVER_FAIL(DriverError::InvalidArgument, std::invalid_argument("Invalid timer selection"));
     if(this->drivers[timer] != nullptr)
-        throw std::exception(); // TODO custom exception
+        DRIVER_FAIL(DriverError::InUse, std::invalid_argument("Timer already in use"));
 
     this->drivers[timer] = this;
+    return DRIVER_OK;
 }
 
 void Timer::start()
@@ -141,13 +165,38 @@ uint32_t Timer::getCount()
     return this->timerRegister->CNT;
 }
 
+bool Timer::isAlarmPending()
+{
+    return this->timerRegister->SR & TIM_SR_UIF;
+}
+
+void Timer::clearAlarmPending()
+{
+    this->timerRegister->SR = ~TIM_SR_UIF;
+}
+
+uint32_t Timer::getMaxCount()
+{
+    if(this->timer == TIMER_2 || this->timer == TIMER_5)
+        return UINT32_MAX;
+    return UINT16_MAX;
+}
+
+uint8_t Timer::getChannelCount()
+{
+    if(this->timer == TIMER_9)
+        return 2;
+    if(this->timer == TIMER_10 || this->timer == TIMER_11)
+        return 1;
+    return 4;
+}
+
 void Timer::enableInterrupt()
 {
     this->alarmOn = true;
     this->timerRegister->DIER |= TIM_DIER_UIE;
     this->timerRegister->CR1 |= TIM_CR1_DIR;
 
-    // TODO puedo diferenciar entre TIM1, TIM9, TIM10 y TIM11?
     switch(this->timer)
     {
         case TIMER_1:
@@ -175,7 +224,8 @@ void Timer::enableInterrupt()
             NVIC_EnableIRQ(TIM1_TRG_COM_TIM11_IRQn);
             break;
         default:
-            throw std::exception(); // TODO custom exception
+            // Unreachable once init() succeeded, so it doesn't burden setAlarm() with a status.
+            DRIVER_FAIL(void(), std::invalid_argument("Timer has no interrupt vector"));
     }
 }
 
@@ -206,40 +256,40 @@ TIM_TypeDef* Timer::getTimerRegisters(TimerSelection timer)
         case TIMER_11:
             return TIM11;
         default:
-            throw std::exception(); // TODO custom exception
+            DRIVER_FAIL(nullptr, std::invalid_argument("Invalid timer selection"));
     }
 }
 
-void Timer::enableClock(TimerSelection timer)
+DRIVER_RESULT(void) Timer::enableClock(TimerSelection timer)
 {
     switch(timer)
     {
         case TIMER_1:
             RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
-            return;
+            return DRIVER_OK;
         case TIMER_2:
             RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
-            return;
+            return DRIVER_OK;
         case TIMER_3:
             RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
-            return;
+            return DRIVER_OK;
         case TIMER_4:
             RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
-            return;
+            return DRIVER_OK;
         case TIMER_5:
             RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
-            return;
+            return DRIVER_OK;
         case TIMER_9:
             RCC->APB2ENR |= RCC_APB2ENR_TIM9EN;
-            return;
+            return DRIVER_OK;
         case TIMER_10:
             RCC->APB2ENR |= RCC_APB2ENR_TIM10EN;
-            return;
+            return DRIVER_OK;
         case TIMER_11:
             RCC->APB2ENR |= RCC_APB2ENR_TIM11EN;
-            return;
+            return DRIVER_OK;
         default:
-            throw std::exception(); // TODO custom exception
+            DRIVER_FAIL(DriverError::InvalidArgument, std::invalid_argument("Invalid timer selection"));
     }
 }
 
@@ -254,17 +304,60 @@ uint32_t Timer::getBaseClockFrequency()
     return SystemCoreClock;
 }
 
+uint32_t Timer::getClockFrequency()
+{
+    uint32_t cfgr = RCC->CFGR;
+    uint32_t ppre = TimerSolver::isOnApb2(this->timer)
+        ? (cfgr & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos
+        : (cfgr & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+
+    // PPREx: 0xx not divided, 100-111 divided by 2 to 16.
+    uint32_t apbDivider = ppre & 0x4 ? 2U << (ppre & 0x3) : 1;
+    return TimerSolver::timerClock(getBaseClockFrequency(), apbDivider);
+}
+
 bool Timer::isTimerUsed(TimerSelection timer)
 {
     return Timer::drivers[timer] != nullptr;
 }
 
-void Timer::handleInterrupt()
+#ifdef ISR_PROFILING
+const IsrStats& Timer::getIsrStats()
 {
-    if (this->timerRegister->SR & TIM_SR_UIF)
+    return isrProfiler.get(0);
+}
+
+void Timer::resetIsrStats()
+{
+    isrProfiler.reset();
+}
+#endif
+
+void Timer::handleInterrupt(uint32_t flags) noexcept
+{
+#ifdef ISR_PROFILING
+    IsrProfiler<1>::Scope profileScope(isrProfiler, 0);
+#endif
+
+    // DIER enable bits 0-7 line up with the SR flags. Flags are cleared by writing 0 to
+    // them alone (rc_w0), a read-modify-write could drop flags set meanwhile.
+    uint32_t pending = this->timerRegister->SR & this->timerRegister->DIER & flags;
+
+    if (pending & TIM_SR_UIF)
     {
-        this->timerRegister->SR &= ~TIM_SR_UIF;
+        this->timerRegister->SR = ~TIM_SR_UIF;
         if(this->callback)
             this->callback(callbackArguments);
     }
+
+    for(uint8_t channel = 0; channel < captureChannels.size(); channel++)
+    {
+        if((pending & (TIM_SR_CC1IF << channel)) && captureChannels[channel])
+            captureChannels[channel]->onCapture();
+    }
+
+    // No handler for commutation, trigger and break yet, so they don't fire again.
+    uint32_t unhandled = pending & (TIM_SR_COMIF | TIM_SR_TIF | TIM_SR_BIF);
+    if(unhandled)
+        this->timerRegister->SR = ~unhandled;
 }
\ No newline at end of file
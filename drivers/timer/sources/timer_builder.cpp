@@ -38,6 +38,13 @@ Timer::Builder& Timer::Builder::setAlarm(uint32_t count)
     return *this;
 }
 
+Timer::Builder& Timer::Builder::setAlarmPeriod(uint64_t periodNs)
+{
+    config.enableInterrupt = true;
+    config.periodNs = periodNs;
+    return *this;
+}
+
 Timer::Builder& Timer::Builder::oneShot()
 {
     config.oneShotAlarm = true;
@@ -68,7 +75,7 @@ Timer::Builder& Timer::Builder::timerSelection(TimerSelection timer)
     return *this;
 }
 
-void Timer::Builder::buildIn(Timer& target)
+DRIVER_RESULT(void) Timer::Builder::buildIn(Timer& target)
 {
     return target.init(config);
 }
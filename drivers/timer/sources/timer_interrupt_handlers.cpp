@@ -1,54 +1,78 @@
 #include "timer.hpp"
 #include "stm32f4xx.h"
 
+// ============================================================================
+// Vector table (RM0368 table 38): TIM1 has one vector per source group, three of them
+// shared with TIM9, TIM10 and TIM11, which route everything to theirs. Each handler
+// goes through its list of timers, and every timer only handles the flags of the vector.
+// ============================================================================
+
+namespace
+{
+    constexpr uint32_t ALL_SOURCES = TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF |
+                                     TIM_SR_COMIF | TIM_SR_TIF | TIM_SR_BIF;
+    constexpr uint32_t CAPTURE_COMPARE = TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF;
+
+    constexpr std::array<TimerInterruptSource, 2> TIM1_BRK_TIM9_SOURCES = {{
+        { TIMER_1, TIM_SR_BIF },
+        { TIMER_9, ALL_SOURCES },
+    }};
+
+    constexpr std::array<TimerInterruptSource, 2> TIM1_UP_TIM10_SOURCES = {{
+        { TIMER_1, TIM_SR_UIF },
+        { TIMER_10, ALL_SOURCES },
+    }};
+
+    constexpr std::array<TimerInterruptSource, 2> TIM1_TRG_COM_TIM11_SOURCES = {{
+        { TIMER_1, TIM_SR_TIF | TIM_SR_COMIF },
+        { TIMER_11, ALL_SOURCES },
+    }};
+
+    constexpr std::array<TimerInterruptSource, 1> TIM1_CC_SOURCES = {{ { TIMER_1, CAPTURE_COMPARE } }};
+    constexpr std::array<TimerInterruptSource, 1> TIM2_SOURCES = {{ { TIMER_2, ALL_SOURCES } }};
+    constexpr std::array<TimerInterruptSource, 1> TIM3_SOURCES = {{ { TIMER_3, ALL_SOURCES } }};
+    constexpr std::array<TimerInterruptSource, 1> TIM4_SOURCES = {{ { TIMER_4, ALL_SOURCES } }};
+    constexpr std::array<TimerInterruptSource, 1> TIM5_SOURCES = {{ { TIMER_5, ALL_SOURCES } }};
+}
+
 extern "C" {
     void TIM1_UP_TIM10_IRQHandler()
     {
-        auto timer = Timer::getDriver(TIMER_1);
-        timer->handleInterrupt();
-
-        // int count = TIM1->CNT;
-        // if (TIM1->SR & TIM_SR_UIF)
-        // {
-        //     TIM1->SR &= ~TIM_SR_UIF;
-        // }
+        Timer::dispatchInterrupt(TIM1_UP_TIM10_SOURCES);
     }
 
     void TIM1_BRK_TIM9_IRQHandler()
     {
-        // TODO
-        auto timer = Timer::getDriver(TIMER_9);
-        timer->handleInterrupt();
+        Timer::dispatchInterrupt(TIM1_BRK_TIM9_SOURCES);
     }
 
     void TIM1_TRG_COM_TIM11_IRQHandler()
     {
-        // TODO
-        auto timer = Timer::getDriver(TIMER_11);
-        timer->handleInterrupt();
+        Timer::dispatchInterrupt(TIM1_TRG_COM_TIM11_SOURCES);
     }
 
     void TIM1_CC_IRQHandler()
     {
-        // TODO
+        Timer::dispatchInterrupt(TIM1_CC_SOURCES);
     }
 
     void TIM2_IRQHandler()
     {
-        auto timer = Timer::getDriver(TIMER_2);
-        timer->handleInterrupt();
+        Timer::dispatchInterrupt(TIM2_SOURCES);
     }
 
     void TIM3_IRQHandler()
     {
-        auto timer = Timer::getDriver(TIMER_3);
-        timer->handleInterrupt();
+        Timer::dispatchInterrupt(TIM3_SOURCES);
     }
 
     void TIM4_IRQHandler()
     {
-        auto timer = Timer::getDriver(TIMER_4);
-        timer->handleInterrupt();
+        Timer::dispatchInterrupt(TIM4_SOURCES);
+    }
 
+    void TIM5_IRQHandler()
+    {
+        Timer::dispatchInterrupt(TIM5_SOURCES);
     }
 }
\ No newline at end of file
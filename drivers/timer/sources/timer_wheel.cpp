@@ -0,0 +1,353 @@
+#include "timer_wheel.hpp"
+
+#include "stm32f4xx.h"
+
+// ============================================================================
+// Hierarchical timing wheel — theory of operation
+//
+// Level k holds the timers expiring in [64^k, 64^(k+1)) ticks from `now`, in the slot
+// given by bits [6k, 6k+6) of their expiry tick. Level-0 slots expire as-is; a level-k
+// slot is "cascaded" (its timers re-inserted one level down, or more) when `now`
+// reaches the start of its 64^k block. Timers further than 64^4 ticks away sit in the
+// top level slot of now + 64^4 - 1 and are re-inserted until they get close enough.
+//
+// `occupied` keeps one bit per non-empty slot, so the next tick where anything happens
+// (an expiry or a cascade) is found with a rotate + count-trailing-zeros per level.
+// Nothing happens between `now` and that tick, which is what allows jumping straight to
+// it: the hardware alarm is armed for exactly that many ticks.
+//
+// The counter is never stopped once started, so the wheel doesn't lose the ticks that go
+// by while it's being reprogrammed. It counts down and reloads on its own (periodic
+// mode); `syncedCount` is the counter value that went with `now` when the wheel last
+// caught up (sync() or the alarm), and arm() takes whatever was counted since then off
+// the next delay. Only the few cycles between reading CNT and writing it back are lost.
+// ============================================================================
+
+namespace
+{
+    inline uint64_t rotateRight(uint64_t value, uint32_t shift)
+    {
+        shift &= 63;
+        return shift ? (value >> shift) | (value << (64 - shift)) : value;
+    }
+
+    // Saves and restores PRIMASK, so it nests inside ISRs and other critical sections.
+    class CriticalSection
+    {
+        private:
+            uint32_t primask;
+
+        public:
+            CriticalSection() : primask(__get_PRIMASK())
+            {
+                __disable_irq();
+            }
+
+            ~CriticalSection()
+            {
+                __set_PRIMASK(primask);
+            }
+    };
+}
+
+bool SoftTimer::isActive()
+{
+    return active;
+}
+
+TimerWheel::TimerWheel(Timer& timer)
+{
+    init(timer);
+}
+
+void TimerWheel::init(Timer& timer)
+{
+    this->timer = &timer;
+    timer.pause();
+    timer.setCallback(alarmCallback, this);
+    arm();
+}
+
+void TimerWheel::alarmCallback(void* argument)
+{
+    TimerWheel* wheel = static_cast<TimerWheel*>(argument);
+
+    // The counter reloaded with ARR (armedTicks) on the update event and went on.
+    wheel->syncedCount = wheel->armedTicks;
+    wheel->syncedPending = false;
+
+    wheel->advance(wheel->armedTicks);
+    wheel->arm();
+}
+
+void TimerWheel::start(SoftTimer& softTimer, uint32_t delayTicks, Timer::Callback callback, void* callbackArguments)
+{
+    schedule(softTimer, delayTicks, 0, callback, callbackArguments);
+}
+
+void TimerWheel::startPeriodic(SoftTimer& softTimer, uint32_t periodTicks, Timer::Callback callback, void* callbackArguments)
+{
+    schedule(softTimer, periodTicks, periodTicks, callback, callbackArguments);
+}
+
+void TimerWheel::schedule(SoftTimer& softTimer, uint32_t delayTicks, uint32_t periodTicks, Timer::Callback callback, void* callbackArguments)
+{
+    CriticalSection criticalSection;
+
+    sync();
+
+    if(softTimer.active)
+        unlink(softTimer);
+
+    softTimer.expiry = now + (delayTicks ? delayTicks : 1);
+    softTimer.period = periodTicks;
+    softTimer.callback = callback;
+    softTimer.callbackArguments = callbackArguments;
+    insert(softTimer);
+
+    arm();
+}
+
+void TimerWheel::cancel(SoftTimer& softTimer)
+{
+    CriticalSection criticalSection;
+
+    if(!softTimer.active)
+        return;
+
+    // No need to reprogram: at worst the alarm fires early and finds nothing to do.
+    unlink(softTimer);
+}
+
+uint32_t TimerWheel::getTicks()
+{
+    CriticalSection criticalSection;
+    uint32_t count;
+    bool pending;
+    return now + elapsedTicks(count, pending);
+}
+
+uint32_t TimerWheel::getTickPeriodUs()
+{
+    return timer->getPeriodUs();
+}
+
+void TimerWheel::insert(SoftTimer& softTimer)
+{
+    uint32_t delta = softTimer.expiry - now;
+    uint32_t slotTime = softTimer.expiry;
+
+    uint8_t level = 0;
+    while(level < TIMER_WHEEL_LEVELS - 1 && delta >= (1U << (TIMER_WHEEL_SLOT_BITS * (level + 1))))
+        level++;
+
+    // Beyond the wheel range: park it in the furthest top level slot.
+    constexpr uint32_t range = 1U << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS);
+    if(delta >= range)
+        slotTime = now + range - 1;
+
+    uint8_t slot = (slotTime >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+
+    SoftTimer*& head = slots[level][slot];
+    softTimer.previous = nullptr;
+    softTimer.next = head;
+    if(head)
+        head->previous = &softTimer;
+    head = &softTimer;
+
+    softTimer.level = level;
+    softTimer.slot = slot;
+    softTimer.active = true;
+    occupied[level] |= 1ULL << slot;
+}
+
+void TimerWheel::unlink(SoftTimer& softTimer)
+{
+    if(softTimer.previous)
+        softTimer.previous->next = softTimer.next;
+    else
+        slots[softTimer.level][softTimer.slot] = softTimer.next;
+
+    if(softTimer.next)
+        softTimer.next->previous = softTimer.previous;
+
+    if(!slots[softTimer.level][softTimer.slot])
+        occupied[softTimer.level] &= ~(1ULL << softTimer.slot);
+
+    softTimer.next = nullptr;
+    softTimer.previous = nullptr;
+    softTimer.active = false;
+}
+
+void TimerWheel::cascade(uint8_t level)
+{
+    uint8_t slot = (now >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+
+    SoftTimer* softTimer = slots[level][slot];
+    slots[level][slot] = nullptr;
+    occupied[level] &= ~(1ULL << slot);
+
+    while(softTimer)
+    {
+        SoftTimer* next = softTimer->next;
+        insert(*softTimer);
+        softTimer = next;
+    }
+}
+
+void TimerWheel::expire()
+{
+    uint8_t slot = now & (TIMER_WHEEL_SLOTS - 1);
+
+    // One at a time: a callback may cancel or restart any other timer, even in this slot.
+    while(SoftTimer* softTimer = slots[0][slot])
+    {
+        unlink(*softTimer);
+
+        if(softTimer->period)
+        {
+            softTimer->expiry += softTimer->period;
+            insert(*softTimer);
+        }
+
+        if(softTimer->callback)
+            softTimer->callback(softTimer->callbackArguments);
+    }
+}
+
+void TimerWheel::readCounter(uint32_t& count, bool& pending)
+{
+    // The update event may land between the two reads: CNT would be the reloaded value
+    // and not go with the flag read before it, so read both again (as Clock::getTicks()).
+    do
+    {
+        pending = timer->isAlarmPending();
+        count = timer->getCount();
+    }
+    while(pending != timer->isAlarmPending());
+}
+
+uint32_t TimerWheel::elapsedTicks(uint32_t& count, bool& pending)
+{
+    count = 0;
+    pending = false;
+    if(!armedTicks)
+        return 0;
+
+    readCounter(count, pending);
+
+    // Down-counting from armedTicks - 1 (see arm()), then from ARR = armedTicks again
+    // once the alarm went off.
+    if(pending)
+        return armedTicks + armedTicks - count;
+    return armedTicks - 1 - count;
+}
+
+void TimerWheel::sync()
+{
+    if(!armedTicks)
+        return;
+
+    // The counter keeps running: arm() accounts for what it counts from here on.
+    uint32_t elapsed = elapsedTicks(syncedCount, syncedPending);
+    catchUp(elapsed);
+}
+
+void TimerWheel::advance(uint32_t elapsed)
+{
+    now += elapsed;
+    armedTicks = 0;
+
+    // Safe to run on any tick up to the armed one: no slot is due before it, so a tick
+    // that isn't an event neither cascades an occupied slot nor expires anything.
+    for(uint8_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+    {
+        uint32_t blockMask = (1U << (TIMER_WHEEL_SLOT_BITS * level)) - 1;
+        if((now & blockMask) == 0)
+            cascade(level);
+    }
+
+    expire();
+}
+
+void TimerWheel::catchUp(uint32_t elapsed)
+{
+    // Past the alarm there may be more events before the current tick: advance() can't
+    // skip one, so go from event to event.
+    while(elapsed)
+    {
+        uint32_t delay = nextEventDelay();
+        if(!delay || delay > elapsed)
+            delay = elapsed;
+
+        advance(delay);
+        elapsed -= delay;
+    }
+}
+
+uint32_t TimerWheel::nextEventDelay()
+{
+    uint32_t best = 0;
+
+    for(uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    {
+        if(!occupied[level])
+            continue;
+
+        uint8_t shift = TIMER_WHEEL_SLOT_BITS * level;
+        uint32_t block = now >> shift;
+
+        // Bit i of `rotated` is the slot reached i + 1 blocks from now.
+        uint64_t rotated = rotateRight(occupied[level], (block + 1) & (TIMER_WHEEL_SLOTS - 1));
+        uint32_t eventTime = (block + 1 + __builtin_ctzll(rotated)) << shift;
+
+        uint32_t delay = eventTime - now;
+        if(!best || delay < best)
+            best = delay;
+    }
+
+    return best;
+}
+
+void TimerWheel::arm()
+{
+    // Ticks counted since syncedCount, already part of the delay. An update event since
+    // then (not seen by the sync) adds the rest of that period and the reload.
+    uint32_t counted = 0;
+    if(timer->isRunning())
+    {
+        uint32_t count;
+        bool pending;
+        readCounter(count, pending);
+        counted = pending && !syncedPending ? syncedCount + 1 + armedReload - count
+                                            : syncedCount - count;
+    }
+
+    // With nothing pending the timer keeps running over its full range, so getTicks()
+    // stays valid.
+    uint32_t maxCount = timer->getMaxCount();
+    uint32_t delay = nextEventDelay();
+    if(!delay || delay > maxCount)
+        delay = maxCount;
+
+    // Due already (the interrupt was held off for longer than the next delay): the
+    // callbacks run right here.
+    while(delay <= counted)
+    {
+        advance(delay);
+        counted -= delay;
+
+        delay = nextEventDelay();
+        if(!delay || delay > maxCount)
+            delay = maxCount;
+    }
+
+    // ARR can't be 0 (the counter stops), so count down from delay - 1 with ARR = delay:
+    // the update event comes exactly `delay` ticks after `now`.
+    armedTicks = delay;
+    armedReload = delay;
+    timer->setAlarm(delay);
+    timer->setCount(delay - 1 - counted);
+    timer->clearAlarmPending();
+    timer->start();
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/*
+ *  @brief Ownership of the DMA1/DMA2 streams, for the ones that more than one driver can
+ *  use (e.g. DMA1 stream 4: I2C3 TX and TIM3 CH1). A driver claims the stream before
+ *  programming it and releases it once it's disabled again. When the claim fails the
+ *  stream belongs to someone else and must not be touched, not even to disable it.
+ *
+ *  Lock-free (one atomic bit per stream), so it can be used from thread code and ISRs.
+ */
+class DmaStreams
+{
+    public:
+        /*
+         *  @return false if the stream is already claimed, by anyone (the caller included).
+         */
+        static bool claim(DMA_TypeDef* dma, uint32_t stream)
+        {
+            uint32_t bit = streamBit(dma, stream);
+            return !(claimed.fetch_or(bit, std::memory_order_acquire) & bit);
+        }
+
+        static void release(DMA_TypeDef* dma, uint32_t stream)
+        {
+            claimed.fetch_and(~streamBit(dma, stream), std::memory_order_release);
+        }
+
+        static bool isClaimed(DMA_TypeDef* dma, uint32_t stream)
+        {
+            return claimed.load(std::memory_order_relaxed) & streamBit(dma, stream);
+        }
+
+    private:
+        // Bits 0-7: DMA1 streams, bits 8-15: DMA2 streams.
+        static inline std::atomic<uint32_t> claimed = 0;
+
+        static uint32_t streamBit(DMA_TypeDef* dma, uint32_t stream)
+        {
+            return 1U << (stream + (dma == DMA2 ? 8 : 0));
+        }
+};
\ No newline at end of file
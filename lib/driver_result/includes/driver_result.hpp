@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ *  @brief Errors reported by the drivers and containers when built with
+ *  DRIVERS_NO_EXCEPTIONS. With exceptions enabled the equivalent exception is thrown.
+ */
+enum class DriverError : uint8_t
+{
+    None,
+    Full,
+    Empty,
+    OutOfRange,
+    AlreadyPresent,
+    InvalidArgument,
+    InvalidConfig,
+    InUse,
+    Hardware,
+};
+
+/*
+ *  @brief A value, or the error that prevented producing it. No heap, no exceptions.
+ */
+template <typename ValueType>
+class [[nodiscard]] Result
+{
+    private:
+        ValueType storedValue{};
+        DriverError storedError = DriverError::None;
+
+    public:
+        Result(const ValueType& value) : storedValue(value) {}
+        Result(DriverError error) : storedError(error) {}
+
+        bool ok() const { return storedError == DriverError::None; }
+        explicit operator bool() const { return ok(); }
+        DriverError error() const { return storedError; }
+
+        ValueType& value() { return storedValue; }
+        const ValueType& value() const { return storedValue; }
+        ValueType valueOr(const ValueType& fallback) const { return ok() ? storedValue : fallback; }
+};
+
+template <>
+class [[nodiscard]] Result<void>
+{
+    private:
+        DriverError storedError = DriverError::None;
+
+    public:
+        Result() = default;
+        Result(DriverError error) : storedError(error) {}
+
+        bool ok() const { return storedError == DriverError::None; }
+        explicit operator bool() const { return ok(); }
+        DriverError error() const { return storedError; }
+};
+
+using Status = Result<void>;
+
+// ============================================================================
+// One source for both builds:
+//   DRIVER_RESULT(T)          Return type of a fallible function: T, or Result<T>.
+//   DRIVER_FAIL(ret, exc)     throw exc, or return ret (a DriverError, or e.g. nullptr
+//                             for functions that keep a plain return type).
+//   return DRIVER_OK;         Success of a DRIVER_RESULT(void) function.
+//   DRIVER_TRY(expr)          Propagates the error of a DRIVER_RESULT(void) call.
+//   DRIVER_VALUE(expr)        Value of a DRIVER_RESULT(T) call known to succeed.
+// ============================================================================
+#ifdef DRIVERS_NO_EXCEPTIONS
+#define DRIVER_RESULT(Type) Result<Type>
+#define DRIVER_FAIL(returned, exception) return returned
+#define DRIVER_OK Status()
+#define DRIVER_TRY(expression) \
+    do { auto driverStatus = (expression); if(!driverStatus) return driverStatus.error(); } while(0)
+#define DRIVER_VALUE(expression) (expression).value()
+#else
+#define DRIVER_RESULT(Type) Type
+#define DRIVER_FAIL(returned, exception) throw exception
+#define DRIVER_OK void()
+#define DRIVER_TRY(expression) expression
+#define DRIVER_VALUE(expression) (expression)
+#endif
\ No newline at end of file
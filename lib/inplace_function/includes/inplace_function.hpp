@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 2 * sizeof(void*)>
+class InplaceFunction;
+
+/*
+ *  @brief Non-allocating replacement for std::function.
+ *
+ *  The callable is stored inside the object itself, in a buffer of `Capacity` bytes, so
+ *  building, copying and calling it never touches the heap and it's safe to use from an
+ *  ISR. Only trivially copyable callables fit: function pointers and lambdas capturing
+ *  pointers or plain values. Anything bigger than `Capacity` or owning resources
+ *  (std::function, std::string captures...) is rejected at compile time.
+ *
+ *  A default constructed or nullptr InplaceFunction is empty and converts to false.
+ */
+template <typename Return, typename... Args, size_t Capacity>
+class InplaceFunction<Return(Args...), Capacity>
+{
+    private:
+        using Invoker = Return (*)(const void* storage, Args... args);
+
+        alignas(void*) unsigned char storage[Capacity] = {};
+        Invoker invoker = nullptr;
+
+    public:
+        InplaceFunction() = default;
+
+        InplaceFunction(std::nullptr_t)
+        {
+
+        }
+
+        template <typename Callable,
+                  typename = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, InplaceFunction>>>
+        InplaceFunction(Callable callable)
+        {
+            static_assert(sizeof(Callable) <= Capacity,
+                          "Callable doesn't fit in the InplaceFunction, increase its Capacity.");
+            static_assert(alignof(Callable) <= alignof(void*),
+                          "Callable alignment not supported by InplaceFunction.");
+            static_assert(std::is_trivially_copyable_v<Callable> && std::is_trivially_destructible_v<Callable>,
+                          "InplaceFunction only stores trivially copyable callables (no owning captures).");
+
+            if constexpr (std::is_pointer_v<Callable>)
+            {
+                if(!callable)
+                    return;
+            }
+
+            new (storage) Callable(callable);
+            invoker = [](const void* storage, Args... args) -> Return
+            {
+                return (*static_cast<const Callable*>(storage))(std::forward<Args>(args)...);
+            };
+        }
+
+        Return operator()(Args... args) const
+        {
+            return invoker(storage, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const
+        {
+            return invoker != nullptr;
+        }
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// Cycle sources for IsrProfiler. A cycle source is any type with:
+//   static void enable();     // called once per profiler, must be idempotent
+//   static uint32_t now();    // free-running counter, differences are wrap-safe
+// ============================================================================
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+/*
+ *  @brief Cortex-M3/M4 DWT cycle counter (CPU clock cycles). The registers are part of
+ *  the ARMv7-M architecture, so no device header is needed.
+ */
+struct DwtCycleCounter
+{
+    static void enable()
+    {
+        volatile uint32_t* demcr = reinterpret_cast<volatile uint32_t*>(0xE000EDFC);
+        volatile uint32_t* dwtCtrl = reinterpret_cast<volatile uint32_t*>(0xE0001000);
+
+        *demcr = *demcr | (1U << 24);       // TRCENA
+        *dwtCtrl = *dwtCtrl | (1U << 0);    // CYCCNTENA
+    }
+
+    static uint32_t now()
+    {
+        return *reinterpret_cast<volatile uint32_t*>(0xE0001004);
+    }
+};
+
+using DefaultCycleCounter = DwtCycleCounter;
+
+#else
+
+#include <time.h>
+
+/*
+ *  @brief Host cycle source: CLOCK_MONOTONIC in nanoseconds, truncated to 32 bits.
+ */
+struct HostCycleCounter
+{
+    static void enable()
+    {
+
+    }
+
+    static uint32_t now()
+    {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<uint32_t>(time.tv_sec * 1000000000ULL + time.tv_nsec);
+    }
+};
+
+using DefaultCycleCounter = HostCycleCounter;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cycle_counter.hpp"
+
+#define ISR_PROFILER_BINS 16
+
+/*
+ *  @brief Execution time statistics of one interrupt path, in cycle source units.
+ *
+ *  histogram[i] counts the samples that took [2^(i-1), 2^i) cycles (bin 0: 0 cycles);
+ *  the last bin also holds everything longer.
+ */
+struct IsrStats
+{
+    uint32_t count = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t total = 0;
+    std::array<uint32_t, ISR_PROFILER_BINS> histogram = {};
+
+    uint32_t mean() const
+    {
+        return count ? static_cast<uint32_t>(total / count) : 0;
+    }
+};
+
+/*
+ *  @brief Fixed-size set of IsrStats, one per slot (e.g. per state of a state machine).
+ *
+ *  Recording is meant to run inside the profiled ISR. Reading the stats from thread
+ *  context while that ISR is active may return a sample that is being updated.
+ */
+template <size_t Slots, typename CycleCounter = DefaultCycleCounter>
+class IsrProfiler
+{
+    private:
+        std::array<IsrStats, Slots> stats;
+
+    public:
+        /*
+         *  @brief Measures the lifetime of the object and records it in a slot.
+         */
+        class Scope
+        {
+            private:
+                IsrProfiler& profiler;
+                size_t slot;
+                uint32_t start;
+
+            public:
+                Scope(IsrProfiler& profiler, size_t slot)
+                    : profiler(profiler), slot(slot), start(CycleCounter::now())
+                {
+
+                }
+
+                ~Scope()
+                {
+                    profiler.record(slot, CycleCounter::now() - start);
+                }
+        };
+
+        IsrProfiler()
+        {
+            CycleCounter::enable();
+        }
+
+        void record(size_t slot, uint32_t cycles)
+        {
+            IsrStats& entry = stats[slot];
+
+            entry.count++;
+            entry.total += cycles;
+            if(cycles < entry.min)
+                entry.min = cycles;
+            if(cycles > entry.max)
+                entry.max = cycles;
+
+            size_t bin = cycles ? 32 - __builtin_clz(cycles) : 0;
+            if(bin >= ISR_PROFILER_BINS)
+                bin = ISR_PROFILER_BINS - 1;
+            entry.histogram[bin]++;
+        }
+
+        const IsrStats& get(size_t slot) const
+        {
+            return stats[slot];
+        }
+
+        void reset()
+        {
+            stats.fill(IsrStats());
+        }
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "queue.hpp"
+
+template <typename ElementType>
+class IntrusiveQueue;
+
+/*
+ *  @brief Links embedded in every element of an IntrusiveQueue (inherit from it). An
+ *  element can be in a single queue at a time. Copies start unlinked.
+ */
+template <typename ElementType>
+class IntrusiveQueueNode
+{
+    private:
+        ElementType* next = nullptr;
+        ElementType* previous = nullptr;
+        IntrusiveQueue<ElementType>* owner = nullptr;
+
+    public:
+        IntrusiveQueueNode() = default;
+        IntrusiveQueueNode(const IntrusiveQueueNode&) {}
+        IntrusiveQueueNode& operator=(const IntrusiveQueueNode&) { return *this; }
+
+        bool isQueued() const;
+
+    friend class IntrusiveQueue<ElementType>;
+};
+
+/*
+ *  @brief FIFO of caller-owned elements linked through their own IntrusiveQueueNode: no
+ *  buffer, no depth limit, and O(1) enqueue, dequeue and remove (of any element).
+ *  Indexed access (peek(i), dequeue(i)) walks the list.
+ */
+template <typename ElementType>
+class IntrusiveQueue : public Queue<ElementType*>
+{
+    private:
+        ElementType* head = nullptr;
+        ElementType* tail = nullptr;
+        size_t count = 0;
+
+        void unlink(ElementType* element);
+
+    public:
+        /*
+         *  @throws std::logic_error: If the element is already in a queue.
+         */
+        DRIVER_RESULT(void) enqueue(ElementType* const element);
+
+        DRIVER_RESULT(ElementType*) dequeue();
+
+        DRIVER_RESULT(ElementType*) dequeue(uint16_t i);
+
+        ElementType** peek(uint16_t i);
+
+        ElementType** peek();
+
+        bool isEmpty() const;
+
+        bool hasData() const;
+
+        bool isFull() const;
+
+        size_t size() const;
+
+        bool remove(ElementType* const element);
+
+        size_t removeIf(bool (*match)(ElementType* const& element, void* context), void* context);
+};
+#include "intrusive_queue.tpp"
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdexcept>
+
+#include "intrusive_queue.hpp"
+
+template <typename ElementType>
+bool IntrusiveQueueNode<ElementType>::isQueued() const
+{
+    return owner != nullptr;
+}
+
+template <typename ElementType>
+void IntrusiveQueue<ElementType>::unlink(ElementType* element)
+{
+    IntrusiveQueueNode<ElementType>& node = *element;
+
+    if(node.previous)
+        static_cast<IntrusiveQueueNode<ElementType>&>(*node.previous).next = node.next;
+    else
+        head = node.next;
+
+    if(node.next)
+        static_cast<IntrusiveQueueNode<ElementType>&>(*node.next).previous = node.previous;
+    else
+        tail = node.previous;
+
+    node.next = nullptr;
+    node.previous = nullptr;
+    node.owner = nullptr;
+    --count;
+}
+
+template <typename ElementType>
+DRIVER_RESULT(void) IntrusiveQueue<ElementType>::enqueue(ElementType* const element)
+{
+    IntrusiveQueueNode<ElementType>& node = *element;
+    if(node.owner)
+        DRIVER_FAIL(DriverError::AlreadyPresent, std::logic_error("Element already queued."));
+
+    node.previous = tail;
+    node.next = nullptr;
+    node.owner = this;
+
+    if(tail)
+        static_cast<IntrusiveQueueNode<ElementType>&>(*tail).next = element;
+    else
+        head = element;
+
+    tail = element;
+    ++count;
+
+    return DRIVER_OK;
+}
+
+template <typename ElementType>
+DRIVER_RESULT(ElementType*) IntrusiveQueue<ElementType>::dequeue()
+{
+    if(isEmpty())
+        DRIVER_FAIL(DriverError::Empty, std::underflow_error("Queue is empty."));
+
+    ElementType* element = head;
+    unlink(element);
+    return element;
+}
+
+template <typename ElementType>
+DRIVER_RESULT(ElementType*) IntrusiveQueue<ElementType>::dequeue(uint16_t i)
+{
+    if(i >= count)
+        DRIVER_FAIL(DriverError::OutOfRange, std::out_of_range("Queue dequeue index out of range"));
+
+    ElementType* element = *peek(i);
+    unlink(element);
+    return element;
+}
+
+template <typename ElementType>
+ElementType** IntrusiveQueue<ElementType>::peek(uint16_t i)
+{
+    if(i >= count)
+        DRIVER_FAIL(nullptr, std::out_of_range("Queue peek index out of range"));
+
+    // The link pointing to the element: `head` or the `next` of the one before it.
+    ElementType** link = &head;
+    for(uint16_t j = 0; j < i; j++)
+        link = &static_cast<IntrusiveQueueNode<ElementType>&>(**link).next;
+
+    return link;
+}
+
+template <typename ElementType>
+ElementType** IntrusiveQueue<ElementType>::peek()
+{
+    if(isEmpty())
+        return nullptr;
+
+    return &head;
+}
+
+template <typename ElementType>
+bool IntrusiveQueue<ElementType>::isEmpty() const
+{
+    return count == 0;
+}
+
+template <typename ElementType>
+bool IntrusiveQueue<ElementType>::hasData() const
+{
+    return count > 0;
+}
+
+template <typename ElementType>
+bool IntrusiveQueue<ElementType>::isFull() const
+{
+    return false;
+}
+
+template <typename ElementType>
+size_t IntrusiveQueue<ElementType>::size() const
+{
+    return count;
+}
+
+template <typename ElementType>
+bool IntrusiveQueue<ElementType>::remove(ElementType* const element)
+{
+    if(static_cast<IntrusiveQueueNode<ElementType>&>(*element).owner != this)
+        return false;
+
+    unlink(element);
+    return true;
+}
+
+template <typename ElementType>
+size_t IntrusiveQueue<ElementType>::removeIf(bool (*match)(ElementType* const& element, void* context), void* context)
+{
+    size_t removed = 0;
+    ElementType* element = head;
+    while(element)
+    {
+        ElementType* next = static_cast<IntrusiveQueueNode<ElementType>&>(*element).next;
+        if(match(element, context))
+        {
+            unlink(element);
+            removed++;
+        }
+        element = next;
+    }
+    return removed;
+}
\ No newline at end of file
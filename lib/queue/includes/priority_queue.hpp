@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "queue.hpp"
+
+/*
+ *  @brief Fixed capacity priority queue (binary heap) behind the Queue interface.
+ *
+ *  Before(a, b) must return true when `a` has to be served before `b`. Elements that
+ *  compare equal are served in insertion order. peek()/dequeue() always refer to the
+ *  next element to serve; peek(i)/dequeue(i) walk the heap in storage order, which is
+ *  NOT the service order, and dequeue(i) may reorder the remaining elements.
+ */
+template <typename ElementType, size_t BufferSize, typename Before>
+class StaticPriorityQueue : public Queue<ElementType>
+{
+    private:
+        struct Entry
+        {
+            ElementType element;
+            uint32_t sequence;
+        };
+
+        std::array<Entry, BufferSize> heap;
+        size_t count = 0;
+        uint32_t nextSequence = 0;
+        Before before;
+
+        bool isBefore(const Entry& a, const Entry& b) const;
+
+        void siftUp(size_t i);
+
+        void siftDown(size_t i);
+
+    public:
+        DRIVER_RESULT(void) enqueue(const ElementType element);
+
+        DRIVER_RESULT(ElementType) dequeue();
+
+        DRIVER_RESULT(ElementType) dequeue(uint16_t i);
+
+        ElementType* peek(uint16_t i);
+
+        ElementType* peek();
+
+        bool isEmpty() const;
+
+        bool hasData() const;
+
+        bool isFull() const;
+
+        size_t size() const;
+};
+#include "priority_queue.tpp"
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <stdexcept>
+#include <utility>
+
+#include "priority_queue.hpp"
+
+template <typename ElementType, size_t BufferSize, typename Before>
+bool StaticPriorityQueue<ElementType, BufferSize, Before>::isBefore(const Entry& a, const Entry& b) const
+{
+    if(before(a.element, b.element))
+        return true;
+    if(before(b.element, a.element))
+        return false;
+
+    // Same priority: FIFO. Wrap-safe while less than 2^31 elements are enqueued in between.
+    return static_cast<int32_t>(a.sequence - b.sequence) < 0;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+void StaticPriorityQueue<ElementType, BufferSize, Before>::siftUp(size_t i)
+{
+    while(i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if(!isBefore(heap[i], heap[parent]))
+            return;
+
+        std::swap(heap[i], heap[parent]);
+        i = parent;
+    }
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+void StaticPriorityQueue<ElementType, BufferSize, Before>::siftDown(size_t i)
+{
+    while(true)
+    {
+        size_t first = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+
+        if(left < count && isBefore(heap[left], heap[first]))
+            first = left;
+        if(right < count && isBefore(heap[right], heap[first]))
+            first = right;
+
+        if(first == i)
+            return;
+
+        std::swap(heap[i], heap[first]);
+        i = first;
+    }
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+DRIVER_RESULT(void) StaticPriorityQueue<ElementType, BufferSize, Before>::enqueue(const ElementType element)
+{
+    if(isFull())
+        DRIVER_FAIL(DriverError::Full, std::overflow_error("Queue is full."));
+
+    heap[count] = { element, nextSequence++ };
+    siftUp(count++);
+
+    return DRIVER_OK;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+DRIVER_RESULT(ElementType) StaticPriorityQueue<ElementType, BufferSize, Before>::dequeue()
+{
+    if(isEmpty())
+        DRIVER_FAIL(DriverError::Empty, std::underflow_error("Queue is empty."));
+
+    return dequeue(0);
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+DRIVER_RESULT(ElementType) StaticPriorityQueue<ElementType, BufferSize, Before>::dequeue(uint16_t i)
+{
+    if(i >= count)
+        DRIVER_FAIL(DriverError::OutOfRange, std::out_of_range("Queue dequeue index out of range"));
+
+    auto element = heap[i].element;
+
+    --count;
+    if(i < count)
+    {
+        // Fill the hole with the last leaf, which may belong either above or below it.
+        heap[i] = heap[count];
+        siftUp(i);
+        siftDown(i);
+    }
+
+    return element;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+ElementType* StaticPriorityQueue<ElementType, BufferSize, Before>::peek(uint16_t i)
+{
+    if(i >= count)
+        DRIVER_FAIL(nullptr, std::out_of_range("Queue peek index out of range"));
+
+    return &heap[i].element;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+ElementType* StaticPriorityQueue<ElementType, BufferSize, Before>::peek()
+{
+    if(isEmpty())
+        return nullptr;
+
+    return &heap[0].element;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+bool StaticPriorityQueue<ElementType, BufferSize, Before>::isEmpty() const
+{
+    return count == 0;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+bool StaticPriorityQueue<ElementType, BufferSize, Before>::hasData() const
+{
+    return count > 0;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+bool StaticPriorityQueue<ElementType, BufferSize, Before>::isFull() const
+{
+    return count == BufferSize;
+}
+
+template <typename ElementType, size_t BufferSize, typename Before>
+size_t StaticPriorityQueue<ElementType, BufferSize, Before>::size() const
+{
+    return count;
+}
\ No newline at end of file
@@ -1,17 +1,24 @@
 #pragma once
 
 #include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver_result.hpp"
 
 template <typename ElementType>
 class Queue
 {
     public:
-        virtual void enqueue(const ElementType element) = 0;
+        virtual DRIVER_RESULT(void) enqueue(const ElementType element) = 0;
 
-        virtual ElementType dequeue() = 0;
+        virtual DRIVER_RESULT(ElementType) dequeue() = 0;
 
-        virtual ElementType dequeue(uint16_t i) = 0;
+        virtual DRIVER_RESULT(ElementType) dequeue(uint16_t i) = 0;
 
+        /*
+         *  @brief Without exceptions, nullptr when i is out of range.
+         */
         virtual ElementType* peek(uint16_t i) = 0;
 
         virtual ElementType* peek() = 0;
@@ -23,6 +30,48 @@ class Queue
         virtual bool isFull() const = 0;
 
         virtual size_t size() const = 0;
+
+        /*
+         *  @brief Removes the first occurrence of `element`, wherever it is.
+         */
+        virtual bool remove(const ElementType element)
+        {
+            for(uint16_t i = 0; i < size(); i++)
+            {
+                if(*peek(i) == element)
+                {
+                    (void)dequeue(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*
+         *  @brief Removes every element for which `match` returns true.
+         *
+         *  @return Number of elements removed.
+         */
+        virtual size_t removeIf(bool (*match)(const ElementType& element, void* context), void* context)
+        {
+            // Removing an element may reorder the rest (e.g. a heap), so rescan from the start.
+            size_t removed = 0;
+            uint16_t i = 0;
+            while(i < size())
+            {
+                if(match(*peek(i), context))
+                {
+                    (void)dequeue(i);
+                    removed++;
+                    i = 0;
+                }
+                else
+                {
+                    i++;
+                }
+            }
+            return removed;
+        }
 };
 
 template <typename ElementType, size_t BufferSize>
@@ -35,11 +84,11 @@ class StaticQueue : public Queue<ElementType>
         size_t count = 0;
 
     public:
-        void enqueue(const ElementType element);
+        DRIVER_RESULT(void) enqueue(const ElementType element);
 
-        ElementType dequeue();
+        DRIVER_RESULT(ElementType) dequeue();
 
-        ElementType dequeue(uint16_t i);
+        DRIVER_RESULT(ElementType) dequeue(uint16_t i);
 
         ElementType* peek(uint16_t i);
 
@@ -52,5 +101,7 @@ class StaticQueue : public Queue<ElementType>
         bool isFull() const;
 
         size_t size() const;
+
+        size_t removeIf(bool (*match)(const ElementType& element, void* context), void* context);
 };
 #include "queue.tpp"
\ No newline at end of file
@@ -3,21 +3,23 @@
 #include "queue.hpp"
 
 template <typename ElementType, size_t BufferSize>
-void StaticQueue<ElementType, BufferSize>::enqueue(const ElementType element)
+DRIVER_RESULT(void) StaticQueue<ElementType, BufferSize>::enqueue(const ElementType element)
 {
     if (isFull())
-        throw std::overflow_error("Queue is full.");
+        DRIVER_FAIL(DriverError::Full, std::overflow_error("Queue is full."));
 
     buffer[rear] = element;
     rear = (rear + 1) % BufferSize;
     ++count;
+
+    return DRIVER_OK;
 }
 
 template <typename ElementType, size_t BufferSize>
-ElementType StaticQueue<ElementType, BufferSize>::dequeue()
+DRIVER_RESULT(ElementType) StaticQueue<ElementType, BufferSize>::dequeue()
 {
     if(isEmpty())
-        throw std::underflow_error("Queue is empty.");
+        DRIVER_FAIL(DriverError::Empty, std::underflow_error("Queue is empty."));
 
     size_t position = front;
     front = (front + 1) % BufferSize;
@@ -27,10 +29,10 @@ ElementType StaticQueue<ElementType, BufferSize>::dequeue()
 }
 
 template <typename ElementType, size_t BufferSize>
-ElementType StaticQueue<ElementType, BufferSize>::dequeue(uint16_t i)
+DRIVER_RESULT(ElementType) StaticQueue<ElementType, BufferSize>::dequeue(uint16_t i)
 {
     if (i >= count)
-        throw std::out_of_range("Queue dequeue index out of range");
+        DRIVER_FAIL(DriverError::OutOfRange, std::out_of_range("Queue dequeue index out of range"));
 
     auto index = (front + i) % BufferSize;
     auto element = buffer[index];
@@ -52,7 +54,7 @@ template <typename ElementType, size_t BufferSize>
 ElementType* StaticQueue<ElementType, BufferSize>::peek(uint16_t i)
 {
     if (i >= count)
-        throw std::out_of_range("Queue peek index out of range");
+        DRIVER_FAIL(nullptr, std::out_of_range("Queue peek index out of range"));
 
     auto index = (front + i) % BufferSize;
     return &buffer[index];
@@ -89,4 +91,22 @@ template <typename ElementType, size_t BufferSize>
 size_t StaticQueue<ElementType, BufferSize>::size() const
 {
     return count;
+}
+
+template <typename ElementType, size_t BufferSize>
+size_t StaticQueue<ElementType, BufferSize>::removeIf(bool (*match)(const ElementType& element, void* context), void* context)
+{
+    // Single pass: the kept elements are compacted towards the front, in order.
+    size_t kept = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        auto& element = buffer[(front + i) % BufferSize];
+        if(!match(element, context))
+            buffer[(front + kept++) % BufferSize] = element;
+    }
+
+    size_t removed = count - kept;
+    count = kept;
+    rear = (front + count) % BufferSize;
+    return removed;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "queue.hpp"
+
+/*
+ *  @brief Lock-free single-producer/single-consumer ring buffer.
+ *
+ *  The producer only writes `tail` and the consumer only writes `head`, so one context
+ *  (e.g. thread code) can enqueue while another (e.g. an ISR) dequeues without masking
+ *  interrupts. Indices run free and are masked on access, hence the power of two size.
+ *
+ *  Producer side: enqueue(), tryEnqueue().
+ *  Consumer side: dequeue(), dequeue(i), tryDequeue(), peek(), peek(i), remove(),
+ *  removeIf().
+ *  isEmpty(), hasData(), isFull() and size() can be called from either side and are
+ *  exact only from the side that owns the index being compared.
+ *
+ *  Removing from the middle (dequeue(i), remove(), removeIf()) doesn't move elements, the
+ *  producer may be writing next to them: the slot is marked as removed (a tombstone) and
+ *  skipped once it reaches the front. It takes its slot until then.
+ *
+ *  It fits I2cBus::Builder::withQueue() when transactions are enqueued from a single
+ *  context: the bus dequeues from its ISRs and cancels with interrupts masked, both on
+ *  the consumer side.
+ *
+ *  The class is final so calls made through the concrete type are not virtual.
+ */
+template <typename ElementType, size_t BufferSize>
+class SpscQueue final : public Queue<ElementType>
+{
+    static_assert(BufferSize > 0 && (BufferSize & (BufferSize - 1)) == 0,
+                  "SpscQueue size must be a power of two.");
+
+    private:
+        static constexpr size_t mask = BufferSize - 1;
+
+        std::array<ElementType, BufferSize> buffer;
+        // Consumer owned, and cleared before the head moves past the slot. The slot at
+        // the head is never a tombstone.
+        std::array<bool, BufferSize> removed = {};
+        std::atomic<size_t> head = 0;
+        std::atomic<size_t> tail = 0;
+        // Tombstones between head and tail, for size().
+        std::atomic<size_t> removedCount = 0;
+
+        /*
+         *  @brief Free-running index of the i-th element, `currentTail` when there's none.
+         */
+        size_t indexOf(size_t currentHead, size_t currentTail, uint16_t i) const;
+
+        /*
+         *  @brief Removes the element at `index`, moving the head past the tombstones behind
+         *  it when it's the front one.
+         */
+        void removeAt(size_t currentHead, size_t currentTail, size_t index);
+
+    public:
+        DRIVER_RESULT(void) enqueue(const ElementType element);
+
+        bool tryEnqueue(const ElementType& element);
+
+        DRIVER_RESULT(ElementType) dequeue();
+
+        /*
+         *  @brief Removes the i-th element counting from the front. O(n), the tombstones
+         *  are skipped.
+         */
+        DRIVER_RESULT(ElementType) dequeue(uint16_t i);
+
+        bool tryDequeue(ElementType& element);
+
+        ElementType* peek(uint16_t i);
+
+        ElementType* peek();
+
+        bool isEmpty() const;
+
+        bool hasData() const;
+
+        /*
+         *  @brief No slot left for the producer, tombstones included.
+         */
+        bool isFull() const;
+
+        /*
+         *  @brief Elements in the queue, tombstones excluded.
+         */
+        size_t size() const;
+
+        bool remove(const ElementType element) override;
+
+        size_t removeIf(bool (*match)(const ElementType& element, void* context), void* context) override;
+};
+#include "spsc_queue.tpp"
@@ -0,0 +1,194 @@
+#include <stdexcept>
+
+#include "spsc_queue.hpp"
+
+template <typename ElementType, size_t BufferSize>
+bool SpscQueue<ElementType, BufferSize>::tryEnqueue(const ElementType& element)
+{
+    size_t currentTail = tail.load(std::memory_order_relaxed);
+    if(currentTail - head.load(std::memory_order_acquire) == BufferSize)
+        return false;
+
+    buffer[currentTail & mask] = element;
+    tail.store(currentTail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename ElementType, size_t BufferSize>
+DRIVER_RESULT(void) SpscQueue<ElementType, BufferSize>::enqueue(const ElementType element)
+{
+    if(!tryEnqueue(element))
+        DRIVER_FAIL(DriverError::Full, std::overflow_error("Queue is full."));
+
+    return DRIVER_OK;
+}
+
+template <typename ElementType, size_t BufferSize>
+size_t SpscQueue<ElementType, BufferSize>::indexOf(size_t currentHead, size_t currentTail, uint16_t i) const
+{
+    if(removedCount.load(std::memory_order_relaxed) == 0)
+        return i < currentTail - currentHead ? currentHead + i : currentTail;
+
+    for(size_t index = currentHead; index != currentTail; index++)
+    {
+        if(!removed[index & mask] && i-- == 0)
+            return index;
+    }
+    return currentTail;
+}
+
+template <typename ElementType, size_t BufferSize>
+void SpscQueue<ElementType, BufferSize>::removeAt(size_t currentHead, size_t currentTail, size_t index)
+{
+    size_t tombstones = removedCount.load(std::memory_order_relaxed);
+
+    if(index == currentHead && !tombstones)
+    {
+        head.store(index + 1, std::memory_order_release);
+        return;
+    }
+
+    if(index != currentHead)
+    {
+        removed[index & mask] = true;
+        removedCount.store(tombstones + 1, std::memory_order_release);
+        return;
+    }
+
+    size_t skipped = 0;
+    for(index++; index != currentTail && removed[index & mask]; index++)
+    {
+        removed[index & mask] = false;
+        skipped++;
+    }
+
+    // Count first: size() reads the head before the count, so it never sees the new head
+    // with tombstones it has already passed.
+    if(skipped)
+        removedCount.store(tombstones - skipped, std::memory_order_release);
+    head.store(index, std::memory_order_release);
+}
+
+template <typename ElementType, size_t BufferSize>
+bool SpscQueue<ElementType, BufferSize>::tryDequeue(ElementType& element)
+{
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    size_t currentTail = tail.load(std::memory_order_acquire);
+    if(currentHead == currentTail)
+        return false;
+
+    element = buffer[currentHead & mask];
+    removeAt(currentHead, currentTail, currentHead);
+    return true;
+}
+
+template <typename ElementType, size_t BufferSize>
+DRIVER_RESULT(ElementType) SpscQueue<ElementType, BufferSize>::dequeue()
+{
+    ElementType element;
+    if(!tryDequeue(element))
+        DRIVER_FAIL(DriverError::Empty, std::underflow_error("Queue is empty."));
+
+    return element;
+}
+
+template <typename ElementType, size_t BufferSize>
+DRIVER_RESULT(ElementType) SpscQueue<ElementType, BufferSize>::dequeue(uint16_t i)
+{
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    size_t currentTail = tail.load(std::memory_order_acquire);
+    size_t index = indexOf(currentHead, currentTail, i);
+    if(index == currentTail)
+        DRIVER_FAIL(DriverError::OutOfRange, std::out_of_range("Queue dequeue index out of range"));
+
+    auto element = buffer[index & mask];
+    removeAt(currentHead, currentTail, index);
+    return element;
+}
+
+template <typename ElementType, size_t BufferSize>
+ElementType* SpscQueue<ElementType, BufferSize>::peek(uint16_t i)
+{
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    size_t currentTail = tail.load(std::memory_order_acquire);
+    size_t index = indexOf(currentHead, currentTail, i);
+    if(index == currentTail)
+        DRIVER_FAIL(nullptr, std::out_of_range("Queue peek index out of range"));
+
+    return &buffer[index & mask];
+}
+
+template <typename ElementType, size_t BufferSize>
+ElementType* SpscQueue<ElementType, BufferSize>::peek()
+{
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    if(currentHead == tail.load(std::memory_order_acquire))
+        return nullptr;
+
+    return &buffer[currentHead & mask];
+}
+
+template <typename ElementType, size_t BufferSize>
+bool SpscQueue<ElementType, BufferSize>::isEmpty() const
+{
+    return size() == 0;
+}
+
+template <typename ElementType, size_t BufferSize>
+bool SpscQueue<ElementType, BufferSize>::hasData() const
+{
+    return size() > 0;
+}
+
+template <typename ElementType, size_t BufferSize>
+bool SpscQueue<ElementType, BufferSize>::isFull() const
+{
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire) == BufferSize;
+}
+
+template <typename ElementType, size_t BufferSize>
+size_t SpscQueue<ElementType, BufferSize>::size() const
+{
+    size_t currentHead = head.load(std::memory_order_acquire);
+    size_t tombstones = removedCount.load(std::memory_order_acquire);
+    return tail.load(std::memory_order_acquire) - currentHead - tombstones;
+}
+
+template <typename ElementType, size_t BufferSize>
+bool SpscQueue<ElementType, BufferSize>::remove(const ElementType element)
+{
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    size_t currentTail = tail.load(std::memory_order_acquire);
+
+    for(size_t index = currentHead; index != currentTail; index++)
+    {
+        if(!removed[index & mask] && buffer[index & mask] == element)
+        {
+            removeAt(currentHead, currentTail, index);
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename ElementType, size_t BufferSize>
+size_t SpscQueue<ElementType, BufferSize>::removeIf(bool (*match)(const ElementType& element, void* context), void* context)
+{
+    size_t currentTail = tail.load(std::memory_order_acquire);
+    size_t count = 0;
+
+    for(size_t index = head.load(std::memory_order_relaxed); index != currentTail; index++)
+    {
+        if(removed[index & mask] || !match(buffer[index & mask], context))
+            continue;
+
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        removeAt(currentHead, currentTail, index);
+        count++;
+
+        // Removing the front also skipped (and cleared) the tombstones right behind it.
+        if(index == currentHead)
+            index = head.load(std::memory_order_relaxed) - 1;
+    }
+    return count;
+}
@@ -1,39 +1,94 @@
 #pragma once
 
 #include <array>
+#include <functional>
+#include <limits>
 #include <stdexcept>
+#include <stdint.h>
+#include <type_traits>
+
+#include "driver_result.hpp"
 
 template <typename ElementType>
 class Set
 {
     public:
-        virtual void add(const ElementType& element) = 0;
+        virtual DRIVER_RESULT(void) add(const ElementType& element) = 0;
 
         virtual bool remove(const ElementType& element) = 0;
 
         virtual bool isFound(const ElementType& element) = 0;
 
-        virtual ElementType pop() = 0;
+        virtual DRIVER_RESULT(ElementType) pop() = 0;
 
         virtual size_t getLength() = 0;
+
+        virtual void clear() = 0;
+
+        /*
+         *  @brief Iteration over the elements, in no particular order. Invalidated by add(),
+         *  remove() and pop().
+         */
+        virtual const ElementType* begin() = 0;
+        virtual const ElementType* end() = 0;
 };
 
-template <typename ElementType, size_t BufferSize>
+/*
+ *  @brief Set with O(1) add, remove and lookup. The elements are kept packed in an array
+ *  (so they can be iterated) and an open-addressed hash table with tombstones maps each
+ *  one to its position. Removing moves the last element into the freed position.
+ */
+template <typename ElementType, size_t BufferSize, typename Hash = std::hash<ElementType>>
 class StaticSet : public Set<ElementType>
 {
     private:
+        static constexpr size_t getTableBits()
+        {
+            size_t bits = 1;
+            while((size_t(1) << bits) < 2 * BufferSize)
+                bits++;
+            return bits;
+        }
+
+        // At most half full with live elements, so probe sequences stay short.
+        static constexpr size_t TableBits = getTableBits();
+        static constexpr size_t TableSize = size_t(1) << TableBits;
+
+        // Table entries hold the element position + 1.
+        using Index = std::conditional_t<(BufferSize < UINT16_MAX), uint16_t, uint32_t>;
+        static constexpr Index EmptySlot = 0;
+        static constexpr Index Tombstone = std::numeric_limits<Index>::max();
+
         std::array<ElementType, BufferSize> buffer = {};
+        std::array<Index, TableSize> table = {};
         size_t count = 0;
+        size_t tombstones = 0;
+
+        size_t getHomeSlot(const ElementType& element);
+
+        // TableSize when the element isn't in the set.
+        size_t findSlot(const ElementType& element);
+
+        /*
+         *  @brief Drops the tombstones. Needed once they take up too much of the table,
+         *  otherwise a lookup of a missing element may never reach an empty slot.
+         */
+        void rebuild();
 
     public:
-        void add(const ElementType& element);
+        DRIVER_RESULT(void) add(const ElementType& element);
 
         bool remove(const ElementType& element);
 
         bool isFound(const ElementType& element);
 
-        ElementType pop();
+        DRIVER_RESULT(ElementType) pop();
 
         size_t getLength();
+
+        void clear();
+
+        const ElementType* begin();
+        const ElementType* end();
 };
 #include "set.tpp"
\ No newline at end of file
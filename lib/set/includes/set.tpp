@@ -1,58 +1,153 @@
 #pragma once
 
-#include <algorithm>
+#include <utility>
 
 #include "set.hpp"
 
-template <typename ElementType, size_t BufferSize>
-void StaticSet<ElementType, BufferSize>::add(const ElementType& element)
+template <typename ElementType, size_t BufferSize, typename Hash>
+size_t StaticSet<ElementType, BufferSize, Hash>::getHomeSlot(const ElementType& element)
 {
-    if(count >= BufferSize)
-        throw std::overflow_error("Set is full.");
+    // Fibonacci hashing: std::hash of a pointer is usually the address itself, whose
+    // low bits are all zero because of alignment.
+    uint64_t mixed = static_cast<uint64_t>(Hash{}(element)) * 0x9E3779B97F4A7C15ULL;
+    return mixed >> (64 - TableBits);
+}
 
-    if(isFound(element))
-        throw std::logic_error("Element already present.");
+template <typename ElementType, size_t BufferSize, typename Hash>
+size_t StaticSet<ElementType, BufferSize, Hash>::findSlot(const ElementType& element)
+{
+    for(size_t slot = getHomeSlot(element); ; slot = (slot + 1) & (TableSize - 1))
+    {
+        Index entry = table[slot];
+        if(entry == EmptySlot)
+            return TableSize;
 
-    buffer[count++] = element;
+        if(entry != Tombstone && buffer[entry - 1] == element)
+            return slot;
+    }
 }
 
-template <typename ElementType, size_t BufferSize>
-bool StaticSet<ElementType, BufferSize>::remove(const ElementType& element)
+template <typename ElementType, size_t BufferSize, typename Hash>
+void StaticSet<ElementType, BufferSize, Hash>::rebuild()
 {
-    for(std::size_t i = 0; i < count; ++i)
+    table.fill(EmptySlot);
+    tombstones = 0;
+
+    for(size_t i = 0; i < count; i++)
     {
-        if (buffer[i] == element)
+        size_t slot = getHomeSlot(buffer[i]);
+        while(table[slot] != EmptySlot)
+            slot = (slot + 1) & (TableSize - 1);
+        table[slot] = static_cast<Index>(i + 1);
+    }
+}
+
+template <typename ElementType, size_t BufferSize, typename Hash>
+DRIVER_RESULT(void) StaticSet<ElementType, BufferSize, Hash>::add(const ElementType& element)
+{
+    if(count >= BufferSize)
+        DRIVER_FAIL(DriverError::Full, std::overflow_error("Set is full."));
+
+    if(count + tombstones + 1 > TableSize * 3 / 4)
+        rebuild();
+
+    // Reuse the first tombstone on the way, but only after checking the whole probe
+    // sequence for a duplicate.
+    size_t freeSlot = TableSize;
+    for(size_t slot = getHomeSlot(element); ; slot = (slot + 1) & (TableSize - 1))
+    {
+        Index entry = table[slot];
+        if(entry == EmptySlot)
         {
-            count--;
-            // Move all elements to the left to fill out the space.
-            for (std::size_t j = i; j < count; j++)
-                buffer[j] = buffer[j + 1];
-            buffer[count] = nullptr;
+            if(freeSlot == TableSize)
+                freeSlot = slot;
+            break;
+        }
 
-            return true;
+        if(entry == Tombstone)
+        {
+            if(freeSlot == TableSize)
+                freeSlot = slot;
+        }
+        else if(buffer[entry - 1] == element)
+        {
+            DRIVER_FAIL(DriverError::AlreadyPresent, std::logic_error("Element already present."));
         }
     }
-    return false;
+
+    if(table[freeSlot] == Tombstone)
+        tombstones--;
+
+    buffer[count++] = element;
+    table[freeSlot] = static_cast<Index>(count);
+
+    return DRIVER_OK;
+}
+
+template <typename ElementType, size_t BufferSize, typename Hash>
+bool StaticSet<ElementType, BufferSize, Hash>::remove(const ElementType& element)
+{
+    size_t slot = findSlot(element);
+    if(slot == TableSize)
+        return false;
+
+    size_t position = table[slot] - 1;
+    table[slot] = Tombstone;
+    tombstones++;
+    count--;
+
+    // Fill the hole with the last element so the buffer stays packed.
+    if(position != count)
+    {
+        size_t lastSlot = findSlot(buffer[count]);
+        buffer[position] = std::move(buffer[count]);
+        table[lastSlot] = static_cast<Index>(position + 1);
+    }
+    buffer[count] = ElementType{};
+
+    return true;
 }
 
-template <typename ElementType, size_t BufferSize>
-bool StaticSet<ElementType, BufferSize>::isFound(const ElementType& element)
+template <typename ElementType, size_t BufferSize, typename Hash>
+bool StaticSet<ElementType, BufferSize, Hash>::isFound(const ElementType& element)
 {
-    return std::find(buffer.begin(), buffer.end(), element) != buffer.end();
+    return findSlot(element) != TableSize;
 }
 
-template <typename ElementType, size_t BufferSize>
-ElementType StaticSet<ElementType, BufferSize>::pop()
+template <typename ElementType, size_t BufferSize, typename Hash>
+DRIVER_RESULT(ElementType) StaticSet<ElementType, BufferSize, Hash>::pop()
 {
     if(count == 0)
-        throw std::underflow_error("Set is empty.");
+        DRIVER_FAIL(DriverError::Empty, std::underflow_error("Set is empty."));
 
-    count--;
-    return buffer[count];
+    ElementType element = buffer[count - 1];
+    remove(element);
+    return element;
 }
 
-template <typename ElementType, size_t BufferSize>
-size_t StaticSet<ElementType, BufferSize>::getLength()
+template <typename ElementType, size_t BufferSize, typename Hash>
+size_t StaticSet<ElementType, BufferSize, Hash>::getLength()
 {
     return count;
+}
+
+template <typename ElementType, size_t BufferSize, typename Hash>
+void StaticSet<ElementType, BufferSize, Hash>::clear()
+{
+    buffer.fill(ElementType{});
+    table.fill(EmptySlot);
+    count = 0;
+    tombstones = 0;
+}
+
+template <typename ElementType, size_t BufferSize, typename Hash>
+const ElementType* StaticSet<ElementType, BufferSize, Hash>::begin()
+{
+    return buffer.data();
+}
+
+template <typename ElementType, size_t BufferSize, typename Hash>
+const ElementType* StaticSet<ElementType, BufferSize, Hash>::end()
+{
+    return buffer.data() + count;
 }
\ No newline at end of file
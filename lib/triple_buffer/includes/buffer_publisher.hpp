@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ *  @brief Byte view of a multi-buffer publication scheme, for producers that fill raw
+ *  memory (a peripheral, a DMA stream): the producer fills writeBuffer() and calls
+ *  publish() when the contents are complete.
+ */
+class BufferPublisher
+{
+    public:
+        virtual uint8_t* writeBuffer() = 0;
+
+        virtual uint16_t bufferSize() const = 0;
+
+        /*
+         *  @brief Hands the filled buffer over to the readers.
+         *
+         *  @return The buffer to fill next.
+         */
+        virtual uint8_t* publish() = 0;
+};
\ No newline at end of file
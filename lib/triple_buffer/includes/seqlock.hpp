@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+/*
+ *  @brief Single writer publication of a value with one copy only, for values too big to
+ *  keep three of (see TripleBuffer). The writer never waits; a reader retries its copy
+ *  if a write happened meanwhile, so it can't be a context that preempts the writer (a
+ *  reader ISR preempting a writer thread would spin forever). The reader's copy does
+ *  race with the writer (race detectors report it); the sequence check throws away a
+ *  copy that overlapped a write.
+ */
+template <typename ElementType>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable_v<ElementType>, "Elements are copied as raw bytes.");
+
+    private:
+        ElementType value = {};
+        // Odd while a write is in progress.
+        std::atomic<uint32_t> sequence = 0;
+
+    public:
+        void write(const ElementType& newValue);
+
+        ElementType read() const;
+
+        /*
+         *  @brief Incremented twice per write, so a reader can tell whether the value
+         *  changed since it last looked.
+         */
+        uint32_t getSequence() const;
+};
+#include "seqlock.tpp"
\ No newline at end of file
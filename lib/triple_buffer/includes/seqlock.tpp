@@ -0,0 +1,38 @@
+#include "seqlock.hpp"
+
+template <typename ElementType>
+void Seqlock<ElementType>::write(const ElementType& newValue)
+{
+    uint32_t current = sequence.load(std::memory_order_relaxed);
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    value = newValue;
+
+    sequence.store(current + 2, std::memory_order_release);
+}
+
+template <typename ElementType>
+ElementType Seqlock<ElementType>::read() const
+{
+    ElementType copy;
+    uint32_t before;
+    uint32_t after;
+
+    do
+    {
+        before = sequence.load(std::memory_order_acquire);
+        copy = value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    }
+    while((before & 1) || before != after);
+
+    return copy;
+}
+
+template <typename ElementType>
+uint32_t Seqlock<ElementType>::getSequence() const
+{
+    return sequence.load(std::memory_order_acquire);
+}
\ No newline at end of file
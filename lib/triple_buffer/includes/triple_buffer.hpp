@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+#include "buffer_publisher.hpp"
+
+/*
+ *  @brief Lock-free single writer / single reader publication of the latest value.
+ *
+ *  Three copies of ElementType: the writer fills its back buffer and publishes it by
+ *  swapping it with the middle one; the reader swaps its front buffer with the middle one
+ *  only when a newer value was published. Neither side ever waits or masks interrupts,
+ *  and the reader never sees a value being written. Values published faster than they're
+ *  read are overwritten (the reader always gets the latest).
+ *
+ *  The writer may be an ISR and the reader thread code, or the other way around. Only
+ *  one context may write and only one may read.
+ */
+template <typename ElementType>
+class TripleBuffer : public BufferPublisher
+{
+    static_assert(std::is_trivially_copyable_v<ElementType>, "Elements are filled as raw bytes.");
+    static_assert(sizeof(ElementType) <= UINT16_MAX, "Buffer sizes are 16 bits.");
+
+    private:
+        // Index of the middle buffer, and whether it holds a value the reader hasn't taken.
+        static constexpr uint8_t INDEX_MASK = 0x3;
+        static constexpr uint8_t FRESH = 0x4;
+
+        std::array<ElementType, 3> buffers = {};
+        std::atomic<uint8_t> middle = 1;
+        uint8_t back = 0;       // Writer side
+        uint8_t front = 2;      // Reader side
+
+    public:
+        // Writer side
+
+        ElementType& writeValue();
+
+        void publish(const ElementType& value);
+
+        uint8_t* writeBuffer() override;
+
+        uint16_t bufferSize() const override;
+
+        uint8_t* publish() override;
+
+        // Reader side
+
+        /*
+         *  @brief Whether a value newer than the one returned by read() was published.
+         */
+        bool hasNewValue() const;
+
+        /*
+         *  @brief Latest published value (ElementType{} before the first one). Stays valid
+         *  and unchanged until the next read().
+         */
+        const ElementType& read();
+};
+#include "triple_buffer.tpp"
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "triple_buffer.hpp"
+
+template <typename ElementType>
+ElementType& TripleBuffer<ElementType>::writeValue()
+{
+    return buffers[back];
+}
+
+template <typename ElementType>
+void TripleBuffer<ElementType>::publish(const ElementType& value)
+{
+    buffers[back] = value;
+    publish();
+}
+
+template <typename ElementType>
+uint8_t* TripleBuffer<ElementType>::writeBuffer()
+{
+    return reinterpret_cast<uint8_t*>(&buffers[back]);
+}
+
+template <typename ElementType>
+uint16_t TripleBuffer<ElementType>::bufferSize() const
+{
+    return sizeof(ElementType);
+}
+
+template <typename ElementType>
+uint8_t* TripleBuffer<ElementType>::publish()
+{
+    // Release: the contents of the back buffer are visible before it becomes the middle.
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    return writeBuffer();
+}
+
+template <typename ElementType>
+bool TripleBuffer<ElementType>::hasNewValue() const
+{
+    return middle.load(std::memory_order_relaxed) & FRESH;
+}
+
+template <typename ElementType>
+const ElementType& TripleBuffer<ElementType>::read()
+{
+    // Acquire: pairs with publish(), the contents of the new front buffer are visible.
+    if(hasNewValue())
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+
+    return buffers[front];
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <functional>
+#include <stdlib.h>
+
+#include "host_bench.hpp"
+
+#include "i2c_transaction.hpp"
+#include "timer.hpp"
+
+// ============================================================================
+// The callbacks of I2cTransaction and Timer against the std::function they replaced: size
+// (in bytes and in pointers, which is what carries over to the 32 bit target), heap
+// allocations to build and copy one, and the cost of a call. The allocations are counted
+// by replacing the global operator new.
+// ============================================================================
+
+namespace
+{
+    size_t allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* memory = malloc(size ? size : 1);
+    if(!memory)
+        abort();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+namespace
+{
+    using StdCallback = std::function<void(void*)>;
+
+    // The three callbacks of a transaction, each with its parameter: before and now.
+    constexpr size_t STD_CALLBACKS = 3 * (sizeof(StdCallback) + sizeof(void*));
+    constexpr size_t I2C_CALLBACKS = 3 * (sizeof(I2cTransaction::Callback) + sizeof(void*));
+    static_assert(sizeof(I2cTransaction::Callback) == 2 * sizeof(void*));
+    static_assert(sizeof(Timer::Callback) == 3 * sizeof(void*));
+
+    void increment(void* counter)
+    {
+        ++*static_cast<uint64_t*>(counter);
+    }
+
+    template <typename Callback>
+    size_t countAllocations(const Callback& callback)
+    {
+        size_t before = allocations;
+        Callback copies[4] = { callback, callback, callback, callback };
+        benchKeep(copies);
+        return allocations - before;
+    }
+
+    // A call through each of 64 callbacks, so none of them can be inlined.
+    template <typename Callback>
+    double nsPerCall(const Callback& callback)
+    {
+        static Callback callbacks[64];
+        for(Callback& slot : callbacks)
+            slot = callback;
+        benchKeep(callbacks);
+
+        constexpr uint64_t CALLS = 1 << 24;
+        uint64_t counter = 0;
+        return benchNsPerOp(CALLS, [&]
+        {
+            for(uint64_t i = 0; i < CALLS; i++)
+                callbacks[i % 64](&counter);
+            benchKeep(counter);
+        });
+    }
+
+    void printSize(const char* name, size_t bytes)
+    {
+        printf("%-44s %6zu bytes %6zu pointers\n", name, bytes, bytes / sizeof(void*));
+    }
+}
+
+int main()
+{
+    printf("sizes on this host\n");
+    printSize("void (*)(void*)", sizeof(void (*)(void*)));
+    printSize("std::function<void(void*)>", sizeof(StdCallback));
+    printSize("Timer::Callback", sizeof(Timer::Callback));
+    printSize("I2cTransaction::Callback", sizeof(I2cTransaction::Callback));
+    printSize("I2cTransaction callbacks, std::function", STD_CALLBACKS);
+    printSize("I2cTransaction callbacks, now", I2C_CALLBACKS);
+    printSize("I2cTransaction", sizeof(I2cTransaction));
+    printSize("I2cTransaction with std::function callbacks", sizeof(I2cTransaction) - I2C_CALLBACKS + STD_CALLBACKS);
+
+    // A lambda capturing three pointers, too big for std::function's small buffer.
+    void* a = &allocations;
+    void* b = &a;
+    void* c = &b;
+    auto wide = [a, b, c](void* counter) { increment(counter); benchKeep(a); benchKeep(b); benchKeep(c); };
+    auto narrow = [a](void* counter) { increment(counter); benchKeep(a); };
+
+    printf("\nheap allocations for 4 copies\n");
+    printf("%-44s %6zu\n", "std::function, function pointer", countAllocations(StdCallback(increment)));
+    printf("%-44s %6zu\n", "std::function, 3 pointer lambda", countAllocations(StdCallback(wide)));
+    printf("%-44s %6zu\n", "I2cTransaction::Callback, function pointer",
+           countAllocations(I2cTransaction::Callback(increment)));
+    printf("%-44s %6zu\n", "I2cTransaction::Callback, 1 pointer lambda",
+           countAllocations(I2cTransaction::Callback(narrow)));
+    printf("%-44s %6zu\n", "Timer::Callback, 2 pointer lambda",
+           countAllocations(Timer::Callback([a, b](void* counter) { increment(counter); benchKeep(a); benchKeep(b); })));
+
+    printf("\nns per call\n");
+    printf("%-44s %6.2f\n", "void (*)(void*)", nsPerCall<void (*)(void*)>(increment));
+    printf("%-44s %6.2f\n", "std::function, function pointer", nsPerCall(StdCallback(increment)));
+    printf("%-44s %6.2f\n", "std::function, 3 pointer lambda", nsPerCall(StdCallback(wide)));
+    printf("%-44s %6.2f\n", "I2cTransaction::Callback, function pointer", nsPerCall(I2cTransaction::Callback(increment)));
+    printf("%-44s %6.2f\n", "Timer::Callback, function pointer", nsPerCall(Timer::Callback(increment)));
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+// ============================================================================
+// Timing helpers of the host benchmarks. The figures are host nanoseconds: they compare
+// implementations with each other, not with the MCU.
+// ============================================================================
+
+/*
+ *  @brief Keeps `value` (and what it was computed from) from being optimized away.
+ */
+template <typename Type>
+inline void benchKeep(const Type& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+/*
+ *  @brief Nanoseconds per operation: the best of `repeats` runs of `body`, which performs
+ *  `operations` operations per run.
+ */
+template <typename Body>
+double benchNsPerOp(uint64_t operations, Body&& body, int repeats = 5)
+{
+    double best = 0;
+    for(int run = 0; run < repeats; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        double perOperation = elapsed.count() / operations;
+        if(run == 0 || perOperation < best)
+            best = perOperation;
+    }
+    return best;
+}
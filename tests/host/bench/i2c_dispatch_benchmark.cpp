@@ -0,0 +1,247 @@
+#include <cxxabi.h>
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "host_bench.hpp"
+#include "host_mcu.hpp"
+
+#include "i2c_bus_static.hpp"
+
+// ============================================================================
+// The I2C event vector against the dispatch it replaced: handleInterrupt(bus, type)
+// looking the driver up through getBusDriverNumber() and switching on the interrupt
+// type, then eventCallback() switching on the state and eventMasterCallback() switching
+// on it again. Both call the same out-of-line state handlers of the driver library.
+//
+// Code size comes from the symbol table of this executable (host x86-64 bytes, not
+// Thumb-2), the cost from calling the vector with the bus in a state whose handler has
+// nothing to do: Idle without a slave, and ReceiveDataDma (the DMA interrupt drives it).
+// ============================================================================
+
+namespace
+{
+    class DispatchBus : public I2cBus
+    {
+        private:
+            StaticQueue<I2cTransaction*, 4> queue;
+            StaticSet<I2cDevice*, 2> devicesSet;
+
+        public:
+            DRIVER_RESULT(void) init(Config& config)
+            {
+                config.queue = &queue;
+                config.devicesSet = &devicesSet;
+                return I2cBus::init(config);
+            }
+
+            void setState(State newState)
+            {
+                state = newState;
+            }
+
+            // The former code, split the way its translation units were: the vectors,
+            // handleInterrupt() with eventCallback(), and eventMasterCallback().
+            [[gnu::noinline]] static void legacyVector();
+            [[gnu::noinline]] static void legacyHandleInterrupt(Selection bus, InterruptType type) noexcept;
+            void legacyEventCallback();
+            [[gnu::noinline]] void legacyEventMasterCallback();
+    };
+
+    void DispatchBus::legacyVector()
+    {
+        legacyHandleInterrupt(Selection::Bus1, InterruptType::Event);
+    }
+
+    void DispatchBus::legacyHandleInterrupt(Selection bus, InterruptType type) noexcept
+    {
+        DispatchBus* driver = static_cast<DispatchBus*>(drivers[getBusDriverNumber(bus)]);
+        if(driver)
+        {
+            switch(type)
+            {
+            case InterruptType::Event:
+                driver->legacyEventCallback();
+                break;
+            case InterruptType::Error:
+                driver->errorCallback();
+                break;
+            case InterruptType::DmaRx:
+                driver->dmaRxCallback();
+                break;
+            }
+        }
+    }
+
+    void DispatchBus::legacyEventCallback()
+    {
+        switch(state)
+        {
+            case State::Idle:
+            case State::SlaveTransmit:
+            case State::SlaveReceive:
+                eventSlaveCallback();
+                break;
+
+            case State::StartAttempt:
+            case State::SendSlaveAddress:
+            case State::SendRegister:
+            case State::SendData:
+            case State::SendLastDataByte:
+            case State::LastRegisterByte:
+            case State::RepeatedStart:
+            case State::RepeatedStartAckAddr:
+            case State::ReceiveData:
+            case State::SendDataDma:
+            case State::ReceiveDataDma:
+                legacyEventMasterCallback();
+                break;
+        }
+    }
+
+    void DispatchBus::legacyEventMasterCallback()
+    {
+        switch(state)
+        {
+            case State::Idle:
+                break;
+            case State::StartAttempt:
+                masterStateStartAttemp();
+                break;
+            case State::SendSlaveAddress:
+                masterStateSendSlaveAddress();
+                break;
+            case State::SendRegister:
+                masterStateSendRegister();
+                break;
+            case State::SendData:
+                masterStateSendData();
+                break;
+            case State::SendLastDataByte:
+                masterStateSendLastDataByte();
+                break;
+            case State::LastRegisterByte:
+                masterStateSendLastRegisterByte();
+                break;
+            case State::RepeatedStart:
+                masterStateRepeatedStart();
+                break;
+            case State::RepeatedStartAckAddr:
+                masterStateRepeatedStartAckAddr();
+                break;
+            case State::ReceiveData:
+                masterStateReceiveData();
+                break;
+            case State::SendDataDma:
+                masterStateSendDataDma();
+                break;
+            case State::ReceiveDataDma:
+                break;
+            default:
+                break;
+        }
+    }
+
+    /*
+     *  @brief Size of the first function (or object) of this executable whose demangled
+     *  name contains `name`, from its ELF symbol table. 0 if there's none.
+     */
+    size_t symbolSize(const char* name, unsigned type = STT_FUNC)
+    {
+        FILE* file = fopen("/proc/self/exe", "rb");
+        if(!file)
+            return 0;
+
+        std::vector<char> image;
+        char chunk[65536];
+        size_t read;
+        while((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+            image.insert(image.end(), chunk, chunk + read);
+        fclose(file);
+
+        const Elf64_Ehdr* header = reinterpret_cast<const Elf64_Ehdr*>(image.data());
+        const Elf64_Shdr* sections = reinterpret_cast<const Elf64_Shdr*>(image.data() + header->e_shoff);
+        for(size_t i = 0; i < header->e_shnum; i++)
+        {
+            if(sections[i].sh_type != SHT_SYMTAB)
+                continue;
+
+            const Elf64_Sym* symbols = reinterpret_cast<const Elf64_Sym*>(image.data() + sections[i].sh_offset);
+            const char* names = image.data() + sections[sections[i].sh_link].sh_offset;
+            for(size_t j = 0; j < sections[i].sh_size / sizeof(Elf64_Sym); j++)
+            {
+                if(ELF64_ST_TYPE(symbols[j].st_info) != type)
+                    continue;
+
+                int status = 0;
+                char* demangled = abi::__cxa_demangle(names + symbols[j].st_name, nullptr, nullptr, &status);
+                bool found = strstr(status == 0 ? demangled : names + symbols[j].st_name, name) != nullptr;
+                free(demangled);
+                if(found)
+                    return symbols[j].st_size;
+            }
+        }
+        return 0;
+    }
+
+    void printSize(const char* name, size_t bytes)
+    {
+        printf("  %-40s %6zu\n", name, bytes);
+    }
+
+    constexpr uint64_t CALLS = 1 << 24;
+
+    template <typename Vector>
+    double nsPerInterrupt(Vector vector)
+    {
+        return benchNsPerOp(CALLS, [&]
+        {
+            for(uint64_t i = 0; i < CALLS; i++)
+                vector();
+        });
+    }
+}
+
+int main()
+{
+    HostMcu::reset();
+    DispatchBus bus;
+    I2cBus::Builder builder;
+    builder.withBusSelection(I2cBus::Selection::Bus1).setBusSpeed(400000);
+    I2cBus::Config config = builder.buildConfig();
+    (void)bus.init(config);
+
+    size_t vector = symbolSize("I2C1_EV_IRQHandler");
+    size_t eventCallback = symbolSize("I2cBus::eventCallback()");
+    size_t table = symbolSize("I2cBus::eventCallback()::handlers", STT_OBJECT);
+    size_t legacyVector = symbolSize("DispatchBus::legacyVector()");
+    size_t legacyHandleInterrupt = symbolSize("DispatchBus::legacyHandleInterrupt(");
+    size_t legacyEventCallback = symbolSize("DispatchBus::legacyEventCallback()");
+    size_t legacyEventMasterCallback = symbolSize("DispatchBus::legacyEventMasterCallback()");
+
+    printf("event dispatch code, host bytes (switch jump tables not counted)\n");
+    printf("former\n");
+    printSize("vector", legacyVector);
+    printSize("handleInterrupt(bus, type)", legacyHandleInterrupt);
+    printSize("eventCallback() (inlined if 0)", legacyEventCallback);
+    printSize("eventMasterCallback()", legacyEventMasterCallback);
+    printSize("total", legacyVector + legacyHandleInterrupt + legacyEventCallback + legacyEventMasterCallback);
+    printf("current\n");
+    printSize("I2C1_EV_IRQHandler (handleInterrupt<>)", vector);
+    printSize("eventCallback()", eventCallback);
+    printSize("total", vector + eventCallback);
+    printSize("handler table (data)", table);
+
+    printf("\nns per event interrupt, handler with nothing to do\n");
+    printf("%-16s %10s %10s\n", "state", "former", "current");
+    for(I2cBus::State state : { I2cBus::State::Idle, I2cBus::State::ReceiveDataDma })
+    {
+        bus.setState(state);
+        double legacy = nsPerInterrupt(DispatchBus::legacyVector);
+        double current = nsPerInterrupt(I2C1_EV_IRQHandler);
+        printf("%-16s %10.2f %10.2f\n", state == I2cBus::State::Idle ? "Idle" : "ReceiveDataDma", legacy, current);
+    }
+    bus.setState(I2cBus::State::Idle);
+    return 0;
+}
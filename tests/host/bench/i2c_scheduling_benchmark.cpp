@@ -0,0 +1,156 @@
+#include "host_bench.hpp"
+#include "host_mcu.hpp"
+
+#include "i2c_bus_static.hpp"
+#include "i2c_device.hpp"
+
+// ============================================================================
+// Queueing latency of a high priority read on a saturated bus, FIFO against priority
+// scheduling: bulk 32 byte writes (a display refresh) keep the queue full, and a 2 byte
+// read (an ADC sample) is enqueued at random points of their transfers. The figures are
+// model steps from the enqueue to the end of the read, the same for both queues on the
+// same wire, so they compare the schedulers exactly. The busy-retry is polled every step.
+// ============================================================================
+
+namespace
+{
+    constexpr uint16_t DISPLAY_ADDRESS = 0x3C;
+    constexpr uint16_t ADC_ADDRESS = 0x48;
+    constexpr size_t BULK_COUNT = 8;
+    constexpr uint16_t BULK_BYTES = 32;
+    constexpr int SAMPLES = 500;
+
+    struct Figures
+    {
+        uint32_t bulkSteps;
+        uint32_t min;
+        double mean;
+        uint32_t max;
+    };
+
+    uint32_t nextGap(uint32_t& state, uint32_t range)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % range;
+    }
+
+    void recordEnd(void* argument)
+    {
+        *static_cast<uint32_t*>(argument) = HostMcu::steps;
+    }
+
+    template <bool PriorityScheduling>
+    Figures measure()
+    {
+        HostMcu::reset();
+        RegisterSlave display;
+        RegisterSlave adc;
+        HostI2c& wire = HostI2c::of(I2C1);
+        wire.detachAll();
+        wire.attach(DISPLAY_ADDRESS, display);
+        wire.attach(ADC_ADDRESS, adc);
+
+        I2cBusStatic<BULK_COUNT + 1, 2, PriorityScheduling> bus;
+        I2cBus::Builder builder;
+        builder.withBusSelection(I2cBus::Selection::Bus1).setBusSpeed(400000);
+        I2cBus::Config config = builder.buildConfig();
+        (void)bus.init(config);
+        I2cDevice displayDevice(DISPLAY_ADDRESS, &bus);
+        I2cDevice adcDevice(ADC_ADDRESS, &bus);
+
+        static uint8_t frame[BULK_COUNT][BULK_BYTES];
+        I2cTransaction bulk[BULK_COUNT];
+        for(size_t i = 0; i < BULK_COUNT; i++)
+        {
+            bulk[i] = I2cTransaction::Builder()
+                .setDirection(I2cTransaction::TX)
+                .withRegister(0x40)
+                .withData(frame[i], BULK_BYTES)
+                .build();
+        }
+
+        uint8_t sample[2];
+        uint32_t readEnd = 0;
+        I2cTransaction read = I2cTransaction::Builder()
+            .setDirection(I2cTransaction::RX)
+            .withRegister(0x10)
+            .withData(sample, sizeof(sample))
+            .withPriority(7)
+            .withPostCallback(recordEnd, &readEnd)
+            .build();
+
+        // One step of the saturated bus: finished bulk writes go back in the queue.
+        auto step = [&]
+        {
+            HostMcu::step();
+            for(I2cTransaction& transaction : bulk)
+            {
+                if(transaction.getState() == I2cTransaction::FINISHED)
+                {
+                    transaction.setState(I2cTransaction::IDLE);
+                    displayDevice << transaction;
+                }
+            }
+            if(bus.getState() == I2cBus::State::Idle)
+                (void)bus.verifyPendingTransaction();
+        };
+
+        for(I2cTransaction& transaction : bulk)
+            displayDevice << transaction;
+
+        // A bulk write alone on the wire, for scale.
+        uint32_t transfers = display.transfers;
+        while(display.transfers < transfers + 2)
+            step();
+        uint32_t start = HostMcu::steps;
+        while(display.transfers < transfers + 3)
+            step();
+
+        Figures figures = { HostMcu::steps - start, UINT32_MAX, 0, 0 };
+        uint32_t state = 0x2545F491;
+        uint64_t total = 0;
+        for(int i = 0; i < SAMPLES; i++)
+        {
+            uint32_t gap = nextGap(state, figures.bulkSteps);
+            for(uint32_t j = 0; j < gap; j++)
+                step();
+
+            uint32_t enqueued = HostMcu::steps;
+            readEnd = 0;
+            adcDevice << read;
+            while(!readEnd)
+                step();
+
+            uint32_t latency = readEnd - enqueued;
+            total += latency;
+            if(latency < figures.min)
+                figures.min = latency;
+            if(latency > figures.max)
+                figures.max = latency;
+        }
+        figures.mean = static_cast<double>(total) / SAMPLES;
+        return figures;
+    }
+
+    void print(const char* name, const Figures& figures)
+    {
+        printf("%-10s %10u %10.1f %10u %12.2f\n", name, figures.min, figures.mean, figures.max,
+               static_cast<double>(figures.max) / figures.bulkSteps);
+    }
+}
+
+int main()
+{
+    Figures fifo = measure<false>();
+    Figures priority = measure<true>();
+
+    printf("2 byte read behind %zu queued %u byte writes, model steps from enqueue to end\n",
+           BULK_COUNT, BULK_BYTES);
+    printf("one %u byte write: %u steps\n", BULK_BYTES, fifo.bulkSteps);
+    printf("%-10s %10s %10s %10s %12s\n", "queue", "min", "mean", "max", "max/write");
+    print("FIFO", fifo);
+    print("priority", priority);
+    return 0;
+}
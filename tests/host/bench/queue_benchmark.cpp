@@ -0,0 +1,125 @@
+#include <mutex>
+#include <thread>
+
+#include "host_bench.hpp"
+
+#include "queue.hpp"
+#include "spsc_queue.hpp"
+
+// ============================================================================
+// SpscQueue against StaticQueue:
+// - Same thread: bursts of enqueues then dequeues, through the concrete type and through
+//   Queue<T>& (what I2cBus sees).
+// - Handoff between a producer and a consumer thread. StaticQueue needs a lock, the
+//   host counterpart of masking interrupts around it on the MCU.
+// ============================================================================
+
+namespace
+{
+    constexpr size_t SIZE = 64;
+    constexpr uint32_t BURST = SIZE / 2;
+    constexpr uint32_t ROUNDS = 200000;
+    constexpr uint32_t HANDOFF_COUNT = 5000000;
+
+    template <typename QueueType>
+    double sameThread(QueueType& queue)
+    {
+        return benchNsPerOp(2ull * BURST * ROUNDS, [&]
+        {
+            uint32_t sum = 0;
+            for(uint32_t round = 0; round < ROUNDS; round++)
+            {
+                for(uint32_t i = 0; i < BURST; i++)
+                    (void)queue.enqueue(i);
+                for(uint32_t i = 0; i < BURST; i++)
+                    sum += DRIVER_VALUE(queue.dequeue());
+            }
+            benchKeep(sum);
+        });
+    }
+
+    double handoffSpsc()
+    {
+        SpscQueue<uint32_t, SIZE> queue;
+        return benchNsPerOp(HANDOFF_COUNT, [&]
+        {
+            std::thread producer([&]
+            {
+                for(uint32_t value = 0; value < HANDOFF_COUNT; value++)
+                {
+                    while(!queue.tryEnqueue(value))
+                        std::this_thread::yield();
+                }
+            });
+
+            uint32_t value = 0;
+            uint64_t sum = 0;
+            for(uint32_t received = 0; received < HANDOFF_COUNT;)
+            {
+                if(!queue.tryDequeue(value))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                sum += value;
+                received++;
+            }
+            producer.join();
+            benchKeep(sum);
+        }, 3);
+    }
+
+    double handoffLocked()
+    {
+        StaticQueue<uint32_t, SIZE> queue;
+        std::mutex lock;
+        return benchNsPerOp(HANDOFF_COUNT, [&]
+        {
+            std::thread producer([&]
+            {
+                for(uint32_t value = 0; value < HANDOFF_COUNT;)
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    if(queue.isFull())
+                    {
+                        guard.unlock();
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    (void)queue.enqueue(value++);
+                }
+            });
+
+            uint64_t sum = 0;
+            for(uint32_t received = 0; received < HANDOFF_COUNT;)
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                if(queue.isEmpty())
+                {
+                    guard.unlock();
+                    std::this_thread::yield();
+                    continue;
+                }
+                sum += DRIVER_VALUE(queue.dequeue());
+                received++;
+            }
+            producer.join();
+            benchKeep(sum);
+        }, 3);
+    }
+}
+
+int main()
+{
+    StaticQueue<uint32_t, SIZE> staticQueue;
+    SpscQueue<uint32_t, SIZE> spscQueue;
+    Queue<uint32_t>& staticBase = staticQueue;
+    Queue<uint32_t>& spscBase = spscQueue;
+
+    printf("queue of %zu uint32_t, ns per operation\n", SIZE);
+    printf("%-36s %10s %10s\n", "", "StaticQueue", "SpscQueue");
+    printf("%-36s %10.2f %10.2f\n", "same thread, concrete type", sameThread(staticQueue), sameThread(spscQueue));
+    printf("%-36s %10.2f %10.2f\n", "same thread, through Queue<T>&", sameThread(staticBase), sameThread(spscBase));
+    printf("%-36s %10.2f %10.2f\n", "two threads (StaticQueue locked)", handoffLocked(), handoffSpsc());
+    return 0;
+}
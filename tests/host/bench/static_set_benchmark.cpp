@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "host_bench.hpp"
+
+#include "set.hpp"
+
+// ============================================================================
+// StaticSet against the linear set it replaced, full of N pointers (what I2cBus keeps its
+// devices in): lookups of present and missing elements, and a remove then add of the
+// same element, spread over the whole set.
+// ============================================================================
+
+namespace
+{
+    // The former StaticSet (with its errors reported the current way): unsorted array,
+    // linear scans, remove() shifts the tail.
+    template <typename ElementType, size_t BufferSize>
+    class LinearSet
+    {
+        private:
+            std::array<ElementType, BufferSize> buffer = {};
+            size_t count = 0;
+
+        public:
+            DRIVER_RESULT(void) add(const ElementType& element)
+            {
+                if(count >= BufferSize)
+                    DRIVER_FAIL(DriverError::Full, std::overflow_error("Set is full."));
+
+                if(isFound(element))
+                    DRIVER_FAIL(DriverError::AlreadyPresent, std::logic_error("Element already present."));
+
+                buffer[count++] = element;
+                return DRIVER_OK;
+            }
+
+            bool remove(const ElementType& element)
+            {
+                for(size_t i = 0; i < count; ++i)
+                {
+                    if(buffer[i] == element)
+                    {
+                        count--;
+                        for(size_t j = i; j < count; j++)
+                            buffer[j] = buffer[j + 1];
+                        buffer[count] = nullptr;
+
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool isFound(const ElementType& element)
+            {
+                return std::find(buffer.begin(), buffer.end(), element) != buffer.end();
+            }
+    };
+
+    struct Figures
+    {
+        double hit;
+        double miss;
+        double churn;
+    };
+
+    constexpr uint64_t OPERATIONS = 1 << 20;
+
+    template <size_t Count, typename SetType>
+    Figures measure(SetType& set)
+    {
+        static int present[Count];
+        static int missing[Count];
+        for(int& object : present)
+            (void)set.add(&object);
+
+        // Strided, so neither order nor position favours either implementation.
+        constexpr size_t STRIDE = 7;
+        Figures figures;
+
+        figures.hit = benchNsPerOp(OPERATIONS, [&]
+        {
+            size_t found = 0;
+            for(uint64_t i = 0; i < OPERATIONS; i++)
+                found += set.isFound(&present[(i * STRIDE) % Count]);
+            benchKeep(found);
+        });
+
+        figures.miss = benchNsPerOp(OPERATIONS, [&]
+        {
+            size_t found = 0;
+            for(uint64_t i = 0; i < OPERATIONS; i++)
+                found += set.isFound(&missing[(i * STRIDE) % Count]);
+            benchKeep(found);
+        });
+
+        figures.churn = benchNsPerOp(OPERATIONS, [&]
+        {
+            for(uint64_t i = 0; i < OPERATIONS; i++)
+            {
+                int* element = &present[(i * STRIDE) % Count];
+                (void)set.remove(element);
+                (void)set.add(element);
+            }
+            benchKeep(set);
+        });
+        return figures;
+    }
+
+    template <size_t Count>
+    void compare()
+    {
+        static LinearSet<int*, Count> linear;
+        static StaticSet<int*, Count> hashed;
+        Figures linearFigures = measure<Count>(linear);
+        Figures hashedFigures = measure<Count>(hashed);
+
+        printf("%-10zu %-16s %10.2f %10.2f %10.2f\n", Count, "linear",
+               linearFigures.hit, linearFigures.miss, linearFigures.churn);
+        printf("%-10s %-16s %10.2f %10.2f %10.2f\n", "", "StaticSet",
+               hashedFigures.hit, hashedFigures.miss, hashedFigures.churn);
+    }
+}
+
+int main()
+{
+    printf("full set of N pointers, ns per operation\n");
+    printf("%-10s %-16s %10s %10s %10s\n", "elements", "", "found", "missing", "remove+add");
+    compare<8>();
+    compare<64>();
+    compare<512>();
+    return 0;
+}
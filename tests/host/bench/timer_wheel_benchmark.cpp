@@ -0,0 +1,129 @@
+#include "host_bench.hpp"
+#include "host_mcu.hpp"
+#include "host_timer.hpp"
+
+#include "timer_wheel.hpp"
+
+// ============================================================================
+// TimerWheel throughput with N timers in the wheel, delays spread over 2^20 ticks (all
+// four levels): start() and cancel() are O(1) whatever N, and an expiry costs its slot
+// plus its share of the cascades. The alarm interrupt is played by hand (the counter
+// reloaded, then the callback), so the timer model isn't stepped.
+// ============================================================================
+
+namespace
+{
+    constexpr uint32_t DELAY_MASK = (1U << 20) - 1;
+
+    class BenchWheel : public TimerWheel
+    {
+        public:
+            using TimerWheel::TimerWheel;
+
+            // What the update event and its interrupt do.
+            void fireAlarm()
+            {
+                timer->setCount(armedTicks);
+                alarmCallback(this);
+            }
+
+            bool isEmpty() const
+            {
+                for(uint64_t level : occupied)
+                {
+                    if(level)
+                        return false;
+                }
+                return true;
+            }
+    };
+
+    uint32_t nextDelay(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state & DELAY_MASK) + 1;
+    }
+
+    void countExpiry(void* argument)
+    {
+        (*static_cast<uint32_t*>(argument))++;
+    }
+
+    struct Figures
+    {
+        double start;
+        double cancel;
+        double expire;
+    };
+
+    Figures measure(BenchWheel& wheel, size_t count)
+    {
+        static SoftTimer softTimers[4096];
+        uint32_t expired = 0;
+        Figures figures;
+
+        figures.start = benchNsPerOp(count, [&]
+        {
+            uint32_t state = 0x12345678;
+            for(size_t i = 0; i < count; i++)
+                wheel.start(softTimers[i], nextDelay(state), countExpiry, &expired);
+        });
+
+        // Every run starts them again, untimed, then cancels them.
+        double best = 0;
+        for(int run = 0; run < 5; run++)
+        {
+            uint32_t state = 0x9E3779B9;
+            for(size_t i = 0; i < count; i++)
+                wheel.start(softTimers[i], nextDelay(state), countExpiry, &expired);
+
+            double perCancel = benchNsPerOp(count, [&]
+            {
+                for(size_t i = 0; i < count; i++)
+                    wheel.cancel(softTimers[i]);
+            }, 1);
+            if(run == 0 || perCancel < best)
+                best = perCancel;
+        }
+        figures.cancel = best;
+
+        best = 0;
+        for(int run = 0; run < 5; run++)
+        {
+            uint32_t state = 0xC0FFEE;
+            for(size_t i = 0; i < count; i++)
+                wheel.start(softTimers[i], nextDelay(state), countExpiry, &expired);
+
+            expired = 0;
+            double perExpiry = benchNsPerOp(count, [&]
+            {
+                while(!wheel.isEmpty())
+                    wheel.fireAlarm();
+            }, 1);
+            benchKeep(expired);
+            if(run == 0 || perExpiry < best)
+                best = perExpiry;
+        }
+        figures.expire = best;
+        return figures;
+    }
+}
+
+int main()
+{
+    HostMcu::reset();
+    ScopedTimer timer;
+    (void)Timer::Builder().timerSelection(TIMER_2).buildIn(timer);
+    BenchWheel wheel(timer);
+
+    printf("TimerWheel, delays of 1 to 2^20 ticks, ns per operation\n");
+    printf("%-8s %10s %10s %10s\n", "timers", "start", "cancel", "expire");
+    for(size_t count : { 16, 256, 4096 })
+    {
+        Figures figures = measure(wheel, count);
+        printf("%-8zu %10.2f %10.2f %10.2f\n", count, figures.start, figures.cancel, figures.expire);
+    }
+    return 0;
+}
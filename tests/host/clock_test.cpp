@@ -0,0 +1,147 @@
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "clock.hpp"
+
+// ============================================================================
+// Clock on the timer model, one tick per step (PSC = 0) unless a test says otherwise:
+// getTicks() must advance exactly with the steps across the wraps of a 16 and a 32 bit
+// counter, whether the overflow interrupt has run yet or is held off.
+// ============================================================================
+
+namespace
+{
+    struct ClockFixture
+    {
+        ScopedTimer timer;
+        Clock clock;
+
+        ClockFixture(TimerSelection selection, uint32_t prescaler = 0)
+        {
+            HostMcu::reset();
+            (void)Timer::Builder().timerSelection(selection).setPrescaler(prescaler).buildIn(timer);
+            clock.init(timer);
+        }
+
+        // Steps `count` times, false as soon as the ticks and the steps part ways.
+        bool inStep(uint32_t count)
+        {
+            uint32_t startSteps = HostMcu::steps;
+            uint64_t startTicks = clock.getTicks();
+            for(uint32_t i = 0; i < count; i++)
+            {
+                HostMcu::step();
+                if(clock.getTicks() - startTicks != HostMcu::steps - startSteps)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    bool testTicks()
+    {
+        ClockFixture fixture(TIMER_3);
+
+        // A few wraps of the 16 bit counter, each counted by its interrupt.
+        uint32_t interrupts = HostMcu::interrupts;
+        CHECK(fixture.inStep(5 * 65536 + 100));
+        CHECK(HostMcu::interrupts - interrupts == 5);
+        CHECK(fixture.clock.getTicks() >= 5 * 65536ULL);
+        return true;
+    }
+
+    bool testMaskedWrap()
+    {
+        ClockFixture fixture(TIMER_3);
+
+        // The wrap happens with interrupts masked: the update flag stays pending and the
+        // reads make up for the overflow not counted yet.
+        fixture.timer.setCount(10);
+        __disable_irq();
+        CHECK(fixture.inStep(30));
+        CHECK(fixture.timer.isAlarmPending());
+        uint64_t ticks = fixture.clock.getTicks();
+        CHECK(ticks >= 65536);
+
+        // Once the interrupt runs, the count it adds replaces the pending flag.
+        uint32_t interrupts = HostMcu::interrupts;
+        __enable_irq();
+        CHECK(fixture.inStep(30));
+        CHECK(HostMcu::interrupts - interrupts == 1 && !fixture.timer.isAlarmPending());
+        CHECK(fixture.clock.getTicks() - ticks == 30);
+        return true;
+    }
+
+    bool testWideCounter()
+    {
+        ClockFixture fixture(TIMER_2);
+        CHECK(fixture.timer.getMaxCount() == UINT32_MAX);
+
+        // Close to the end of the first 2^32 ticks, then across it.
+        fixture.timer.setCount(20);
+        CHECK(fixture.clock.getTicks() == UINT32_MAX - 20ULL);
+        CHECK(fixture.inStep(100));
+        CHECK(fixture.clock.getTicks() == UINT32_MAX - 20ULL + 100);
+
+        __disable_irq();
+        fixture.timer.setCount(20);
+        CHECK(fixture.inStep(100));
+        CHECK(fixture.clock.getTicks() >> 32 == 2);
+        __enable_irq();
+        CHECK(fixture.inStep(100));
+        return true;
+    }
+
+    uint64_t reference(uint64_t value, uint64_t multiplier, uint64_t divisor)
+    {
+        return static_cast<uint64_t>(static_cast<unsigned __int128>(value) * multiplier / divisor);
+    }
+
+    bool testConversions()
+    {
+        {
+            // 84 MHz / 84: 1 MHz.
+            ClockFixture fixture(TIMER_5, 83);
+            CHECK(fixture.clock.getFrequency() == 1000000);
+            CHECK(fixture.clock.ticksToNanoseconds(3) == 3000);
+            CHECK(fixture.clock.microsecondsToTicks(250) == 250);
+
+            // 1 us per step / 84.
+            HostMcu::runUntil([] { return false; }, 84 * 1000);
+            CHECK(fixture.clock.getMicroseconds() == 1000);
+            CHECK(fixture.clock.getNanoseconds() == 1000000);
+        }
+
+        // 84 MHz / 3: the tick isn't a whole number of nanoseconds.
+        ClockFixture fixture(TIMER_5, 2);
+        CHECK(fixture.clock.getFrequency() == 28000000);
+        CHECK(fixture.clock.ticksToNanoseconds(28) == 1000);
+        CHECK(fixture.clock.ticksToNanoseconds(1) == 35);
+        CHECK(fixture.clock.nanosecondsToTicks(1000) == 28);
+
+        // Exact (truncated) down to the last tick, where value * multiplier overflows 64 bits.
+        const uint64_t values[] = { 0, 1, 27, 28000000, 1ULL << 40, 0x123456789ABCDEFULL, UINT64_MAX / 1000 };
+        for(uint64_t value : values)
+        {
+            CHECK(fixture.clock.ticksToNanoseconds(value) == reference(value, 1000000000, 28000000));
+            CHECK(fixture.clock.ticksToMicroseconds(value) == reference(value, 1000000, 28000000));
+            CHECK(fixture.clock.nanosecondsToTicks(value) == reference(value, 28000000, 1000000000));
+            CHECK(fixture.clock.microsecondsToTicks(value) == reference(value, 28000000, 1000000));
+        }
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "ticks",        testTicks },
+        { "masked_wrap",  testMaskedWrap },
+        { "wide_counter", testWideCounter },
+        { "conversions",  testConversions },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <exception>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "driver_result.hpp"
+
+// ============================================================================
+// Minimal harness shared by the host tests: a test is a function returning false on the
+// first failed CHECK. Every executable takes the name of one test to run, or runs all of
+// them without arguments (ctest registers one entry per name, see add_host_test()).
+// ============================================================================
+
+#define CHECK(condition)                                                                \
+    do                                                                                  \
+    {                                                                                   \
+        if(!(condition))                                                                \
+        {                                                                               \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);        \
+            return false;                                                               \
+        }                                                                               \
+    } while(0)
+
+/*
+ *  @brief Whether `call` failed: threw, or without exceptions returned `error`.
+ */
+template <typename Call>
+bool hostFails(Call&& call, DriverError error)
+{
+#ifdef DRIVERS_NO_EXCEPTIONS
+    return call().error() == error;
+#else
+    (void)error;
+    try
+    {
+        (void)call();
+    }
+    catch(const std::exception&)
+    {
+        return true;
+    }
+    return false;
+#endif
+}
+
+/*
+ *  @brief Whether a DRIVER_RESULT(void) call succeeded, in both builds.
+ */
+template <typename Call>
+bool hostSucceeds(Call&& call)
+{
+#ifdef DRIVERS_NO_EXCEPTIONS
+    return call().ok();
+#else
+    call();
+    return true;
+#endif
+}
+
+struct HostTest
+{
+    const char* name;
+    bool (*function)();
+};
+
+inline bool runHostTest(const HostTest& test)
+{
+    bool result = test.function();
+    printf("%s %s\n", result ? "PASS" : "FAIL", test.name);
+    return result;
+}
+
+/*
+ *  @brief Runs the test named by argv[1] (every one without it) through `run`.
+ *
+ *  @return The exit status: 0 when all of them passed.
+ */
+template <typename Test, size_t Count>
+int runHostTests(const Test (&tests)[Count], int argc, char** argv, bool (*run)(const Test&))
+{
+    bool passed = true;
+    bool found = false;
+
+    for(const Test& test : tests)
+    {
+        if(argc > 1 && strcmp(argv[1], test.name) != 0)
+            continue;
+
+        found = true;
+        passed &= run(test);
+    }
+
+    if(!found)
+    {
+        printf("Unknown test %s\n", argv[1]);
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
+
+template <size_t Count>
+int runHostTests(const HostTest (&tests)[Count], int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv, runHostTest);
+}
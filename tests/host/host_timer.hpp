@@ -0,0 +1,21 @@
+#pragma once
+
+#include "timer.hpp"
+#include "timer_builder.hpp"
+
+/*
+ *  @brief Timer that gives its slot of the driver registry back when it goes out of
+ *  scope, so every test can take the same timer again (firmware never releases one).
+ */
+class ScopedTimer : public Timer
+{
+    public:
+        ~ScopedTimer()
+        {
+            for(Timer*& driver : drivers)
+            {
+                if(driver == this)
+                    driver = nullptr;
+            }
+        }
+};
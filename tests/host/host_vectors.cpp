@@ -0,0 +1,32 @@
+#include "host_mcu.hpp"
+
+#include "i2c_bus.hpp"
+#include "timer.hpp"
+
+// ============================================================================
+// Vector table of the host tests: the interrupt lines the model can raise, routed to
+// the handlers of the driver libraries linked into the test.
+// ============================================================================
+
+const HostVector hostVectors[] =
+{
+    { I2C1_EV_IRQn,      I2C1_EV_IRQHandler },
+    { I2C1_ER_IRQn,      I2C1_ER_IRQHandler },
+    { I2C2_EV_IRQn,      I2C2_EV_IRQHandler },
+    { I2C2_ER_IRQn,      I2C2_ER_IRQHandler },
+    { I2C3_EV_IRQn,      I2C3_EV_IRQHandler },
+    { I2C3_ER_IRQn,      I2C3_ER_IRQHandler },
+    { DMA1_Stream0_IRQn, DMA1_Stream0_IRQHandler },
+    { DMA1_Stream2_IRQn, DMA1_Stream2_IRQHandler },
+    { DMA1_Stream3_IRQn, DMA1_Stream3_IRQHandler },
+    { TIM1_BRK_TIM9_IRQn,      TIM1_BRK_TIM9_IRQHandler },
+    { TIM1_UP_TIM10_IRQn,      TIM1_UP_TIM10_IRQHandler },
+    { TIM1_TRG_COM_TIM11_IRQn, TIM1_TRG_COM_TIM11_IRQHandler },
+    { TIM1_CC_IRQn,            TIM1_CC_IRQHandler },
+    { TIM2_IRQn,               TIM2_IRQHandler },
+    { TIM3_IRQn,               TIM3_IRQHandler },
+    { TIM4_IRQn,               TIM4_IRQHandler },
+    { TIM5_IRQn,               TIM5_IRQHandler },
+};
+
+const size_t hostVectorCount = sizeof(hostVectors) / sizeof(hostVectors[0]);
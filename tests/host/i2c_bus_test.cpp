@@ -0,0 +1,1244 @@
+#include <initializer_list>
+#include <optional>
+
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "i2c_async.hpp"
+#include "i2c_bus_static.hpp"
+#include "i2c_device.hpp"
+#include "i2c_register_map_slave.hpp"
+#include "set.hpp"
+#include "spsc_queue.hpp"
+#include "dma_streams.hpp"
+#include "triple_buffer.hpp"
+
+#include "stm32f4xx_ll_dma.h"
+
+// ============================================================================
+// I2cBus master and slave paths against the I2Cv1/DMA/TIM register model. Every test
+// runs with the interrupt data path and again with DMA (except the ones that are DMA
+// only).
+// Run one test with `i2c_bus_test <name>`, all of them without arguments.
+// ============================================================================
+
+namespace
+{
+    constexpr uint16_t SENSOR_ADDRESS = 0x50;
+    constexpr uint16_t MISSING_ADDRESS = 0x51;
+    constexpr uint16_t OWN_ADDRESS = 0x42;
+
+    template <typename Bus>
+    struct BusFixture
+    {
+        RegisterSlave sensor;
+        Bus bus;
+        HostI2c& wire;
+
+        // `prepare` runs between the MCU reset and the bus init, e.g. to set up the
+        // retry timer the bus checks at init.
+        explicit BusFixture(bool dma, I2cBus::Selection selection = I2cBus::Selection::Bus1,
+                            I2cBus::Builder builder = I2cBus::Builder(),
+                            void (*prepare)(void*) = nullptr, void* context = nullptr)
+            : wire(HostI2c::of(selection == I2cBus::Selection::Bus1 ? I2C1 :
+                               selection == I2cBus::Selection::Bus2 ? I2C2 : I2C3))
+        {
+            HostMcu::reset();
+            if(prepare)
+                prepare(context);
+            wire.detachAll();
+            wire.attach(SENSOR_ADDRESS, sensor);
+
+            builder.withBusSelection(selection).setBusSpeed(100000);
+            if(dma)
+                builder.enableDma();
+
+            I2cBus::Config config = builder.buildConfig();
+            (void)bus.init(config);
+        }
+    };
+
+    using Fixture = BusFixture<I2cBusStatic<8, 4>>;
+
+    struct Counter
+    {
+        uint32_t post = 0;
+        uint32_t error = 0;
+    };
+
+    I2cTransaction::Builder& countCallbacks(I2cTransaction::Builder& builder, Counter& counter)
+    {
+        return builder
+            .withPostCallback([](void* counter) { static_cast<Counter*>(counter)->post++; }, &counter)
+            .withErrorCallback([](void* counter) { static_cast<Counter*>(counter)->error++; }, &counter);
+    }
+
+    // What the busy-retry timer does between queued transactions: the STOP of one is
+    // still on the wire when the next one is tried.
+    bool runQueue(I2cBus& bus)
+    {
+        do
+        {
+            if(!HostMcu::run())
+                return false;
+        } while(bus.verifyPendingTransaction());
+        return true;
+    }
+
+    bool testWrite(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        uint8_t data[16];
+        for(size_t i = 0; i < sizeof(data); i++)
+            data[i] = static_cast<uint8_t>(0xA1 + 0x11 * i);
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX)
+            .withRegister(0x10).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+
+        device << transaction;
+        CHECK(HostMcu::run());
+
+        CHECK(transaction.getState() == I2cTransaction::FINISHED);
+        CHECK(counter.post == 1 && counter.error == 0);
+        CHECK(memcmp(&fixture.sensor.registers[0x10], data, sizeof(data)) == 0);
+        // One interrupt per byte without DMA. With it: SB, ADDR, the register byte's TXE
+        // and the final BTF, whatever the length.
+        CHECK(dma ? HostMcu::interrupts <= 4 : HostMcu::interrupts > sizeof(data));
+        CHECK(fixture.wire.startConditions == 1 && fixture.wire.stopConditions == 1);
+        CHECK(fixture.bus.getState() == I2cBus::State::Idle);
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_6));
+        return true;
+    }
+
+    bool testRead(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        for(int i = 0; i < 256; i++)
+            fixture.sensor.registers[i] = static_cast<uint8_t>(i ^ 0x5A);
+
+        // 1 and 2 bytes take the NACK/POS special cases of the I2Cv1 receiver.
+        uint32_t dmaInterrupts = 0;
+        for(uint16_t length : { 1, 2, 3, 7 })
+        {
+            uint32_t interruptsBefore = HostMcu::interrupts;
+            uint8_t data[8] = {};
+            Counter counter;
+            I2cTransaction::Builder builder;
+            countCallbacks(builder, counter).setDirection(I2cTransaction::RX)
+                .withRegister(0x20).withData(data, length);
+            I2cTransaction transaction = builder.build();
+
+            device << transaction;
+            CHECK(HostMcu::run());
+
+            CHECK(transaction.getState() == I2cTransaction::FINISHED);
+            CHECK(counter.post == 1 && counter.error == 0);
+            CHECK(memcmp(data, &fixture.sensor.registers[0x20], length) == 0);
+            CHECK(data[length] == 0);
+
+            // Without DMA each byte takes an interrupt. With it, a transfer of 2+ bytes
+            // costs the same whatever its length.
+            uint32_t interrupts = HostMcu::interrupts - interruptsBefore;
+            if(!dma)
+                CHECK(interrupts > length);
+            else if(length == 2)
+                dmaInterrupts = interrupts;
+            else if(length > 2)
+                CHECK(interrupts == dmaInterrupts);
+        }
+
+        CHECK(fixture.wire.stopConditions == 4);
+        CHECK(fixture.bus.getStatistics().transactionsCompleted == 4);
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_0));
+        return true;
+    }
+
+    bool testChain(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        fixture.sensor.registers[0x31] = 0x77;
+        fixture.sensor.registers[0x32] = 0x88;
+
+        uint8_t command[] = { 0x01, 0x02 };
+        uint8_t response[2] = {};
+        Counter first;
+        Counter second;
+
+        I2cTransaction::Builder readBuilder;
+        countCallbacks(readBuilder, second).setDirection(I2cTransaction::RX)
+            .withRegister(0x31).withData(response, sizeof(response));
+        I2cTransaction read = readBuilder.build();
+
+        I2cTransaction::Builder writeBuilder;
+        countCallbacks(writeBuilder, first).setDirection(I2cTransaction::TX)
+            .withRegister(0x40).withData(command, sizeof(command)).chainWith(read);
+        I2cTransaction write = writeBuilder.build();
+
+        device << write;
+        CHECK(HostMcu::run());
+
+        CHECK(write.getState() == I2cTransaction::FINISHED);
+        CHECK(read.getState() == I2cTransaction::FINISHED);
+        CHECK(first.post == 1 && second.post == 1);
+        CHECK(fixture.sensor.registers[0x40] == 0x01 && fixture.sensor.registers[0x41] == 0x02);
+        CHECK(response[0] == 0x77 && response[1] == 0x88);
+
+        // START, REPEATED-START between the segments and the one of the register read,
+        // a single STOP at the end.
+        CHECK(fixture.wire.startConditions == 3);
+        CHECK(fixture.wire.stopConditions == 1);
+        return true;
+    }
+
+    bool testAcknowledgeFailure(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice missing(MISSING_ADDRESS, &fixture.bus);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        uint8_t data[] = { 1, 2, 3 };
+        Counter failed;
+        Counter next;
+
+        I2cTransaction::Builder failedBuilder;
+        countCallbacks(failedBuilder, failed).setDirection(I2cTransaction::TX)
+            .withRegister(0x00).withData(data, sizeof(data));
+        I2cTransaction lost = failedBuilder.build();
+
+        I2cTransaction::Builder nextBuilder;
+        countCallbacks(nextBuilder, next).setDirection(I2cTransaction::TX)
+            .withRegister(0x00).withData(data, sizeof(data));
+        I2cTransaction delivered = nextBuilder.build();
+
+        missing << lost;
+        device << delivered;
+        CHECK(HostMcu::run());
+
+        // The STOP after the NACK was still pending when the next one was tried: BUSY.
+        // What the busy-retry timer would do.
+        CHECK(next.post == 0);
+        CHECK(fixture.bus.verifyPendingTransaction());
+        CHECK(HostMcu::run());
+
+        CHECK(lost.getState() == I2cTransaction::ERROR);
+        CHECK(failed.error == 1 && failed.post == 0);
+        CHECK(delivered.getState() == I2cTransaction::FINISHED);
+        CHECK(next.post == 1);
+        CHECK(fixture.bus.getStatistics().acknowledgeFailures == 1);
+        CHECK(fixture.wire.stopConditions == 2);
+        return true;
+    }
+
+    struct OtherMaster
+    {
+        RegisterSlave* sensor;
+    };
+
+    bool testArbitrationLostChain(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        fixture.sensor.registers[0x31] = 0x11;
+        fixture.sensor.registers[0x32] = 0x22;
+
+        uint8_t command[] = { 0xC1, 0xC2 };
+        uint8_t response[2] = {};
+        Counter first;
+        Counter second;
+
+        I2cTransaction::Builder readBuilder;
+        countCallbacks(readBuilder, second).setDirection(I2cTransaction::RX)
+            .withRegister(0x31).withData(response, sizeof(response));
+        I2cTransaction read = readBuilder.build();
+
+        I2cTransaction::Builder writeBuilder;
+        countCallbacks(writeBuilder, first).setDirection(I2cTransaction::TX)
+            .withRegister(0x40).withData(command, sizeof(command)).chainWith(read);
+        I2cTransaction write = writeBuilder.build();
+
+        // Lost on the address of the second segment (after address, register and two data
+        // bytes of the first). The other master moves the register pointer meanwhile, which
+        // is why the chain must start over from its head.
+        OtherMaster other = { &fixture.sensor };
+        fixture.wire.loseArbitration(4, [](void* context)
+        {
+            static_cast<OtherMaster*>(context)->sensor->pointer = 0x90;
+        }, &other);
+
+        device << write;
+        CHECK(HostMcu::run());
+
+        CHECK(write.getState() == I2cTransaction::IDLE);
+        CHECK(read.getState() == I2cTransaction::IDLE);
+        CHECK(fixture.bus.getStatistics().arbitrationLosses == 1);
+
+        // The bus is free again: what the busy-retry timer would do.
+        CHECK(fixture.bus.verifyPendingTransaction());
+        CHECK(HostMcu::run());
+
+        CHECK(write.getState() == I2cTransaction::FINISHED);
+        CHECK(read.getState() == I2cTransaction::FINISHED);
+        // The head went out twice, and completed both times.
+        CHECK(first.post == 2 && second.post == 1);
+        CHECK(first.error == 0 && second.error == 0);
+        CHECK(response[0] == 0x11 && response[1] == 0x22);
+        CHECK(fixture.bus.getStatistics().arbitrationRetries == 1);
+        return true;
+    }
+
+    bool testCancelChainMidway(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        uint8_t command[] = { 0xD1, 0xD2 };
+        uint8_t response[4] = {};
+        Counter first;
+        Counter second;
+
+        I2cTransaction::Builder readBuilder;
+        countCallbacks(readBuilder, second).setDirection(I2cTransaction::RX)
+            .withRegister(0x31).withData(response, sizeof(response));
+        I2cTransaction read = readBuilder.build();
+
+        I2cTransaction::Builder writeBuilder;
+        countCallbacks(writeBuilder, first).setDirection(I2cTransaction::TX)
+            .withRegister(0x40).withData(command, sizeof(command)).chainWith(read);
+        I2cTransaction write = writeBuilder.build();
+
+        device << write;
+        for(uint32_t i = 0; i < 1000 && read.getState() != I2cTransaction::EXCHANGING_DATA; i++)
+            HostMcu::step();
+        CHECK(read.getState() == I2cTransaction::EXCHANGING_DATA);
+        CHECK(first.post == 1);
+
+        // The head already finished, the second segment is receiving.
+        CHECK(device.cancel(write));
+        CHECK(HostMcu::run());
+
+        CHECK(read.getState() == I2cTransaction::CANCELLED);
+        CHECK(second.post == 0 && second.error == 0);
+        CHECK(fixture.wire.stopConditions == 1);
+        CHECK(fixture.bus.getState() == I2cBus::State::Idle);
+        CHECK(!device.cancel(write));
+        return true;
+    }
+
+    bool testCancelReadTail(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        fixture.sensor.registers[0x20] = 0x5E;
+
+        uint8_t pair[2] = {};
+        uint8_t single = 0;
+        Counter counter;
+        I2cTransaction::Builder pairBuilder;
+        countCallbacks(pairBuilder, counter).setDirection(I2cTransaction::RX)
+            .withRegister(0x10).withData(pair, sizeof(pair));
+        I2cTransaction cancelled = pairBuilder.build();
+
+        I2cTransaction::Builder singleBuilder;
+        countCallbacks(singleBuilder, counter).setDirection(I2cTransaction::RX)
+            .withRegister(0x20).withData(&single, 1);
+        I2cTransaction next = singleBuilder.build();
+
+        // Cancelled in the 2 byte tail: POS set and ACK cleared (LAST with DMA).
+        I2cBus::State receiving = dma ? I2cBus::State::ReceiveDataDma : I2cBus::State::ReceiveData;
+        device << cancelled;
+        for(uint32_t i = 0; i < 1000 && fixture.bus.getState() != receiving; i++)
+            HostMcu::step();
+        CHECK(fixture.bus.getState() == receiving);
+        CHECK(dma || (I2C1->CR1 & I2C_CR1_POS));
+
+        CHECK(device.cancel(cancelled));
+        CHECK(HostMcu::run());
+        CHECK(cancelled.getState() == I2cTransaction::CANCELLED);
+        CHECK(!(I2C1->CR1 & I2C_CR1_POS) && (I2C1->CR1 & I2C_CR1_ACK));
+
+        // A single byte read needs POS clear to NACK its only byte.
+        device << next;
+        CHECK(HostMcu::run());
+        CHECK(next.getState() == I2cTransaction::FINISHED);
+        CHECK(single == 0x5E);
+        CHECK(counter.post == 1 && counter.error == 0);
+        return true;
+    }
+
+    bool testIntrusiveQueue(bool dma)
+    {
+        BusFixture<I2cBusIntrusive<4>> fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        // More than a static queue would take, no depth limit.
+        constexpr size_t COUNT = 12;
+        uint8_t data[COUNT][2];
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX);
+        std::optional<I2cTransaction> transactions[COUNT];
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            data[i][0] = static_cast<uint8_t>(i);
+            data[i][1] = static_cast<uint8_t>(0xA0 + i);
+            transactions[i].emplace(builder.withRegister(0x80 + 2 * i).withData(data[i], 2).build());
+            device << *transactions[i];
+        }
+
+        // O(1) unlink from the middle and from the tail; the first one is on the wire.
+        CHECK(device.cancel(*transactions[5]));
+        CHECK(device.cancel(*transactions[COUNT - 1]));
+        CHECK(!device.cancel(*transactions[5]));
+        CHECK(runQueue(fixture.bus));
+
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            bool dropped = i == 5 || i == COUNT - 1;
+            CHECK(transactions[i]->getState() == (dropped ? I2cTransaction::CANCELLED : I2cTransaction::FINISHED));
+            uint8_t written = fixture.sensor.registers[0x80 + 2 * i + 1];
+            CHECK(dropped ? written == 0 : written == 0xA0 + i);
+        }
+        CHECK(counter.post == COUNT - 2 && counter.error == 0);
+
+        // A transaction goes back to the queue once finished.
+        device << *transactions[0];
+        CHECK(HostMcu::run());
+        CHECK(counter.post == COUNT - 1);
+        CHECK(fixture.bus.getState() == I2cBus::State::Idle);
+        return true;
+    }
+
+    bool testSpscQueue(bool dma)
+    {
+        // This thread enqueues; the bus takes from its ISRs and cancels with interrupts
+        // masked, both on the consumer side.
+        SpscQueue<I2cTransaction*, 8> queue;
+        StaticSet<I2cDevice*, 4> devices;
+        BusFixture<I2cBus> fixture(dma, I2cBus::Selection::Bus1,
+                                   I2cBus::Builder().withQueue(queue).withDevicesSet(devices));
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        std::optional<I2cDevice> detached;
+        detached.emplace(MISSING_ADDRESS, &fixture.bus);
+
+        constexpr size_t COUNT = 6;
+        uint8_t data[COUNT][2];
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX);
+        std::optional<I2cTransaction> transactions[COUNT];
+        std::optional<I2cTransaction> others[2];
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            data[i][0] = static_cast<uint8_t>(i);
+            data[i][1] = static_cast<uint8_t>(0xB0 + i);
+            transactions[i].emplace(builder.withRegister(0x80 + 2 * i).withData(data[i], 2).build());
+            device << *transactions[i];
+            if(i < 2)
+            {
+                others[i].emplace(builder.withRegister(0xC0 + 2 * i).build());
+                *detached << *others[i];
+            }
+        }
+        // The first one left the queue when it started.
+        CHECK(queue.size() == COUNT - 1 + 2);
+
+        // Tombstones in the middle and right behind the front, then the other device's
+        // transactions through removeIf().
+        CHECK(device.cancel(*transactions[3]));
+        CHECK(device.cancel(*transactions[1]));
+        CHECK(!device.cancel(*transactions[3]));
+        detached.reset();
+        CHECK(queue.size() == COUNT - 3);
+        CHECK(!queue.isFull());
+        CHECK(runQueue(fixture.bus));
+
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            bool dropped = i == 1 || i == 3;
+            CHECK(transactions[i]->getState() == (dropped ? I2cTransaction::CANCELLED : I2cTransaction::FINISHED));
+            uint8_t written = fixture.sensor.registers[0x80 + 2 * i + 1];
+            CHECK(dropped ? written == 0 : written == 0xB0 + i);
+        }
+        CHECK(others[0]->getState() == I2cTransaction::CANCELLED);
+        CHECK(others[1]->getState() == I2cTransaction::CANCELLED);
+        CHECK(fixture.sensor.registers[0xC0] == 0 && fixture.sensor.registers[0xC2] == 0);
+        CHECK(counter.post == COUNT - 2 && counter.error == 0);
+        CHECK(queue.isEmpty() && !queue.peek());
+        return true;
+    }
+
+    bool testDetachInFlight(bool dma)
+    {
+        Fixture fixture(dma);
+        std::optional<I2cDevice> device;
+        device.emplace(SENSOR_ADDRESS, &fixture.bus);
+
+        uint8_t data[6] = {};
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::RX)
+            .withRegister(0x00).withData(data, sizeof(data));
+        I2cTransaction inFlight = builder.build();
+        I2cTransaction queued = builder.build();
+
+        *device << inFlight;
+        *device << queued;
+        for(uint32_t i = 0; i < 1000 && inFlight.getState() != I2cTransaction::EXCHANGING_DATA; i++)
+            HostMcu::step();
+        CHECK(inFlight.getState() == I2cTransaction::EXCHANGING_DATA);
+
+        // A device going out of scope detaches from its bus.
+        device.reset();
+        CHECK(HostMcu::run());
+
+        CHECK(inFlight.getState() == I2cTransaction::CANCELLED);
+        CHECK(queued.getState() == I2cTransaction::CANCELLED);
+        CHECK(counter.post == 0 && counter.error == 0);
+        CHECK(fixture.wire.stopConditions == 1);
+        CHECK(fixture.bus.getState() == I2cBus::State::Idle);
+        return true;
+    }
+
+    bool testCancelAtRepeatedStart(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        uint8_t data[4] = {};
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::RX)
+            .withRegister(0x00).withData(data, sizeof(data));
+        I2cTransaction cancelled = builder.build();
+        I2cTransaction next = builder.build();
+
+        device << cancelled;
+        device << next;
+        for(uint32_t i = 0; i < 1000 && fixture.bus.getState() != I2cBus::State::RepeatedStart; i++)
+            HostMcu::step();
+        CHECK(fixture.bus.getState() == I2cBus::State::RepeatedStart);
+
+        // Only the repeated START of the register read is on the wire.
+        CHECK(device.cancel(cancelled));
+        CHECK(HostMcu::run());
+
+        CHECK(cancelled.getState() == I2cTransaction::CANCELLED);
+        CHECK(next.getState() == I2cTransaction::FINISHED);
+        CHECK(counter.post == 1 && counter.error == 0);
+        CHECK(fixture.bus.getStatistics().busResets == 1);
+        return true;
+    }
+
+    bool testBusError(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        uint8_t data[] = { 1, 2, 3, 4 };
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX)
+            .withRegister(0x00).withData(data, sizeof(data));
+        I2cTransaction broken = builder.build();
+        I2cTransaction next = builder.build();
+
+        device << broken;
+        device << next;
+        for(uint32_t i = 0; i < 8; i++)
+            HostMcu::step();
+        fixture.wire.busError();
+        CHECK(HostMcu::run());
+
+        CHECK(broken.getState() == I2cTransaction::ERROR);
+        CHECK(next.getState() == I2cTransaction::FINISHED);
+        CHECK(counter.error == 1 && counter.post == 1);
+        CHECK(fixture.bus.getStatistics().busErrors == 1);
+        CHECK(fixture.bus.getStatistics().busResets == 1);
+        return true;
+    }
+
+    bool testDmaStreamTaken(bool)
+    {
+        // I2C3 TX shares DMA1 stream 4 with TIM3 CH1: a running capture keeps it.
+        Fixture fixture(true, I2cBus::Selection::Bus3);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        CHECK(DmaStreams::claim(DMA1, LL_DMA_STREAM_4));
+        LL_DMA_SetChannelSelection(DMA1, LL_DMA_STREAM_4, LL_DMA_CHANNEL_5);
+        LL_DMA_SetDataLength(DMA1, LL_DMA_STREAM_4, 16);
+        LL_DMA_EnableStream(DMA1, LL_DMA_STREAM_4);
+
+        uint8_t data[] = { 9, 8, 7, 6 };
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX)
+            .withRegister(0x60).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+
+        device << transaction;
+        CHECK(HostMcu::run());
+
+        CHECK(transaction.getState() == I2cTransaction::FINISHED);
+        CHECK(memcmp(&fixture.sensor.registers[0x60], data, sizeof(data)) == 0);
+        CHECK(LL_DMA_IsEnabledStream(DMA1, LL_DMA_STREAM_4));
+        CHECK((DMA1->stream[LL_DMA_STREAM_4].CR & DMA_SxCR_CHSEL) == LL_DMA_CHANNEL_5);
+        CHECK(LL_DMA_GetDataLength(DMA1, LL_DMA_STREAM_4) == 16);
+        CHECK(DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_4));
+
+        // Once released, the bus moves the data by DMA again.
+        LL_DMA_DisableStream(DMA1, LL_DMA_STREAM_4);
+        DmaStreams::release(DMA1, LL_DMA_STREAM_4);
+
+        device << transaction;
+        CHECK(HostMcu::run());
+        CHECK(transaction.getState() == I2cTransaction::FINISHED);
+        CHECK((DMA1->stream[LL_DMA_STREAM_4].CR & DMA_SxCR_CHSEL) == LL_DMA_CHANNEL_3);
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_4));
+        CHECK(counter.post == 2);
+        return true;
+    }
+
+    bool testPublishTo(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        TripleBuffer<std::array<uint8_t, 4>> samples;
+
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::RX)
+            .withRegister(0x60).publishTo(samples);
+        I2cTransaction transaction = builder.build();
+
+        for(uint8_t run = 1; run <= 3; run++)
+        {
+            for(int i = 0; i < 4; i++)
+                fixture.sensor.registers[0x60 + i] = static_cast<uint8_t>(run * 0x10 + i);
+
+            device << transaction;
+            CHECK(HostMcu::run());
+            CHECK(transaction.getState() == I2cTransaction::FINISHED);
+
+            // The third sample is left unread.
+            if(run == 3)
+                break;
+
+            CHECK(samples.hasNewValue());
+            const std::array<uint8_t, 4>& sample = samples.read();
+            CHECK(sample[0] == run * 0x10 && sample[3] == run * 0x10 + 3);
+            CHECK(!samples.hasNewValue());
+        }
+
+        // The reader gets the latest sample, the unread one is dropped.
+        fixture.sensor.registers[0x60] = 0xEE;
+        device << transaction;
+        CHECK(HostMcu::run());
+
+        CHECK(counter.post == 4 && counter.error == 0);
+        CHECK(samples.hasNewValue());
+        const std::array<uint8_t, 4>& latest = samples.read();
+        CHECK(latest[0] == 0xEE && latest[1] == 0x31);
+        return true;
+    }
+
+    struct SensorRun
+    {
+        uint8_t sample[3] = {};
+        bool configured = false;
+        bool missingAcknowledged = true;
+        bool finished = false;
+    };
+
+    I2cTask configureSensor(I2cDevice& sensor, SensorRun& run)
+    {
+        uint8_t configuration[] = { 0x0F, 0x80 };
+        run.configured = co_await sensor.write(0x70, configuration, sizeof(configuration));
+    }
+
+    I2cTask readSensor(I2cDevice& sensor, I2cDevice& missing, SensorRun& run)
+    {
+        co_await configureSensor(sensor, run);
+        if(!run.configured)
+            co_return;
+
+        uint8_t probe = 0;
+        run.missingAcknowledged = co_await missing.write(&probe, 1);
+        co_await sensor.read(0x72, run.sample, sizeof(run.sample));
+        run.finished = true;
+    }
+
+    bool testCoroutine(bool dma)
+    {
+        Fixture fixture(dma);
+        I2cDevice sensor(SENSOR_ADDRESS, &fixture.bus);
+        I2cDevice missing(MISSING_ADDRESS, &fixture.bus);
+        fixture.sensor.registers[0x72] = 0x11;
+        fixture.sensor.registers[0x73] = 0x22;
+        fixture.sensor.registers[0x74] = 0x33;
+
+        I2cExecutor executor;
+        SensorRun run;
+        CHECK(executor.spawn(readSensor(sensor, missing, run)));
+
+        // The main loop: the ISR only posts the task, poll() resumes it.
+        for(int i = 0; i < 100 && !run.finished; i++)
+        {
+            executor.poll();
+            CHECK(HostMcu::run());
+
+            // What the busy-retry timer would do after the NACK.
+            fixture.bus.verifyPendingTransaction();
+        }
+
+        CHECK(run.finished);
+        CHECK(run.configured && !run.missingAcknowledged);
+        CHECK(fixture.sensor.registers[0x70] == 0x0F && fixture.sensor.registers[0x71] == 0x80);
+        CHECK(run.sample[0] == 0x11 && run.sample[1] == 0x22 && run.sample[2] == 0x33);
+        CHECK(fixture.bus.getStatistics().acknowledgeFailures == 1);
+        return true;
+    }
+
+    struct RegisterMapFixture
+    {
+        I2cRegisterMapSlave<16> slave;
+        Fixture fixture;
+        uint32_t writes = 0;
+        uint8_t writeFirst = 0;
+        uint16_t writeLength = 0;
+
+        explicit RegisterMapFixture(bool dma)
+            : fixture(dma, I2cBus::Selection::Bus1, I2cBus::Builder().enableSlave(OWN_ADDRESS, slave))
+        {
+            slave.onMasterWrite([this](uint8_t firstRegister, uint16_t length)
+            {
+                writes++;
+                writeFirst = firstRegister;
+                writeLength = length;
+            });
+        }
+
+        // Another master on the wire: writes `write`, then reads `readLength` bytes.
+        bool transfer(std::initializer_list<uint8_t> write, uint8_t* read = nullptr, size_t readLength = 0)
+        {
+            fixture.wire.masterTransfer(OWN_ADDRESS, write.begin(), write.size(), read, readLength);
+            if(!HostMcu::run())
+                return false;
+
+            const HostI2c::MasterResult& result = fixture.wire.masterResult;
+            return result.done && !result.nacked && result.written == write.size() && result.read == readLength;
+        }
+    };
+
+    bool testRegisterMapSlave(bool dma)
+    {
+        RegisterMapFixture map(dma);
+
+        // Register write: pointer, then the data auto-incremented.
+        CHECK(map.transfer({ 0x04, 0x11, 0x22, 0x33 }));
+        uint8_t registers[4] = {};
+        map.slave.read(0x04, registers, 3);
+        CHECK(registers[0] == 0x11 && registers[1] == 0x22 && registers[2] == 0x33);
+        CHECK(map.writes == 1 && map.writeFirst == 0x04 && map.writeLength == 3);
+
+        // Register read: the pointer write has no data, so no callback.
+        uint8_t read[4] = {};
+        CHECK(map.transfer({ 0x05 }, read, sizeof(read)));
+        CHECK(read[0] == 0x22 && read[1] == 0x33 && read[2] == 0 && read[3] == 0);
+        CHECK(map.writes == 1);
+
+        // Application updates are seen by the next read; past the end reads 0xFF.
+        const uint8_t update[] = { 0xAA, 0xBB };
+        map.slave.write(0x0E, update, sizeof(update));
+        CHECK(map.transfer({ 0x0E }, read, sizeof(read)));
+        CHECK(read[0] == 0xAA && read[1] == 0xBB && read[2] == 0xFF && read[3] == 0xFF);
+
+        // Read-only bits keep their value.
+        map.slave.setWriteMask(0x00, 0x0F);
+        CHECK(map.transfer({ 0x00, 0xFF, 0xFF }));
+        map.slave.read(0x00, registers, 2);
+        CHECK(registers[0] == 0x0F && registers[1] == 0xFF);
+        CHECK(map.writes == 2 && map.writeFirst == 0x00 && map.writeLength == 2);
+
+        // Another address isn't ours.
+        map.fixture.wire.masterTransfer(OWN_ADDRESS + 1, update, sizeof(update));
+        CHECK(HostMcu::run());
+        CHECK(map.fixture.wire.masterResult.done && map.fixture.wire.masterResult.nacked);
+
+        CHECK(map.fixture.bus.getState() == I2cBus::State::Idle);
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_0) && !DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_6));
+
+        // The slave doesn't keep the bus from its master side.
+        I2cDevice device(SENSOR_ADDRESS, &map.fixture.bus);
+        uint8_t data[] = { 1, 2 };
+        I2cTransaction::Builder builder;
+        builder.setDirection(I2cTransaction::TX).withRegister(0x30).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+        device << transaction;
+        CHECK(HostMcu::run());
+        CHECK(transaction.getState() == I2cTransaction::FINISHED);
+        CHECK(map.fixture.sensor.registers[0x30] == 1 && map.fixture.sensor.registers[0x31] == 2);
+        return true;
+    }
+
+    bool testSlaveDma(bool)
+    {
+        RegisterMapFixture map(true);
+
+        // The windows move by DMA: a few interrupts per transfer whatever its length.
+        uint32_t interruptsBefore = HostMcu::interrupts;
+        CHECK(map.transfer({ 0x00, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 }));
+        uint32_t writeInterrupts = HostMcu::interrupts - interruptsBefore;
+        CHECK(writeInterrupts < 8);
+        CHECK(map.writes == 1 && map.writeLength == 16);
+
+        interruptsBefore = HostMcu::interrupts;
+        uint8_t read[16] = {};
+        CHECK(map.transfer({ 0x00 }, read, sizeof(read)));
+        CHECK(HostMcu::interrupts - interruptsBefore < 8);
+        for(uint8_t i = 0; i < sizeof(read); i++)
+            CHECK(read[i] == i);
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_0) && !DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_6));
+
+        // A read longer than the window: the bus goes on per byte from onReadByte().
+        uint8_t tail[6] = {};
+        CHECK(map.transfer({ 0x0C }, tail, sizeof(tail)));
+        CHECK(tail[0] == 12 && tail[3] == 15 && tail[4] == 0xFF && tail[5] == 0xFF);
+
+        // With the RX stream held elsewhere, the same write costs an interrupt per byte.
+        CHECK(DmaStreams::claim(DMA1, LL_DMA_STREAM_0));
+        interruptsBefore = HostMcu::interrupts;
+        CHECK(map.transfer({ 0x00, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 }));
+        CHECK(HostMcu::interrupts - interruptsBefore > 16);
+        DmaStreams::release(DMA1, LL_DMA_STREAM_0);
+
+        uint8_t registers[16] = {};
+        map.slave.read(0x00, registers, sizeof(registers));
+        for(uint8_t i = 0; i < sizeof(registers); i++)
+            CHECK(registers[i] == 15 - i);
+        CHECK(map.writes == 2 && map.fixture.bus.getState() == I2cBus::State::Idle);
+        return true;
+    }
+
+    struct RetryTimer
+    {
+        ScopedTimer timer;
+
+        static void configure(void* context)
+        {
+            // 1 us per tick at 84 MHz, the resolution of the retry delays.
+            (void)Timer::Builder().timerSelection(TIMER_3).setPrescaler(83)
+                .buildIn(static_cast<RetryTimer*>(context)->timer);
+        }
+    };
+
+    bool testTimerRetry(bool dma)
+    {
+        RetryTimer retry;
+        I2cBus::RetryPolicy policy;
+        policy.initialDelayUs = 20;
+        policy.maxDelayUs = 20;
+
+        I2cBus::Builder busBuilder;
+        busBuilder.withTimer(retry.timer).withRetryPolicy(policy);
+        Fixture fixture(dma, I2cBus::Selection::Bus1, busBuilder, RetryTimer::configure, &retry);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        // Another master keeps the bus for about two retry delays (84 steps per tick).
+        fixture.wire.holdBusy(3000);
+
+        uint8_t data[] = { 0x0D, 0x0E };
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX)
+            .withRegister(0x40).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+
+        // Nothing calls verifyPendingTransaction(): the alarm of the timer does.
+        device << transaction;
+        CHECK(HostMcu::run());
+        CHECK(transaction.getState() != I2cTransaction::FINISHED);
+        CHECK(HostMcu::runUntil([&] { return transaction.getState() == I2cTransaction::FINISHED; }));
+
+        CHECK(counter.post == 1 && counter.error == 0);
+        CHECK(fixture.sensor.registers[0x40] == 0x0D && fixture.sensor.registers[0x41] == 0x0E);
+        I2cBus::Statistics statistics = fixture.bus.getStatistics();
+        CHECK(statistics.busyRetries >= 2 && statistics.busyRetries <= 3);
+        CHECK(fixture.wire.startConditions == 1);
+
+        // One shot: the timer stops on its alarm.
+        CHECK(!retry.timer.isRunning());
+        return true;
+    }
+
+    // Steps at which the retry timer of `bus` went off, until `done()` holds.
+    template <typename Condition>
+    bool recordRetries(I2cBus& bus, uint32_t* retrySteps, size_t capacity, size_t& count, Condition done,
+                       uint32_t maxSteps = 200000)
+    {
+        count = 0;
+        uint32_t seen = bus.getStatistics().busyRetries;
+        return HostMcu::runUntil([&]
+        {
+            uint32_t retries = bus.getStatistics().busyRetries;
+            if(retries != seen && count < capacity)
+                retrySteps[count++] = HostMcu::steps;
+            seen = retries;
+            return done();
+        }, maxSteps);
+    }
+
+    bool testRetryBackoff(bool dma)
+    {
+        RetryTimer retry;
+        I2cBus::RetryPolicy policy;
+        policy.initialDelayUs = 10;
+        policy.multiplierPercent = 200;
+        policy.maxDelayUs = 80;
+
+        I2cBus::Builder busBuilder;
+        busBuilder.withTimer(retry.timer).withRetryPolicy(policy);
+        Fixture fixture(dma, I2cBus::Selection::Bus1, busBuilder, RetryTimer::configure, &retry);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        // Held for 10 + 20 + 40 + 80 + 80 us and a bit (84 steps per us).
+        fixture.wire.holdBusy(26500);
+
+        uint8_t data[] = { 0x5A };
+        I2cTransaction::Builder builder;
+        builder.setDirection(I2cTransaction::TX).withRegister(0x50).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+
+        uint32_t start = HostMcu::steps;
+        device << transaction;
+        uint32_t retrySteps[16];
+        size_t retries = 0;
+        CHECK(recordRetries(fixture.bus, retrySteps, 16, retries,
+                            [&] { return transaction.getState() == I2cTransaction::FINISHED; }));
+        CHECK(fixture.sensor.registers[0x50] == 0x5A);
+        CHECK(retries == 6 && fixture.bus.getStatistics().busyRetries == 6);
+
+        // A delay of n us is n ticks, the alarm one tick after the last (counting down to
+        // 0), give or take the prescaler phase.
+        const uint32_t delays[] = { 10, 20, 40, 80, 80, 80 };
+        uint32_t previous = start;
+        for(size_t i = 0; i < retries; i++)
+        {
+            uint32_t expected = (delays[i] + 1) * 84;
+            uint32_t interval = retrySteps[i] - previous;
+            CHECK(interval + 84 >= expected && interval <= expected + 84);
+            previous = retrySteps[i];
+        }
+        return true;
+    }
+
+    bool testRetryGiveUp(bool dma)
+    {
+        RetryTimer retry;
+        I2cBus::RetryPolicy policy;
+        policy.initialDelayUs = 10;
+        policy.maxDelayUs = 10;
+        policy.maxAttempts = 3;
+
+        I2cBus::Builder busBuilder;
+        busBuilder.withTimer(retry.timer).withRetryPolicy(policy);
+        Fixture fixture(dma, I2cBus::Selection::Bus1, busBuilder, RetryTimer::configure, &retry);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+        fixture.wire.holdBusy(UINT32_MAX);
+
+        uint8_t data[] = { 1 };
+        Counter counters[3];
+        I2cTransaction transactions[3];
+        for(size_t i = 0; i < 3; i++)
+        {
+            I2cTransaction::Builder builder;
+            countCallbacks(builder, counters[i]).setDirection(I2cTransaction::TX)
+                .withRegister(static_cast<uint8_t>(0x58 + i)).withData(data, sizeof(data));
+            transactions[i] = builder.build();
+        }
+
+        // Each queued transaction gets maxAttempts retries of its own, then its error
+        // callback.
+        device << transactions[0];
+        device << transactions[1];
+        CHECK(HostMcu::runUntil([&] { return counters[1].error == 1; }));
+        CHECK(counters[0].error == 1 && counters[0].post == 0 && counters[1].post == 0);
+        CHECK(transactions[0].getState() == I2cTransaction::ERROR);
+        CHECK(transactions[1].getState() == I2cTransaction::ERROR);
+
+        I2cBus::Statistics statistics = fixture.bus.getStatistics();
+        CHECK(statistics.retryGiveUps == 2 && statistics.transactionsFailed == 2);
+        CHECK(statistics.busyRetries == 2 * policy.maxAttempts);
+        CHECK(fixture.wire.startConditions == 0);
+
+        // Nothing left to retry: the timer stays quiet.
+        HostMcu::runUntil([] { return false; }, 5000);
+        CHECK(fixture.bus.getStatistics().busyRetries == statistics.busyRetries);
+
+        // The other master is gone: the next one goes through at once.
+        fixture.wire.clearInjections();
+        device << transactions[2];
+        CHECK(HostMcu::run());
+        CHECK(transactions[2].getState() == I2cTransaction::FINISHED && counters[2].post == 1);
+        CHECK(fixture.sensor.registers[0x5A] == 1 && fixture.sensor.registers[0x58] == 0);
+        return true;
+    }
+
+    // Two masters with the same firmware, one on I2C1 and one on I2C2 (each wire stands
+    // for the shared bus seen by one of them), held busy together.
+    struct ContendingMasters
+    {
+        ScopedTimer timers[2];
+        RegisterSlave sensors[2];
+        I2cBusStatic<8, 4> buses[2];
+        HostI2c* wires[2] = { &HostI2c::of(I2C1), &HostI2c::of(I2C2) };
+
+        ContendingMasters(bool dma, uint8_t jitterPercent)
+        {
+            HostMcu::reset();
+            for(size_t i = 0; i < 2; i++)
+            {
+                (void)Timer::Builder().timerSelection(i ? TIMER_4 : TIMER_3).setPrescaler(83).buildIn(timers[i]);
+
+                I2cBus::RetryPolicy policy;
+                policy.initialDelayUs = 100;
+                policy.multiplierPercent = 150;
+                policy.maxDelayUs = 400;
+                policy.jitterPercent = jitterPercent;
+
+                wires[i]->detachAll();
+                wires[i]->attach(SENSOR_ADDRESS, sensors[i]);
+
+                I2cBus::Builder builder;
+                builder.withBusSelection(i ? I2cBus::Selection::Bus2 : I2cBus::Selection::Bus1)
+                    .setBusSpeed(100000).withTimer(timers[i]).withRetryPolicy(policy);
+                if(dma)
+                    builder.enableDma();
+                I2cBus::Config config = builder.buildConfig();
+                (void)buses[i].init(config);
+
+                wires[i]->holdBusy(60000);
+            }
+        }
+
+        // Retry steps of both, relative to the start, until both sent one transaction.
+        bool run(uint32_t (&retrySteps)[2][16], size_t (&retries)[2])
+        {
+            uint8_t data[] = { 0x77 };
+            I2cTransaction transactions[2];
+            I2cDevice devices[2] = { I2cDevice(SENSOR_ADDRESS, &buses[0]), I2cDevice(SENSOR_ADDRESS, &buses[1]) };
+            for(size_t i = 0; i < 2; i++)
+            {
+                I2cTransaction::Builder builder;
+                builder.setDirection(I2cTransaction::TX).withRegister(0x10).withData(data, sizeof(data));
+                transactions[i] = builder.build();
+                devices[i] << transactions[i];
+            }
+
+            uint32_t start = HostMcu::steps;
+            uint32_t seen[2] = {};
+            retries[0] = retries[1] = 0;
+            bool finished = HostMcu::runUntil([&]
+            {
+                for(size_t i = 0; i < 2; i++)
+                {
+                    uint32_t busyRetries = buses[i].getStatistics().busyRetries;
+                    if(busyRetries != seen[i] && retries[i] < 16)
+                        retrySteps[i][retries[i]++] = HostMcu::steps - start;
+                    seen[i] = busyRetries;
+                }
+                return transactions[0].getState() == I2cTransaction::FINISHED &&
+                       transactions[1].getState() == I2cTransaction::FINISHED;
+            }, 200000);
+
+            return finished && sensors[0].registers[0x10] == 0x77 && sensors[1].registers[0x10] == 0x77;
+        }
+    };
+
+    bool testContendingMasters(bool dma)
+    {
+        uint32_t retrySteps[2][16];
+        size_t retries[2];
+
+        // Without jitter both retry together, every time. The one CPU serves their
+        // interrupts one after the other, so a few steps apart at most.
+        auto together = [&](size_t i)
+        {
+            uint32_t difference = retrySteps[0][i] > retrySteps[1][i] ? retrySteps[0][i] - retrySteps[1][i]
+                                                                       : retrySteps[1][i] - retrySteps[0][i];
+            return difference < 84;
+        };
+        {
+            ContendingMasters masters(dma, 0);
+            CHECK(masters.run(retrySteps, retries));
+            CHECK(retries[0] == retries[1] && retries[0] >= 3);
+            for(size_t i = 0; i < retries[0]; i++)
+                CHECK(together(i));
+        }
+
+        // With it they drift apart: the seeds differ per bus (and per MCU by its unique ID).
+        {
+            ContendingMasters masters(dma, 50);
+            CHECK(masters.run(retrySteps, retries));
+            CHECK(retries[0] >= 3 && retries[1] >= 3);
+            size_t apart = 0;
+            for(size_t i = 0; i < 3; i++)
+                apart += !together(i);
+            CHECK(apart >= 2);
+
+            // Never later than without jitter: it's only cut off the delays.
+            uint32_t unjittered = 0;
+            uint32_t delayUs = 100;
+            for(size_t i = 0; i < 3; i++)
+            {
+                unjittered += (delayUs + 1) * 84;
+                delayUs = delayUs * 3 / 2 > 400 ? 400 : delayUs * 3 / 2;
+                CHECK(retrySteps[0][i] <= unjittered + 84 * (i + 1));
+                CHECK(retrySteps[1][i] <= unjittered + 84 * (i + 1));
+            }
+        }
+        return true;
+    }
+
+    struct AddressingMaster
+    {
+        HostI2c* wire;
+        const uint8_t* data;
+        size_t length;
+    };
+
+    bool testArbitrationToAddressingMaster(bool dma)
+    {
+        // No retry timer: the bus waits for the STOP of the master that won.
+        RegisterMapFixture map(dma);
+        I2cDevice device(SENSOR_ADDRESS, &map.fixture.bus);
+
+        // It wins the arbitration of our address byte, then writes to our own slave.
+        static const uint8_t write[] = { 0x02, 0xC1, 0xC2 };
+        AddressingMaster other{ &map.fixture.wire, write, sizeof(write) };
+        map.fixture.wire.loseArbitration(0, [](void* context)
+        {
+            AddressingMaster* other = static_cast<AddressingMaster*>(context);
+            other->wire->masterTransfer(OWN_ADDRESS, other->data, other->length);
+        }, &other, 20);
+
+        uint8_t data[] = { 0x31, 0x32, 0x33 };
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX)
+            .withRegister(0x20).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+
+        device << transaction;
+        CHECK(HostMcu::run());
+
+        CHECK(map.fixture.wire.masterResult.done && !map.fixture.wire.masterResult.nacked);
+        uint8_t registers[2] = {};
+        map.slave.read(0x02, registers, sizeof(registers));
+        CHECK(registers[0] == 0xC1 && registers[1] == 0xC2 && map.writes == 1);
+
+        CHECK(transaction.getState() == I2cTransaction::FINISHED);
+        CHECK(counter.post == 1 && counter.error == 0);
+        CHECK(memcmp(&map.fixture.sensor.registers[0x20], data, sizeof(data)) == 0);
+        I2cBus::Statistics statistics = map.fixture.bus.getStatistics();
+        CHECK(statistics.arbitrationLosses == 1 && statistics.arbitrationRetries == 1);
+        CHECK(statistics.busyRetries == 0);
+        CHECK(map.fixture.bus.getState() == I2cBus::State::Idle);
+        return true;
+    }
+
+    bool testArbitrationThenBusy(bool dma)
+    {
+        RetryTimer retry;
+        I2cBus::RetryPolicy policy;
+        policy.initialDelayUs = 20;
+        policy.maxDelayUs = 20;
+
+        I2cBus::Builder busBuilder;
+        busBuilder.withTimer(retry.timer).withRetryPolicy(policy);
+        Fixture fixture(dma, I2cBus::Selection::Bus1, busBuilder, RetryTimer::configure, &retry);
+        I2cDevice device(SENSOR_ADDRESS, &fixture.bus);
+
+        // Lost on the first data byte, and the winner keeps the bus for a while: the
+        // whole transaction is sent again once the retry timer finds it free.
+        fixture.wire.loseArbitration(2, nullptr, nullptr, 5000);
+
+        uint8_t data[] = { 0x41, 0x42 };
+        Counter counter;
+        I2cTransaction::Builder builder;
+        countCallbacks(builder, counter).setDirection(I2cTransaction::TX)
+            .withRegister(0x44).withData(data, sizeof(data));
+        I2cTransaction transaction = builder.build();
+
+        device << transaction;
+        CHECK(HostMcu::runUntil([&] { return transaction.getState() == I2cTransaction::FINISHED; }));
+        CHECK(counter.post == 1 && counter.error == 0);
+        CHECK(fixture.sensor.registers[0x44] == 0x41 && fixture.sensor.registers[0x45] == 0x42);
+
+        I2cBus::Statistics statistics = fixture.bus.getStatistics();
+        CHECK(statistics.arbitrationLosses == 1 && statistics.arbitrationRetries == 1);
+        CHECK(statistics.busyRetries >= 2);
+        CHECK(fixture.wire.startConditions == 2);
+        return true;
+    }
+
+    struct Test
+    {
+        const char* name;
+        bool (*function)(bool dma);
+        bool dmaOnly;
+    };
+
+    const Test tests[] =
+    {
+        { "write",                  testWrite,                false },
+        { "read",                   testRead,                 false },
+        { "chain",                  testChain,                false },
+        { "acknowledge_failure",    testAcknowledgeFailure,   false },
+        { "arbitration_lost_chain", testArbitrationLostChain, false },
+        { "cancel_chain_midway",    testCancelChainMidway,    false },
+        { "cancel_read_tail",       testCancelReadTail,       false },
+        { "intrusive_queue",        testIntrusiveQueue,       false },
+        { "spsc_queue",             testSpscQueue,            false },
+        { "detach_in_flight",       testDetachInFlight,       false },
+        { "cancel_at_repeated_start", testCancelAtRepeatedStart, false },
+        { "bus_error",              testBusError,             false },
+        { "dma_stream_taken",       testDmaStreamTaken,       true  },
+        { "publish_to",             testPublishTo,            false },
+        { "coroutine",              testCoroutine,            false },
+        { "register_map_slave",     testRegisterMapSlave,     false },
+        { "slave_dma",              testSlaveDma,             true  },
+        { "timer_retry",            testTimerRetry,           false },
+        { "retry_backoff",          testRetryBackoff,         false },
+        { "retry_give_up",          testRetryGiveUp,          false },
+        { "contending_masters",     testContendingMasters,    false },
+        { "arbitration_to_addressing_master", testArbitrationToAddressingMaster, false },
+        { "arbitration_then_busy",  testArbitrationThenBusy,  false },
+    };
+
+    bool run(const Test& test)
+    {
+        bool passed = true;
+        for(bool dma : { false, true })
+        {
+            if(test.dmaOnly && !dma)
+                continue;
+
+            bool result = test.function(dma);
+            printf("%s %s (%s)\n", result ? "PASS" : "FAIL", test.name, dma ? "dma" : "interrupt");
+            passed &= result;
+        }
+        return passed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv, run);
+}
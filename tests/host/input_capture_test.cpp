@@ -0,0 +1,262 @@
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "clock.hpp"
+#include "dma_streams.hpp"
+#include "input_capture.hpp"
+
+#include "stm32f4xx_ll_dma.h"
+
+// ============================================================================
+// InputCapture on TIM3 channel 1, fed by its DMA stream (DMA1 stream 4) or by the capture
+// interrupt, every test run both ways. The input is a square wave driven by the timer
+// model; at one tick per step (PSC = 0) every period and pulse width must be measured
+// to the tick, across the wraps of the 16 bit counter.
+// ============================================================================
+
+namespace
+{
+    constexpr uint16_t BUFFER_LENGTH = 32;
+    constexpr uint32_t TICK_FREQUENCY = 84000000;
+
+    struct CaptureFixture
+    {
+        ScopedTimer timer;
+        uint32_t buffer[BUFFER_LENGTH] = {};
+        InputCapture capture;
+        HostTim& model = HostTim::of(TIM3);
+
+        CaptureFixture(bool dma, InputCapture::Config config, uint16_t length = BUFFER_LENGTH)
+        {
+            HostMcu::reset();
+            (void)Timer::Builder().timerSelection(TIMER_3).buildIn(timer);
+
+            config.buffer = buffer;
+            config.length = length;
+            config.dma = dma;
+            (void)capture.init(timer, config);
+        }
+
+        ~CaptureFixture()
+        {
+            capture.stop();
+        }
+
+        void wait(uint32_t steps)
+        {
+            HostMcu::runUntil([] { return false; }, steps);
+        }
+    };
+
+    InputCapture::Config rising()
+    {
+        InputCapture::Config config;
+        config.edge = InputCapture::Edge::Rising;
+        return config;
+    }
+
+    bool testMeasurePeriod(bool dma)
+    {
+        CaptureFixture fixture(dma, rising());
+        fixture.capture.start();
+        CHECK(fixture.capture.isDmaFed() == dma);
+        fixture.model.driveInput(0, 1000, 250);
+
+        // Nothing to measure before the second edge.
+        InputCapture::Measurement measurement;
+        fixture.wait(500);
+        CHECK(!fixture.capture.measure(measurement));
+
+        // Batches of 20 periods, the counter wrapping every 65.536 of them.
+        for(int batch = 0; batch < 10; batch++)
+        {
+            fixture.wait(20000);
+            CHECK(fixture.capture.measure(measurement));
+            CHECK(measurement.periodTicks == 1000);
+            CHECK(measurement.frequencyMilliHz == uint64_t(TICK_FREQUENCY) * 1000 / 1000);
+            CHECK(measurement.periods == 20);
+            CHECK(measurement.highTicks == 0 && measurement.dutyPermille == 0);
+        }
+
+        // Everything was consumed: no new edge, no new period.
+        CHECK(fixture.capture.available() == 0 && !fixture.capture.measure(measurement));
+        CHECK(fixture.capture.getOverruns() == 0);
+        return true;
+    }
+
+    bool testMeasureDuty(bool dma)
+    {
+        InputCapture::Config config;
+        config.edge = InputCapture::Edge::Both;
+        CaptureFixture fixture(dma, config);
+        fixture.capture.start();
+        fixture.model.driveInput(0, 700, 210);
+
+        InputCapture::Measurement measurement;
+        fixture.wait(700 * 10 + 100);
+        CHECK(fixture.capture.measure(measurement));
+        CHECK(measurement.periodTicks == 700 && measurement.highTicks == 210);
+        CHECK(measurement.dutyPermille == 300 && measurement.periods == 10);
+
+        // Another wave, the batch over the change thrown away. The edge kept from it
+        // still knows which way it went.
+        fixture.model.driveInput(0, 1000, 900);
+        fixture.wait(1000 * 2);
+        CHECK(fixture.capture.measure(measurement));
+        fixture.wait(1000 * 10);
+        CHECK(fixture.capture.measure(measurement));
+        CHECK(measurement.periodTicks == 1000 && measurement.highTicks == 900);
+        CHECK(measurement.dutyPermille == 900);
+        return true;
+    }
+
+    bool testPrescaler(bool dma)
+    {
+        InputCapture::Config config = rising();
+        config.prescaler = 2;
+        CaptureFixture fixture(dma, config);
+        fixture.capture.start();
+        fixture.model.driveInput(0, 300, 100);
+
+        // One capture every 4 edges, still measured per period.
+        InputCapture::Measurement measurement;
+        fixture.wait(300 * 4 * 10 + 100);
+        CHECK(fixture.capture.available() == 10);
+        CHECK(fixture.capture.measure(measurement));
+        CHECK(measurement.periodTicks == 300 && measurement.periods == 9 * 4);
+        return true;
+    }
+
+    bool testRestart(bool dma)
+    {
+        CaptureFixture fixture(dma, rising());
+        fixture.capture.start();
+        fixture.model.driveInput(0, 1000, 500);
+        fixture.wait(5500);
+        CHECK(fixture.capture.available() == 6);
+
+        // Restarted without stop(): the ring starts over with the stream, not just the
+        // indexes (a stream still enabled would ignore its new length).
+        fixture.capture.start();
+        CHECK(fixture.capture.isDmaFed() == dma && fixture.capture.available() == 0);
+        if(dma)
+            CHECK(LL_DMA_GetDataLength(DMA1, LL_DMA_STREAM_4) == BUFFER_LENGTH);
+
+        fixture.wait(5000);
+        CHECK(fixture.capture.available() == 5);
+
+        InputCapture::Measurement measurement;
+        CHECK(fixture.capture.measure(measurement));
+        CHECK(measurement.periodTicks == 1000 && measurement.periods == 4);
+
+        fixture.capture.stop();
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_4));
+        fixture.wait(3000);
+        CHECK(fixture.capture.available() == 0);
+        return true;
+    }
+
+    bool testOverrun(bool dma)
+    {
+        // Interrupt mode: the ring holds length - 1 captures, the rest are counted lost.
+        CaptureFixture fixture(dma, rising(), 4);
+        fixture.capture.start();
+        fixture.model.driveInput(0, 100, 50);
+        fixture.wait(100 * 10 + 50);
+
+        // 11 edges: the first 3 kept, 8 lost.
+        CHECK(fixture.capture.available() == 3);
+        CHECK(fixture.capture.getOverruns() == 8);
+
+        uint32_t timestamps[4];
+        CHECK(fixture.capture.read(timestamps, 4) == 3);
+        CHECK(timestamps[1] - timestamps[0] == 100 && timestamps[2] - timestamps[1] == 100);
+        return true;
+    }
+
+    bool testSharedWithClock(bool dma)
+    {
+        // The Clock takes the counter first and runs it down: intervals count backwards.
+        CaptureFixture fixture(dma, rising());
+        Clock clock(fixture.timer);
+        fixture.capture.start();
+        CHECK(fixture.timer.getMaxCount() == UINT16_MAX);
+        fixture.model.driveInput(0, 1234, 600);
+
+        InputCapture::Measurement measurement;
+        for(int batch = 0; batch < 5; batch++)
+        {
+            fixture.wait(1234 * 20);
+            CHECK(fixture.capture.measure(measurement));
+            CHECK(measurement.periodTicks == 1234);
+        }
+        CHECK(clock.getTicks() >= 5 * 1234 * 20);
+        return true;
+    }
+
+    bool testDmaStreamTaken(bool dma)
+    {
+        // Someone else holds DMA1 stream 4: the channel falls back to its interrupt.
+        CHECK(DmaStreams::claim(DMA1, LL_DMA_STREAM_4));
+        {
+            CaptureFixture fixture(dma, rising());
+            fixture.capture.start();
+            CHECK(!fixture.capture.isDmaFed());
+            fixture.model.driveInput(0, 1000, 500);
+            fixture.wait(5500);
+
+            InputCapture::Measurement measurement;
+            CHECK(fixture.capture.measure(measurement));
+            CHECK(measurement.periodTicks == 1000 && measurement.periods == 5);
+        }
+        CHECK(DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_4));
+        DmaStreams::release(DMA1, LL_DMA_STREAM_4);
+        return true;
+    }
+
+    enum class Modes
+    {
+        Both,
+        InterruptOnly,
+        DmaOnly,
+    };
+
+    struct Test
+    {
+        const char* name;
+        bool (*function)(bool dma);
+        Modes modes;
+    };
+
+    const Test tests[] =
+    {
+        { "measure_period",    testMeasurePeriod,   Modes::Both },
+        { "measure_duty",      testMeasureDuty,     Modes::Both },
+        { "prescaler",         testPrescaler,       Modes::Both },
+        { "restart",           testRestart,         Modes::Both },
+        { "overrun",           testOverrun,         Modes::InterruptOnly },
+        { "shared_with_clock", testSharedWithClock, Modes::Both },
+        { "dma_stream_taken",  testDmaStreamTaken,  Modes::DmaOnly },
+    };
+
+    bool run(const Test& test)
+    {
+        bool passed = true;
+        for(bool dma : { false, true })
+        {
+            if((test.modes == Modes::InterruptOnly && dma) || (test.modes == Modes::DmaOnly && !dma))
+                continue;
+
+            bool result = test.function(dma);
+            printf("%s %s (%s)\n", result ? "PASS" : "FAIL", test.name, dma ? "dma" : "interrupt");
+            passed &= result;
+        }
+        return passed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv, run);
+}
@@ -0,0 +1,360 @@
+#include "host_mcu.hpp"
+
+#include "stm32f4xx_ll_dma.h"
+
+DMA_TypeDef hostDma[2];
+
+// ============================================================================
+// DMA1 and DMA2 streams, as far as the I2C and timer requests go (RM0368 tables 27
+// and 28). A stream moves one item per step while its request is active: a byte for
+// I2C, a word for the timers. The flag clear registers (LIFCR/HIFCR) are applied before
+// every access to the stream and between steps, like write-1-to-clear bits. Only the
+// DMA1 stream interrupts are raised, the timer drivers don't use any.
+// ============================================================================
+
+namespace
+{
+    constexpr uint32_t FLAG_TE = 1U << 3;
+    constexpr uint32_t FLAG_TC = 1U << 5;
+
+    constexpr uint8_t flagOffset[] = { 0, 6, 16, 22 };
+
+    constexpr IRQn_Type dma1Irqs[] =
+    {
+        DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+        DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn,
+    };
+
+    struct I2cRequest
+    {
+        I2C_TypeDef* i2c;
+        bool transmit;
+        uint32_t stream;
+        uint32_t channel;
+    };
+
+    const I2cRequest i2cRequests[] =
+    {
+        { I2C1, false, LL_DMA_STREAM_0, LL_DMA_CHANNEL_1 },
+        { I2C1, false, LL_DMA_STREAM_5, LL_DMA_CHANNEL_1 },
+        { I2C1, true,  LL_DMA_STREAM_6, LL_DMA_CHANNEL_1 },
+        { I2C1, true,  LL_DMA_STREAM_7, LL_DMA_CHANNEL_1 },
+        { I2C2, false, LL_DMA_STREAM_2, LL_DMA_CHANNEL_7 },
+        { I2C2, false, LL_DMA_STREAM_3, LL_DMA_CHANNEL_7 },
+        { I2C2, true,  LL_DMA_STREAM_7, LL_DMA_CHANNEL_7 },
+        { I2C3, false, LL_DMA_STREAM_2, LL_DMA_CHANNEL_3 },
+        { I2C3, true,  LL_DMA_STREAM_4, LL_DMA_CHANNEL_3 },
+    };
+
+    // Channel -1 is the update request (TIMx_UP), 0-3 the capture/compare ones.
+    struct TimRequest
+    {
+        TIM_TypeDef* tim;
+        int8_t channel;
+        DMA_TypeDef* dma;
+        uint32_t stream;
+        uint32_t channelSelection;
+    };
+
+    const TimRequest timRequests[] =
+    {
+        { TIM1, -1, DMA2, LL_DMA_STREAM_5, LL_DMA_CHANNEL_6 },
+        { TIM1,  0, DMA2, LL_DMA_STREAM_1, LL_DMA_CHANNEL_6 },
+        { TIM1,  1, DMA2, LL_DMA_STREAM_2, LL_DMA_CHANNEL_6 },
+        { TIM1,  2, DMA2, LL_DMA_STREAM_6, LL_DMA_CHANNEL_6 },
+        { TIM1,  3, DMA2, LL_DMA_STREAM_4, LL_DMA_CHANNEL_6 },
+        { TIM2, -1, DMA1, LL_DMA_STREAM_1, LL_DMA_CHANNEL_3 },
+        { TIM2,  0, DMA1, LL_DMA_STREAM_5, LL_DMA_CHANNEL_3 },
+        { TIM2,  1, DMA1, LL_DMA_STREAM_6, LL_DMA_CHANNEL_3 },
+        { TIM2,  2, DMA1, LL_DMA_STREAM_1, LL_DMA_CHANNEL_3 },
+        { TIM2,  3, DMA1, LL_DMA_STREAM_7, LL_DMA_CHANNEL_3 },
+        { TIM3, -1, DMA1, LL_DMA_STREAM_2, LL_DMA_CHANNEL_5 },
+        { TIM3,  0, DMA1, LL_DMA_STREAM_4, LL_DMA_CHANNEL_5 },
+        { TIM3,  1, DMA1, LL_DMA_STREAM_5, LL_DMA_CHANNEL_5 },
+        { TIM3,  2, DMA1, LL_DMA_STREAM_7, LL_DMA_CHANNEL_5 },
+        { TIM3,  3, DMA1, LL_DMA_STREAM_2, LL_DMA_CHANNEL_5 },
+        { TIM4, -1, DMA1, LL_DMA_STREAM_6, LL_DMA_CHANNEL_2 },
+        { TIM4,  0, DMA1, LL_DMA_STREAM_0, LL_DMA_CHANNEL_2 },
+        { TIM4,  1, DMA1, LL_DMA_STREAM_3, LL_DMA_CHANNEL_2 },
+        { TIM4,  2, DMA1, LL_DMA_STREAM_7, LL_DMA_CHANNEL_2 },
+        { TIM5, -1, DMA1, LL_DMA_STREAM_0, LL_DMA_CHANNEL_6 },
+        { TIM5,  0, DMA1, LL_DMA_STREAM_2, LL_DMA_CHANNEL_6 },
+        { TIM5,  1, DMA1, LL_DMA_STREAM_4, LL_DMA_CHANNEL_6 },
+        { TIM5,  2, DMA1, LL_DMA_STREAM_0, LL_DMA_CHANNEL_6 },
+        { TIM5,  3, DMA1, LL_DMA_STREAM_1, LL_DMA_CHANNEL_6 },
+    };
+
+    // NDTR when the stream was enabled: the memory side index is the count already moved.
+    uint32_t startLength[2][8];
+
+    DMA_Stream_TypeDef& streamOf(DMA_TypeDef* dma, uint32_t stream)
+    {
+        hostDmaApplyFlagClears();
+        return dma->stream[stream];
+    }
+
+    uint32_t& statusOf(DMA_TypeDef* dma, uint32_t stream)
+    {
+        return stream < 4 ? dma->LISR : dma->HISR;
+    }
+
+    void setFlag(DMA_TypeDef* dma, uint32_t stream, uint32_t flag)
+    {
+        statusOf(dma, stream) |= flag << flagOffset[stream % 4];
+    }
+
+    bool flagActive(DMA_TypeDef* dma, uint32_t stream, uint32_t flag)
+    {
+        return statusOf(dma, stream) & (flag << flagOffset[stream % 4]);
+    }
+
+    const I2cRequest* activeStream(I2C_TypeDef* i2c, bool transmit)
+    {
+        for(const I2cRequest& request : i2cRequests)
+        {
+            if(request.i2c != i2c || request.transmit != transmit)
+                continue;
+
+            const DMA_Stream_TypeDef& stream = DMA1->stream[request.stream];
+            if((stream.CR & DMA_SxCR_EN) && (stream.CR & DMA_SxCR_CHSEL) == request.channel)
+                return &request;
+        }
+        return nullptr;
+    }
+
+    // Memory side index of the next item.
+    uint32_t itemIndex(DMA_TypeDef* dma, uint32_t stream)
+    {
+        return startLength[dma - hostDma][stream] - dma->stream[stream].NDTR;
+    }
+
+    void itemMoved(DMA_TypeDef* dma, uint32_t stream)
+    {
+        DMA_Stream_TypeDef& registers = dma->stream[stream];
+        if(--registers.NDTR)
+            return;
+
+        setFlag(dma, stream, FLAG_TC);
+        if(registers.CR & DMA_SxCR_CIRC)
+            registers.NDTR = startLength[dma - hostDma][stream];
+        else
+            registers.CR &= ~DMA_SxCR_EN;
+    }
+
+    void moveItem(const I2cRequest& request)
+    {
+        DMA_Stream_TypeDef& stream = DMA1->stream[request.stream];
+        uint32_t index = itemIndex(DMA1, request.stream);
+        HostI2c& model = HostI2c::of(request.i2c);
+
+        if(request.transmit)
+            model.writeData(reinterpret_cast<const uint8_t*>(stream.M0AR)[index]);
+        else
+            reinterpret_cast<uint8_t*>(stream.M0AR)[index] = model.readData();
+
+        itemMoved(DMA1, request.stream);
+    }
+
+    bool timRequested(const TimRequest& request)
+    {
+        const DMA_Stream_TypeDef& stream = request.dma->stream[request.stream];
+        if(!(stream.CR & DMA_SxCR_EN) || (stream.CR & DMA_SxCR_CHSEL) != request.channelSelection)
+            return false;
+
+        HostTim& model = HostTim::of(request.tim);
+        return request.channel < 0 ? model.updateRequest() : model.captureRequest(request.channel);
+    }
+
+    void moveItem(const TimRequest& request)
+    {
+        DMA_Stream_TypeDef& stream = request.dma->stream[request.stream];
+        uint32_t index = itemIndex(request.dma, request.stream);
+        HostTim& model = HostTim::of(request.tim);
+
+        // The update request feeds the DMAR burst, a capture one reads CCRx.
+        if(request.channel < 0)
+            model.writeBurst(reinterpret_cast<const uint32_t*>(stream.M0AR)[index]);
+        else
+            reinterpret_cast<uint32_t*>(stream.M0AR)[index] = model.readCapture(request.channel);
+
+        itemMoved(request.dma, request.stream);
+    }
+}
+
+void hostDmaReset()
+{
+    for(DMA_TypeDef& dma : hostDma)
+        dma = DMA_TypeDef{};
+}
+
+void hostDmaApplyFlagClears()
+{
+    for(DMA_TypeDef& dma : hostDma)
+    {
+        dma.LISR &= ~dma.LIFCR;
+        dma.HISR &= ~dma.HIFCR;
+        dma.LIFCR = 0;
+        dma.HIFCR = 0;
+    }
+}
+
+bool hostDmaService()
+{
+    for(const I2cRequest& request : i2cRequests)
+    {
+        if(!(request.i2c->CR2 & I2C_CR2_DMAEN) || !activeStream(request.i2c, request.transmit))
+            continue;
+
+        // The request follows the flag that would raise the BUF interrupt.
+        bool requested = request.transmit ? HostI2c::of(request.i2c).wantsTxData()
+                                          : (request.i2c->SR1 & I2C_SR1_RXNE);
+        if(!requested || activeStream(request.i2c, request.transmit) != &request)
+            continue;
+
+        moveItem(request);
+        return true;
+    }
+
+    for(const TimRequest& request : timRequests)
+    {
+        if(!timRequested(request))
+            continue;
+
+        moveItem(request);
+        return true;
+    }
+    return false;
+}
+
+bool hostDmaIrqPending(IRQn_Type& irq)
+{
+    for(uint32_t stream = 0; stream < 8; stream++)
+    {
+        uint32_t cr = DMA1->stream[stream].CR;
+        if(((cr & DMA_SxCR_TCIE) && flagActive(DMA1, stream, FLAG_TC)) ||
+           ((cr & DMA_SxCR_TEIE) && flagActive(DMA1, stream, FLAG_TE)))
+        {
+            irq = dma1Irqs[stream];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool hostDmaRxLastPending(I2C_TypeDef* i2c, bool rxneSet)
+{
+    const I2cRequest* request = activeStream(i2c, false);
+    if(!request)
+        return false;
+
+    // The byte being received is the last one the stream will take.
+    return DMA1->stream[request->stream].NDTR == (rxneSet ? 2U : 1U);
+}
+
+// ============================================================================
+// LL stand-ins
+// ============================================================================
+
+extern "C" {
+
+void LL_DMA_EnableStream(DMA_TypeDef* dma, uint32_t stream)
+{
+    DMA_Stream_TypeDef& registers = streamOf(dma, stream);
+    startLength[dma - hostDma][stream] = registers.NDTR;
+    registers.CR |= DMA_SxCR_EN;
+}
+
+void LL_DMA_DisableStream(DMA_TypeDef* dma, uint32_t stream)
+{
+    // The beat in progress always completes within the step, so EN drops at once.
+    streamOf(dma, stream).CR &= ~DMA_SxCR_EN;
+}
+
+uint32_t LL_DMA_IsEnabledStream(DMA_TypeDef* dma, uint32_t stream)
+{
+    return (streamOf(dma, stream).CR & DMA_SxCR_EN) != 0;
+}
+
+static void modifyCr(DMA_TypeDef* dma, uint32_t stream, uint32_t mask, uint32_t value)
+{
+    DMA_Stream_TypeDef& registers = streamOf(dma, stream);
+    registers.CR = (registers.CR & ~mask) | value;
+}
+
+void LL_DMA_SetChannelSelection(DMA_TypeDef* dma, uint32_t stream, uint32_t channel)
+{
+    modifyCr(dma, stream, DMA_SxCR_CHSEL, channel);
+}
+
+void LL_DMA_SetDataTransferDirection(DMA_TypeDef* dma, uint32_t stream, uint32_t direction)
+{
+    modifyCr(dma, stream, DMA_SxCR_DIR, direction);
+}
+
+void LL_DMA_SetMode(DMA_TypeDef* dma, uint32_t stream, uint32_t mode)
+{
+    modifyCr(dma, stream, DMA_SxCR_CIRC, mode);
+}
+
+void LL_DMA_SetStreamPriorityLevel(DMA_TypeDef* dma, uint32_t stream, uint32_t priority)
+{
+    modifyCr(dma, stream, DMA_SxCR_PL, priority);
+}
+
+void LL_DMA_SetPeriphIncMode(DMA_TypeDef* dma, uint32_t stream, uint32_t incrementMode)
+{
+    modifyCr(dma, stream, DMA_SxCR_PINC, incrementMode);
+}
+
+void LL_DMA_SetMemoryIncMode(DMA_TypeDef* dma, uint32_t stream, uint32_t incrementMode)
+{
+    modifyCr(dma, stream, DMA_SxCR_MINC, incrementMode);
+}
+
+void LL_DMA_SetPeriphSize(DMA_TypeDef* dma, uint32_t stream, uint32_t size)
+{
+    modifyCr(dma, stream, DMA_SxCR_PSIZE, size);
+}
+
+void LL_DMA_SetMemorySize(DMA_TypeDef* dma, uint32_t stream, uint32_t size)
+{
+    modifyCr(dma, stream, DMA_SxCR_MSIZE, size);
+}
+
+void LL_DMA_ConfigAddresses(DMA_TypeDef* dma, uint32_t stream, uintptr_t sourceAddress,
+                            uintptr_t destinationAddress, uint32_t direction)
+{
+    DMA_Stream_TypeDef& registers = streamOf(dma, stream);
+    if(direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH)
+    {
+        registers.M0AR = sourceAddress;
+        registers.PAR = destinationAddress;
+    }
+    else
+    {
+        registers.PAR = sourceAddress;
+        registers.M0AR = destinationAddress;
+    }
+}
+
+void LL_DMA_SetDataLength(DMA_TypeDef* dma, uint32_t stream, uint32_t length)
+{
+    streamOf(dma, stream).NDTR = length;
+}
+
+uint32_t LL_DMA_GetDataLength(DMA_TypeDef* dma, uint32_t stream)
+{
+    return streamOf(dma, stream).NDTR;
+}
+
+void LL_DMA_EnableIT_TC(DMA_TypeDef* dma, uint32_t stream)
+{
+    streamOf(dma, stream).CR |= DMA_SxCR_TCIE;
+}
+
+void LL_DMA_EnableIT_TE(DMA_TypeDef* dma, uint32_t stream)
+{
+    streamOf(dma, stream).CR |= DMA_SxCR_TEIE;
+}
+
+}
@@ -0,0 +1,257 @@
+#include "host_mcu.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Core, RCC and GPIO stand-ins, and the step loop.
+// ============================================================================
+
+RCC_TypeDef hostRcc;
+GPIO_TypeDef hostGpio[3];
+uint32_t hostUid[3] = { 0x00450032U, 0x31385107U, 0x33383730U };
+
+uint32_t SystemCoreClock = 84000000U;
+
+uint32_t HostMcu::steps = 0;
+uint32_t HostMcu::interrupts = 0;
+
+namespace
+{
+    // HOST_TRACE=1 in the environment prints the registers at every step.
+    const bool trace = getenv("HOST_TRACE") != nullptr;
+
+    bool irqEnabled[HOST_IRQ_COUNT];
+    uint32_t primask = 0;
+
+    struct I2cLines
+    {
+        I2C_TypeDef* i2c;
+        IRQn_Type ev;
+        IRQn_Type er;
+    };
+
+    const I2cLines i2cLines[] =
+    {
+        { I2C1, I2C1_EV_IRQn, I2C1_ER_IRQn },
+        { I2C2, I2C2_EV_IRQn, I2C2_ER_IRQn },
+        { I2C3, I2C3_EV_IRQn, I2C3_ER_IRQn },
+    };
+
+    TIM_TypeDef* const timers[] = { TIM1, TIM2, TIM3, TIM4, TIM5, TIM9, TIM10, TIM11 };
+
+    // Timer lines, in vector order.
+    constexpr IRQn_Type timerIrqs[] =
+    {
+        TIM1_BRK_TIM9_IRQn, TIM1_UP_TIM10_IRQn, TIM1_TRG_COM_TIM11_IRQn, TIM1_CC_IRQn,
+        TIM2_IRQn, TIM3_IRQn, TIM4_IRQn, TIM5_IRQn,
+    };
+
+    bool dispatch(IRQn_Type irq)
+    {
+        for(size_t i = 0; i < hostVectorCount; i++)
+        {
+            if(hostVectors[i].irq == irq)
+            {
+                HostMcu::interrupts++;
+                hostVectors[i].handler();
+                for(TIM_TypeDef* timer : timers)
+                    HostTim::of(timer).interruptServed(irq);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool pendingIrq(IRQn_Type& irq)
+    {
+        for(const I2cLines& lines : i2cLines)
+        {
+            HostI2c& model = HostI2c::of(lines.i2c);
+            if(irqEnabled[lines.er] && model.errorPending())
+            {
+                irq = lines.er;
+                return true;
+            }
+            if(irqEnabled[lines.ev] && model.eventPending())
+            {
+                irq = lines.ev;
+                return true;
+            }
+        }
+
+        IRQn_Type dmaIrq;
+        if(hostDmaIrqPending(dmaIrq) && irqEnabled[dmaIrq])
+        {
+            irq = dmaIrq;
+            return true;
+        }
+
+        for(IRQn_Type timerIrq : timerIrqs)
+        {
+            if(!irqEnabled[timerIrq])
+                continue;
+
+            for(TIM_TypeDef* timer : timers)
+            {
+                if(HostTim::of(timer).irqPending(timerIrq))
+                {
+                    irq = timerIrq;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+}
+
+void HostMcu::reset()
+{
+    for(const I2cLines& lines : i2cLines)
+    {
+        HostI2c& model = HostI2c::of(lines.i2c);
+        model.resetWire();
+        model.startConditions = 0;
+        model.stopConditions = 0;
+        model.bytesOnWire = 0;
+        model.clearInjections();
+        *lines.i2c = I2C_TypeDef{};
+    }
+
+    hostDmaReset();
+    for(TIM_TypeDef* timer : timers)
+        HostTim::of(timer).reset();
+    hostRcc = RCC_TypeDef{};
+    SystemCoreClock = 84000000U;
+
+    memset(irqEnabled, 0, sizeof(irqEnabled));
+    primask = 0;
+    steps = 0;
+    interrupts = 0;
+}
+
+bool HostMcu::step()
+{
+    hostDmaApplyFlagClears();
+    steps++;
+
+    if(trace)
+    {
+        for(const I2cLines& lines : i2cLines)
+        {
+            if(lines.i2c->CR1)
+                printf("[%u] I2C%d CR1 %04x CR2 %04x SR1 %04x SR2 %04x\n", steps,
+                       static_cast<int>(&lines - i2cLines) + 1, lines.i2c->CR1, lines.i2c->CR2,
+                       lines.i2c->SR1, lines.i2c->SR2);
+        }
+    }
+
+    bool busy = false;
+
+    IRQn_Type irq;
+    if(!primask && pendingIrq(irq))
+    {
+        if(trace)
+            printf("[%u] IRQ %d\n", steps, irq);
+        busy |= dispatch(irq);
+    }
+
+    busy |= hostDmaService();
+
+    for(const I2cLines& lines : i2cLines)
+        busy |= HostI2c::of(lines.i2c).tick();
+
+    // A running timer isn't work left to do: run() would never end.
+    for(TIM_TypeDef* timer : timers)
+        HostTim::of(timer).tick();
+    return busy;
+}
+
+bool HostMcu::run(uint32_t maxSteps)
+{
+    for(uint32_t i = 0; i < maxSteps; i++)
+    {
+        if(!step())
+            return true;
+    }
+    return false;
+}
+
+bool HostMcu::isIrqEnabled(IRQn_Type irq)
+{
+    return irqEnabled[irq];
+}
+
+extern "C" {
+
+void SystemCoreClockUpdate(void)
+{
+
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    irqEnabled[irq] = true;
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    irqEnabled[irq] = false;
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+    (void)irq;
+    (void)priority;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t value)
+{
+    primask = value;
+}
+
+void __disable_irq(void)
+{
+    primask = 1;
+}
+
+void __enable_irq(void)
+{
+    primask = 0;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init)
+{
+    (void)port;
+    (void)init;
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef* port, uint32_t pin)
+{
+    (void)port;
+    (void)pin;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+    if(state == GPIO_PIN_SET)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin)
+{
+    // Pulled-up lines nobody holds low.
+    (void)port;
+    (void)pin;
+    return GPIO_PIN_SET;
+}
+
+}
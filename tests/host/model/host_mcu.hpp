@@ -0,0 +1,366 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "stm32f4xx.h"
+
+// ============================================================================
+// Host model of the parts of the STM32F401 the I2C and timer drivers touch, so the
+// real I2cBus state machine and timer drivers run off-target.
+//
+// Time advances in steps. Each step, in this order:
+//   1. Dispatches one pending interrupt (I2C EV/ER, DMA stream, TIM) whose NVIC line
+//      is enabled, through the vector table of the test (hostVectors[]).
+//   2. Moves one item through a DMA stream with an active request.
+//   3. Advances the wire of every I2C peripheral by one stage: START, the address or a
+//      data byte shifted out/in, a STOP.
+//   4. Clocks every timer once: the inputs driven by the test, then the prescaler and
+//      the counter.
+// Interrupts go first, so the handlers see the flags exactly as a zero-latency ISR
+// would, and the wire keeps going while a level interrupt is still asserted (e.g. BTF
+// until the STOP requested on it goes out). A step is roughly one byte time on the
+// wire and one timer kernel clock; counts are comparable between runs, not cycle
+// exact.
+//
+// The I2Cv1 register semantics follow RM0368: DR write clears SB/TXE/BTF, reading
+// SR1 then SR2 clears ADDR, BTF means the clock is stretched, with POS the ACK bit
+// applies to the byte after the current one, LAST NACKs the byte of the final DMA
+// transfer. Slaves on the wire are SimSlave objects, and another master can address
+// the peripheral itself as a slave (HostI2c::masterTransfer()). Faults are injected
+// per peripheral: NACKs (by the slave), lost arbitration and bus errors.
+//
+// The timers follow RM0368 too (see HostTim): edge and center-aligned counting, the
+// preloads, one-pulse mode, update and compare/capture flags, the capture prescaler and
+// overcapture, PWM mode 1 outputs, and the update (DMAR burst) and capture DMA requests.
+// ============================================================================
+
+/*
+ *  @brief A device on the simulated bus. Return false from onAddress()/onWrite() to
+ *  NACK. The defaults ACK everything and read back 0xFF.
+ */
+class SimSlave
+{
+    public:
+        virtual ~SimSlave() = default;
+
+        virtual bool onAddress(bool read) { (void)read; return true; }
+        virtual bool onWrite(uint8_t byte) { (void)byte; return true; }
+        virtual uint8_t onRead() { return 0xFF; }
+        virtual void onStop() {}
+};
+
+/*
+ *  @brief The usual register-file sensor: the first byte written after the address sets
+ *  the register pointer, every byte moved after it auto-increments it.
+ */
+class RegisterSlave : public SimSlave
+{
+    public:
+        std::array<uint8_t, 256> registers = {};
+        uint8_t pointer = 0;
+        uint32_t transfers = 0;
+
+        bool onAddress(bool read) override;
+        bool onWrite(uint8_t byte) override;
+        uint8_t onRead() override;
+
+    protected:
+        bool pointerPending = false;
+};
+
+/*
+ *  @brief Wire and fault injection of one I2C peripheral.
+ */
+class HostI2c
+{
+    public:
+        static constexpr size_t MAX_SLAVES = 8;
+
+        static HostI2c& of(I2C_TypeDef* instance);
+
+        void attach(uint16_t address, SimSlave& slave);
+        void detachAll();
+
+        /*
+         *  @brief Another master wins the arbitration of the `byteIndex`-th byte this
+         *  peripheral sends from now on (0: the next one, address bytes included).
+         *  `otherTransfer` runs as that master's transfer, and its STOP frees the bus
+         *  `busyTicks` steps later.
+         */
+        void loseArbitration(uint32_t byteIndex, void (*otherTransfer)(void*) = nullptr,
+                             void* context = nullptr, uint32_t busyTicks = 4);
+
+        // Misplaced START/STOP on the bus: BERR right now.
+        void busError();
+
+        // Another master holds the bus (BUSY) for `ticks` steps.
+        void holdBusy(uint32_t ticks);
+
+        // Drops a pending loseArbitration() and releases a held bus.
+        void clearInjections();
+
+        uint32_t startConditions = 0;
+        uint32_t stopConditions = 0;
+        uint32_t bytesOnWire = 0;
+
+        // Model internals, used by the LL and DMA stand-ins.
+        I2C_TypeDef* registers = nullptr;
+
+        void resetWire();
+        bool tick();
+        bool eventPending() const;
+        bool errorPending() const;
+
+        void writeData(uint8_t data);
+        uint8_t readData();
+        void clearAddress();
+        void requestStart();
+        void requestStop();
+
+        bool wantsTxData() const;
+
+        /*
+         *  @brief Another master addresses this peripheral: writes `writeLength` bytes,
+         *  then, if `readLength`, reads that many after a repeated START (NACKing the last
+         *  one), and ends with a STOP. It starts once the bus is free; only one at a time.
+         */
+        void masterTransfer(uint16_t address, const uint8_t* write, size_t writeLength,
+                            uint8_t* read = nullptr, size_t readLength = 0);
+
+        // What the other master saw of its last masterTransfer().
+        struct MasterResult
+        {
+            bool done = false;
+            bool nacked = false;        // Address or a written byte NACKed
+            size_t written = 0;         // Bytes ACKed by the peripheral
+            size_t read = 0;
+        };
+
+        MasterResult masterResult;
+
+    protected:
+        enum class Phase
+        {
+            Idle,
+            Address,
+            Transmit,
+            Receive,
+            Nacked,
+            SlaveReceive,
+            SlaveTransmit,
+        };
+
+        // The other master of masterTransfer(), one wire stage at a time.
+        enum class External
+        {
+            None,
+            Start,
+            WriteAddress,
+            Write,
+            RepeatedStart,
+            ReadAddress,
+            Read,
+            ReadAcknowledge,
+            Stop,
+        };
+
+        struct Attached
+        {
+            uint16_t address;
+            SimSlave* slave;
+        };
+
+        std::array<Attached, MAX_SLAVES> slaves = {};
+        size_t slaveCount = 0;
+
+        Phase phase = Phase::Idle;
+        SimSlave* target = nullptr;
+
+        bool shifting = false;
+        bool shiftIsAddress = false;
+        uint8_t shiftByte = 0;
+        bool nextAck = true;
+
+        bool txFull = false;
+        bool rxHeld = false;
+        uint8_t rxHeldByte = 0;
+        bool nacked = false;
+        bool byteAfterEndRequest = false;
+
+        int32_t arbitrationCountdown = -1;
+        void (*otherTransfer)(void*) = nullptr;
+        void* otherContext = nullptr;
+        uint32_t otherBusyTicks = 0;
+        uint32_t otherMasterTicks = 0;
+
+        External external = External::None;
+        uint16_t externalAddress = 0;
+        const uint8_t* externalWrite = nullptr;
+        size_t externalWriteLength = 0;
+        uint8_t* externalRead = nullptr;
+        size_t externalReadLength = 0;
+
+        SimSlave* find(uint16_t address);
+        bool ownsAddress(uint16_t address) const;
+        bool tickExternal();
+        void externalStop();
+        void completeShift();
+        void lostArbitration();
+        bool endConditionAllowed() const;
+        void stop();
+        void repeatedStart();
+        bool lastDmaByte() const;
+};
+
+/*
+ *  @brief Counter, channels and DMA requests of one timer (TIM1-TIM5, TIM9-TIM11).
+ *
+ *  The counter advances every PSC + 1 steps. The shadow registers (PSC always, ARR with
+ *  ARPE, CCRx with OCxPE) are loaded on update events, and writing UG generates one,
+ *  resetting the prescaler and the counter (to ARR when counting down). URS keeps UG
+ *  from setting UIF, and COMG, TG and BG set their flags. In one-pulse mode the update
+ *  event clears CEN.
+ *
+ *  Channels in output mode (CCxS = 00) set CCxIF when the counter matches their active
+ *  CCRx, and output PWM mode 1 through CCxP/CCxNP (no dead-time). Channels in input mode
+ *  capture CNT on the edges of their input selected by CCxP/CCxNP, every 2^ICxPSC of
+ *  them, setting CCxIF, CCxOF when CCxIF was still set, and raising the channel DMA
+ *  request with CCxDE. Reading CCRx can't be trapped: the flag is taken as read by the
+ *  DMA transfer or the interrupt that serves it.
+ *
+ *  With UDE every update event raises the update DMA request, which writes DBL + 1 words
+ *  to DMAR, each redirected to the register DBA words in, and the following ones.
+ */
+class HostTim
+{
+    public:
+        static HostTim& of(TIM_TypeDef* instance);
+
+        // Input level of a channel (TIx); captures happen on its edges.
+        void setInput(uint8_t channel, bool high);
+
+        /*
+         *  @brief Drives the input of a channel with a square wave of `periodSteps` steps,
+         *  high for `highSteps` of them, starting with a rising edge at the next step.
+         *  A period of 0 stops it, leaving the input at its current level.
+         */
+        void driveInput(uint8_t channel, uint32_t periodSteps, uint32_t highSteps);
+
+        // Channel output pin level (CHx and CHxN), low while disabled.
+        bool output(uint8_t channel) const;
+        bool complementaryOutput(uint8_t channel) const;
+
+        uint32_t updateEvents = 0;
+        uint32_t captures = 0;
+
+        // Model internals, used by HostMcu and the DMA and EGR stand-ins.
+        TIM_TypeDef* registers = nullptr;
+        IRQn_Type irqs[4] = {};
+        uint32_t irqFlags[4] = {};
+        size_t irqCount = 0;
+        uint32_t maxCount = UINT16_MAX;
+
+        void reset();
+        void tick();
+        void generate(uint32_t events);
+        bool irqPending(IRQn_Type irq) const;
+        void interruptServed(IRQn_Type irq);
+
+        bool updateRequest() const;
+        bool captureRequest(uint8_t channel) const;
+        void writeBurst(uint32_t word);
+        uint32_t readCapture(uint8_t channel);
+
+    protected:
+        struct Input
+        {
+            bool level = false;
+            uint32_t period = 0;
+            uint32_t high = 0;
+            uint32_t phase = 0;
+            uint8_t edges = 0;
+        };
+
+        uint32_t prescalerCount = 0;
+        uint32_t activePrescaler = 0;
+        uint32_t activeReload = 0;
+        uint32_t activeCompare[4] = {};
+        bool countingDown = false;      // Center-aligned only, DIR is read-only there
+        bool updatePending = false;
+        bool capturePending[4] = {};
+        uint32_t burstIndex = 0;
+        Input inputs[4];
+
+        uint32_t reload() const;
+        uint32_t compare(uint8_t channel) const;
+        uint32_t channelMode(uint8_t channel) const;
+        uint32_t& compareRegister(uint8_t channel);
+        void update(bool generated);
+        void count();
+        void edge(uint8_t channel, bool rising);
+        bool reference(uint8_t channel) const;
+};
+
+/*
+ *  @brief The simulated MCU: steps the model and dispatches interrupts.
+ */
+class HostMcu
+{
+    public:
+        // Registers, wires, DMA streams and NVIC back to reset (slaves stay attached).
+        static void reset();
+
+        /*
+         *  @return false when nothing happened (no interrupt pending, no DMA request,
+         *  every wire idle or waiting on software).
+         */
+        static bool step();
+
+        /*
+         *  @brief Steps until nothing is left to do. Running timers don't count: step()
+         *  on to an alarm.
+         *
+         *  @return false if still busy after maxSteps (stuck bus or interrupt storm).
+         */
+        static bool run(uint32_t maxSteps = 100000);
+
+        /*
+         *  @brief Steps until `done()` holds, running timers included.
+         *
+         *  @return false if it still doesn't after maxSteps.
+         */
+        template <typename Condition>
+        static bool runUntil(Condition done, uint32_t maxSteps = 100000)
+        {
+            for(uint32_t i = 0; i < maxSteps && !done(); i++)
+                step();
+            return done();
+        }
+
+        static bool isIrqEnabled(IRQn_Type irq);
+
+        static uint32_t steps;
+        static uint32_t interrupts;
+};
+
+/*
+ *  @brief Vector table of the test executable (see host_vectors.cpp), so the model
+ *  doesn't depend on the driver libraries.
+ */
+struct HostVector
+{
+    IRQn_Type irq;
+    void (*handler)();
+};
+
+extern const HostVector hostVectors[];
+extern const size_t hostVectorCount;
+
+// DMA model, used by HostMcu::step().
+void hostDmaReset();
+void hostDmaApplyFlagClears();
+bool hostDmaService();
+bool hostDmaIrqPending(IRQn_Type& irq);
+bool hostDmaRxLastPending(I2C_TypeDef* i2c, bool rxneSet);
@@ -0,0 +1,682 @@
+#include "host_mcu.hpp"
+
+#include "stm32f4xx_ll_i2c.h"
+
+I2C_TypeDef hostI2c[3];
+
+namespace
+{
+    HostI2c models[3];
+}
+
+HostI2c& HostI2c::of(I2C_TypeDef* instance)
+{
+    HostI2c& model = models[instance - hostI2c];
+    model.registers = instance;
+    return model;
+}
+
+bool RegisterSlave::onAddress(bool read)
+{
+    pointerPending = !read;
+    transfers++;
+    return true;
+}
+
+bool RegisterSlave::onWrite(uint8_t byte)
+{
+    if(pointerPending)
+    {
+        pointer = byte;
+        pointerPending = false;
+    }
+    else
+    {
+        registers[pointer++] = byte;
+    }
+    return true;
+}
+
+uint8_t RegisterSlave::onRead()
+{
+    return registers[pointer++];
+}
+
+void HostI2c::attach(uint16_t address, SimSlave& slave)
+{
+    if(slaveCount < MAX_SLAVES)
+        slaves[slaveCount++] = { address, &slave };
+}
+
+void HostI2c::detachAll()
+{
+    slaveCount = 0;
+    target = nullptr;
+}
+
+void HostI2c::loseArbitration(uint32_t byteIndex, void (*transfer)(void*), void* context, uint32_t busyTicks)
+{
+    arbitrationCountdown = byteIndex;
+    otherTransfer = transfer;
+    otherContext = context;
+    otherBusyTicks = busyTicks;
+}
+
+void HostI2c::busError()
+{
+    registers->SR1 |= I2C_SR1_BERR;
+}
+
+void HostI2c::holdBusy(uint32_t ticks)
+{
+    otherMasterTicks = ticks;
+    registers->SR2 |= I2C_SR2_BUSY;
+}
+
+void HostI2c::clearInjections()
+{
+    if(otherMasterTicks && !(registers->SR2 & I2C_SR2_MSL))
+        registers->SR2 &= ~I2C_SR2_BUSY;
+
+    arbitrationCountdown = -1;
+    otherTransfer = nullptr;
+    otherMasterTicks = 0;
+    external = External::None;
+    masterResult = MasterResult();
+}
+
+void HostI2c::masterTransfer(uint16_t address, const uint8_t* write, size_t writeLength,
+                             uint8_t* read, size_t readLength)
+{
+    externalAddress = address;
+    externalWrite = write;
+    externalWriteLength = writeLength;
+    externalRead = read;
+    externalReadLength = readLength;
+    masterResult = MasterResult();
+    external = External::Start;
+}
+
+void HostI2c::resetWire()
+{
+    if(target)
+        target->onStop();
+
+    phase = Phase::Idle;
+    target = nullptr;
+    shifting = false;
+    txFull = false;
+    rxHeld = false;
+    nacked = false;
+    byteAfterEndRequest = false;
+    otherMasterTicks = 0;
+}
+
+SimSlave* HostI2c::find(uint16_t address)
+{
+    for(size_t i = 0; i < slaveCount; i++)
+    {
+        if(slaves[i].address == address)
+            return slaves[i].slave;
+    }
+    return nullptr;
+}
+
+bool HostI2c::ownsAddress(uint16_t address) const
+{
+    // 7 bit addressing only.
+    uint32_t oar1 = registers->OAR1;
+    if(address && !(oar1 & (1U << 15)) && ((oar1 >> 1) & 0x7F) == address)
+        return true;
+    if((registers->OAR2 & I2C_OAR2_ENDUAL) && ((registers->OAR2 >> 1) & 0x7F) == address)
+        return true;
+    return !address && (registers->CR1 & I2C_CR1_ENGC);
+}
+
+bool HostI2c::wantsTxData() const
+{
+    return (phase == Phase::Transmit || phase == Phase::SlaveTransmit) &&
+           !(registers->SR1 & I2C_SR1_ADDR) && (registers->SR1 & I2C_SR1_TXE);
+}
+
+bool HostI2c::eventPending() const
+{
+    uint32_t sr1 = registers->SR1;
+    uint32_t cr2 = registers->CR2;
+    if(!(cr2 & I2C_CR2_ITEVTEN))
+        return false;
+
+    if(sr1 & (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_STOPF | I2C_SR1_ADD10))
+        return true;
+
+    return (cr2 & I2C_CR2_ITBUFEN) && (sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE));
+}
+
+bool HostI2c::errorPending() const
+{
+    return (registers->CR2 & I2C_CR2_ITERREN) &&
+           (registers->SR1 & (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR));
+}
+
+void HostI2c::writeData(uint8_t data)
+{
+    registers->DR = data;
+
+    if(registers->SR1 & I2C_SR1_SB)
+    {
+        registers->SR1 &= ~I2C_SR1_SB;
+        shiftByte = data;
+        shiftIsAddress = true;
+        shifting = true;
+        phase = Phase::Address;
+        return;
+    }
+
+    registers->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+    txFull = true;
+}
+
+uint8_t HostI2c::readData()
+{
+    uint8_t data = registers->DR;
+    registers->SR1 &= ~(I2C_SR1_RXNE | I2C_SR1_BTF);
+
+    if(rxHeld)
+    {
+        registers->DR = rxHeldByte;
+        registers->SR1 |= I2C_SR1_RXNE;
+        rxHeld = false;
+    }
+    return data;
+}
+
+void HostI2c::clearAddress()
+{
+    if(!(registers->SR1 & I2C_SR1_ADDR))
+        return;
+
+    registers->SR1 &= ~I2C_SR1_ADDR;
+    if(phase == Phase::Transmit || phase == Phase::SlaveTransmit)
+        registers->SR1 |= I2C_SR1_TXE;
+}
+
+void HostI2c::requestStart()
+{
+    registers->CR1 |= I2C_CR1_START;
+    byteAfterEndRequest = false;
+}
+
+void HostI2c::requestStop()
+{
+    registers->CR1 |= I2C_CR1_STOP;
+    byteAfterEndRequest = false;
+}
+
+bool HostI2c::lastDmaByte() const
+{
+    uint32_t cr2 = registers->CR2;
+    if(!(cr2 & I2C_CR2_DMAEN) || !(cr2 & I2C_CR2_LAST))
+        return false;
+
+    return hostDmaRxLastPending(registers, registers->SR1 & I2C_SR1_RXNE);
+}
+
+bool HostI2c::endConditionAllowed() const
+{
+    switch(phase)
+    {
+        case Phase::Transmit:
+            return !txFull;
+        case Phase::Receive:
+            return !(registers->SR1 & I2C_SR1_ADDR) && (nacked || byteAfterEndRequest || rxHeld);
+        case Phase::Address:
+            return !(registers->SR1 & I2C_SR1_SB);
+        default:
+            return true;
+    }
+}
+
+void HostI2c::stop()
+{
+    registers->CR1 &= ~I2C_CR1_STOP;
+    registers->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF | I2C_SR1_SB | I2C_SR1_ADDR);
+    registers->SR2 &= ~(I2C_SR2_MSL | I2C_SR2_BUSY | I2C_SR2_TRA);
+    stopConditions++;
+
+    if(target)
+        target->onStop();
+
+    phase = Phase::Idle;
+    target = nullptr;
+    txFull = false;
+    rxHeld = false;
+    nacked = false;
+}
+
+void HostI2c::repeatedStart()
+{
+    registers->CR1 &= ~I2C_CR1_START;
+    registers->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+    registers->SR1 |= I2C_SR1_SB;
+    registers->SR2 &= ~I2C_SR2_TRA;
+    startConditions++;
+
+    phase = Phase::Address;
+    txFull = false;
+    rxHeld = false;
+    nacked = false;
+}
+
+void HostI2c::lostArbitration()
+{
+    arbitrationCountdown = -1;
+
+    registers->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF | I2C_SR1_SB | I2C_SR1_ADDR);
+    registers->SR1 |= I2C_SR1_ARLO;
+    // Back to slave mode; the bus stays BUSY until the other master's STOP.
+    registers->SR2 &= ~(I2C_SR2_MSL | I2C_SR2_TRA);
+    registers->CR1 &= ~(I2C_CR1_START | I2C_CR1_STOP);
+
+    phase = Phase::Idle;
+    target = nullptr;
+    txFull = false;
+    rxHeld = false;
+    nacked = false;
+
+    if(otherTransfer)
+        otherTransfer(otherContext);
+    otherMasterTicks = otherBusyTicks ? otherBusyTicks : 1;
+}
+
+void HostI2c::completeShift()
+{
+    shifting = false;
+    bytesOnWire++;
+
+    if(arbitrationCountdown >= 0 && arbitrationCountdown-- == 0)
+    {
+        lostArbitration();
+        return;
+    }
+
+    if(shiftIsAddress)
+    {
+        shiftIsAddress = false;
+        bool read = shiftByte & 1;
+        SimSlave* slave = find(shiftByte >> 1);
+
+        if(!slave || !slave->onAddress(read))
+        {
+            registers->SR1 |= I2C_SR1_AF;
+            phase = Phase::Nacked;
+            target = nullptr;
+            return;
+        }
+
+        target = slave;
+        registers->SR1 |= I2C_SR1_ADDR;
+        if(read)
+        {
+            registers->SR2 &= ~I2C_SR2_TRA;
+            phase = Phase::Receive;
+            nextAck = registers->CR1 & I2C_CR1_ACK;
+        }
+        else
+        {
+            registers->SR2 |= I2C_SR2_TRA;
+            phase = Phase::Transmit;
+        }
+        return;
+    }
+
+    if(phase == Phase::Transmit)
+    {
+        if(!target->onWrite(shiftByte))
+        {
+            registers->SR1 |= I2C_SR1_AF;
+            phase = Phase::Nacked;
+            return;
+        }
+        if(!txFull)
+            registers->SR1 |= I2C_SR1_BTF;
+        return;
+    }
+
+    // Receive. With POS, the ACK bit seen during a byte applies to the next one.
+    uint32_t cr1 = registers->CR1;
+    bool ack = (cr1 & I2C_CR1_POS) ? nextAck : (cr1 & I2C_CR1_ACK);
+    nextAck = cr1 & I2C_CR1_ACK;
+    if(lastDmaByte())
+        ack = false;
+
+    nacked = !ack;
+    if(cr1 & (I2C_CR1_STOP | I2C_CR1_START))
+        byteAfterEndRequest = true;
+
+    if(registers->SR1 & I2C_SR1_RXNE)
+    {
+        rxHeld = true;
+        rxHeldByte = shiftByte;
+        registers->SR1 |= I2C_SR1_BTF;
+    }
+    else
+    {
+        registers->DR = shiftByte;
+        registers->SR1 |= I2C_SR1_RXNE;
+    }
+}
+
+void HostI2c::externalStop()
+{
+    // No STOPF after a NACKed slave transmission (RM0368 I2C_SR1), nor when not addressed.
+    if(phase == Phase::SlaveReceive)
+        registers->SR1 |= I2C_SR1_STOPF;
+
+    registers->SR1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+    registers->SR2 &= ~(I2C_SR2_BUSY | I2C_SR2_TRA);
+    phase = Phase::Idle;
+    txFull = false;
+    external = External::None;
+    masterResult.done = true;
+}
+
+bool HostI2c::tickExternal()
+{
+    uint32_t sr1 = registers->SR1;
+
+    switch(external)
+    {
+        case External::Start:
+            registers->SR2 |= I2C_SR2_BUSY;
+            external = externalWriteLength ? External::WriteAddress : External::ReadAddress;
+            return true;
+
+        case External::WriteAddress:
+        case External::ReadAddress:
+        {
+            bytesOnWire++;
+            bool read = external == External::ReadAddress;
+            if(!ownsAddress(externalAddress) || !(registers->CR1 & I2C_CR1_ACK))
+            {
+                masterResult.nacked = true;
+                external = External::Stop;
+                return true;
+            }
+
+            registers->SR1 |= I2C_SR1_ADDR;
+            if(read)
+                registers->SR2 |= I2C_SR2_TRA;
+            else
+                registers->SR2 &= ~I2C_SR2_TRA;
+            phase = read ? Phase::SlaveTransmit : Phase::SlaveReceive;
+            external = read ? External::Read : External::Write;
+            return true;
+        }
+
+        case External::Write:
+        {
+            // Stretched while ADDR is set, and while DR and the shift register are full.
+            if((sr1 & I2C_SR1_ADDR) || rxHeld)
+                return false;
+
+            if(masterResult.written == externalWriteLength)
+            {
+                external = externalReadLength ? External::RepeatedStart : External::Stop;
+                return true;
+            }
+
+            uint8_t byte = externalWrite[masterResult.written];
+            bytesOnWire++;
+            if(sr1 & I2C_SR1_RXNE)
+            {
+                rxHeld = true;
+                rxHeldByte = byte;
+                registers->SR1 |= I2C_SR1_BTF;
+            }
+            else
+            {
+                registers->DR = byte;
+                registers->SR1 |= I2C_SR1_RXNE;
+            }
+
+            if(!(registers->CR1 & I2C_CR1_ACK))
+            {
+                masterResult.nacked = true;
+                external = External::Stop;
+                return true;
+            }
+            masterResult.written++;
+            return true;
+        }
+
+        case External::RepeatedStart:
+            if(rxHeld)
+                return false;
+            external = External::ReadAddress;
+            return true;
+
+        case External::Read:
+        {
+            if(sr1 & I2C_SR1_ADDR)
+                return false;
+
+            // Nothing in DR at the byte boundary: stretched with BTF.
+            if(!txFull)
+            {
+                registers->SR1 |= I2C_SR1_BTF;
+                return !(sr1 & I2C_SR1_BTF);
+            }
+
+            txFull = false;
+            registers->SR1 |= I2C_SR1_TXE;
+            externalRead[masterResult.read++] = static_cast<uint8_t>(registers->DR);
+            bytesOnWire++;
+            external = External::ReadAcknowledge;
+            return true;
+        }
+
+        case External::ReadAcknowledge:
+            // The last byte read is NACKed.
+            if(masterResult.read < externalReadLength)
+            {
+                external = External::Read;
+                return true;
+            }
+            registers->SR1 |= I2C_SR1_AF;
+            external = External::Stop;
+            return true;
+
+        case External::Stop:
+            if(rxHeld)
+                return false;
+            externalStop();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool HostI2c::tick()
+{
+    if(!(registers->CR1 & I2C_CR1_PE))
+        return false;
+
+    if(otherMasterTicks)
+    {
+        if(--otherMasterTicks == 0 && !(registers->SR2 & I2C_SR2_MSL))
+            registers->SR2 &= ~I2C_SR2_BUSY;
+        return true;
+    }
+
+    if(external != External::None && !(registers->SR2 & I2C_SR2_MSL))
+        return tickExternal();
+
+    if(!(registers->SR2 & I2C_SR2_MSL))
+    {
+        // A STOP request without the bus has nothing to end.
+        registers->CR1 &= ~I2C_CR1_STOP;
+
+        if(!(registers->CR1 & I2C_CR1_START) || (registers->SR2 & I2C_SR2_BUSY))
+            return false;
+
+        registers->CR1 &= ~I2C_CR1_START;
+        registers->SR1 |= I2C_SR1_SB;
+        registers->SR2 |= I2C_SR2_MSL | I2C_SR2_BUSY;
+        startConditions++;
+        phase = Phase::Address;
+        return true;
+    }
+
+    if(shifting)
+    {
+        completeShift();
+        return true;
+    }
+
+    if((registers->CR1 & I2C_CR1_STOP) && endConditionAllowed())
+    {
+        stop();
+        return true;
+    }
+
+    if((registers->CR1 & I2C_CR1_START) && endConditionAllowed() && phase != Phase::Address)
+    {
+        repeatedStart();
+        return true;
+    }
+
+    if(registers->SR1 & I2C_SR1_ADDR)
+        return false;
+
+    if(phase == Phase::Transmit && txFull)
+    {
+        shiftByte = registers->DR;
+        txFull = false;
+        registers->SR1 |= I2C_SR1_TXE;
+        shifting = true;
+        return true;
+    }
+
+    if(phase == Phase::Receive && !nacked && !rxHeld && !byteAfterEndRequest)
+    {
+        shiftByte = target->onRead();
+        shifting = true;
+        return true;
+    }
+
+    return false;
+}
+
+// ============================================================================
+// LL stand-ins
+// ============================================================================
+
+extern "C" {
+
+uint32_t hostI2cReadSR1(I2C_TypeDef* i2c)
+{
+    return i2c->SR1;
+}
+
+uint32_t hostI2cReadSR2(I2C_TypeDef* i2c)
+{
+    // SR1 is always read first by the driver: this is the ADDR clearing sequence.
+    uint32_t sr2 = i2c->SR2;
+    HostI2c::of(i2c).clearAddress();
+    return sr2;
+}
+
+ErrorStatus LL_I2C_Init(I2C_TypeDef* i2c, LL_I2C_InitTypeDef* init)
+{
+    if(!init->ClockSpeed || init->ClockSpeed > 400000)
+        return ERROR;
+
+    i2c->CR1 |= I2C_CR1_PE;
+    i2c->OAR1 = init->OwnAddress1 | init->OwnAddrSize;
+    i2c->CCR = init->DutyCycle;
+    if(init->TypeAcknowledge)
+        i2c->CR1 |= I2C_CR1_ACK;
+    return SUCCESS;
+}
+
+ErrorStatus LL_I2C_DeInit(I2C_TypeDef* i2c)
+{
+    // RCC reset of the peripheral: registers and wire state back to reset.
+    HostI2c::of(i2c).resetWire();
+    *i2c = I2C_TypeDef{};
+    return SUCCESS;
+}
+
+void LL_I2C_StructInit(LL_I2C_InitTypeDef* init)
+{
+    *init = LL_I2C_InitTypeDef{};
+    init->ClockSpeed = 5000;
+    init->OwnAddrSize = LL_I2C_OWNADDRESS1_7BIT;
+}
+
+void LL_I2C_Enable(I2C_TypeDef* i2c)                 { i2c->CR1 |= I2C_CR1_PE; }
+void LL_I2C_Disable(I2C_TypeDef* i2c)                { i2c->CR1 &= ~I2C_CR1_PE; }
+
+void LL_I2C_SetOwnAddress2(I2C_TypeDef* i2c, uint32_t ownAddress2)
+{
+    i2c->OAR2 = (i2c->OAR2 & I2C_OAR2_ENDUAL) | (ownAddress2 << 1);
+}
+void LL_I2C_EnableOwnAddress2(I2C_TypeDef* i2c)      { i2c->OAR2 |= I2C_OAR2_ENDUAL; }
+void LL_I2C_DisableOwnAddress2(I2C_TypeDef* i2c)     { i2c->OAR2 &= ~I2C_OAR2_ENDUAL; }
+void LL_I2C_EnableClockStretching(I2C_TypeDef* i2c)  { i2c->CR1 &= ~(1U << 7); }
+void LL_I2C_DisableClockStretching(I2C_TypeDef* i2c) { i2c->CR1 |= 1U << 7; }
+void LL_I2C_EnableGeneralCall(I2C_TypeDef* i2c)      { i2c->CR1 |= 1U << 6; }
+void LL_I2C_DisableGeneralCall(I2C_TypeDef* i2c)     { i2c->CR1 &= ~(1U << 6); }
+
+void LL_I2C_EnableIT_EVT(I2C_TypeDef* i2c)           { i2c->CR2 |= I2C_CR2_ITEVTEN; }
+void LL_I2C_EnableIT_ERR(I2C_TypeDef* i2c)           { i2c->CR2 |= I2C_CR2_ITERREN; }
+void LL_I2C_EnableIT_BUF(I2C_TypeDef* i2c)           { i2c->CR2 |= I2C_CR2_ITBUFEN; }
+void LL_I2C_DisableIT_BUF(I2C_TypeDef* i2c)          { i2c->CR2 &= ~I2C_CR2_ITBUFEN; }
+
+void LL_I2C_EnableDMAReq_TX(I2C_TypeDef* i2c)        { i2c->CR2 |= I2C_CR2_DMAEN; }
+void LL_I2C_DisableDMAReq_TX(I2C_TypeDef* i2c)       { i2c->CR2 &= ~I2C_CR2_DMAEN; }
+void LL_I2C_EnableDMAReq_RX(I2C_TypeDef* i2c)        { i2c->CR2 |= I2C_CR2_DMAEN; }
+void LL_I2C_DisableDMAReq_RX(I2C_TypeDef* i2c)       { i2c->CR2 &= ~I2C_CR2_DMAEN; }
+void LL_I2C_EnableLastDMA(I2C_TypeDef* i2c)          { i2c->CR2 |= I2C_CR2_LAST; }
+void LL_I2C_DisableLastDMA(I2C_TypeDef* i2c)         { i2c->CR2 &= ~I2C_CR2_LAST; }
+
+uintptr_t LL_I2C_DMA_GetRegAddr(I2C_TypeDef* i2c)
+{
+    return reinterpret_cast<uintptr_t>(&i2c->DR);
+}
+
+void LL_I2C_GenerateStartCondition(I2C_TypeDef* i2c) { HostI2c::of(i2c).requestStart(); }
+void LL_I2C_GenerateStopCondition(I2C_TypeDef* i2c)  { HostI2c::of(i2c).requestStop(); }
+
+void LL_I2C_AcknowledgeNextData(I2C_TypeDef* i2c, uint32_t type)
+{
+    i2c->CR1 = (i2c->CR1 & ~I2C_CR1_ACK) | type;
+}
+
+void LL_I2C_EnableBitPOS(I2C_TypeDef* i2c)           { i2c->CR1 |= I2C_CR1_POS; }
+void LL_I2C_DisableBitPOS(I2C_TypeDef* i2c)          { i2c->CR1 &= ~I2C_CR1_POS; }
+
+uint32_t LL_I2C_IsActiveFlag_SB(I2C_TypeDef* i2c)    { return (i2c->SR1 & I2C_SR1_SB) != 0; }
+uint32_t LL_I2C_IsActiveFlag_ADDR(I2C_TypeDef* i2c)  { return (i2c->SR1 & I2C_SR1_ADDR) != 0; }
+uint32_t LL_I2C_IsActiveFlag_BTF(I2C_TypeDef* i2c)   { return (i2c->SR1 & I2C_SR1_BTF) != 0; }
+uint32_t LL_I2C_IsActiveFlag_STOP(I2C_TypeDef* i2c)  { return (i2c->SR1 & I2C_SR1_STOPF) != 0; }
+uint32_t LL_I2C_IsActiveFlag_RXNE(I2C_TypeDef* i2c)  { return (i2c->SR1 & I2C_SR1_RXNE) != 0; }
+uint32_t LL_I2C_IsActiveFlag_TXE(I2C_TypeDef* i2c)   { return (i2c->SR1 & I2C_SR1_TXE) != 0; }
+uint32_t LL_I2C_IsActiveFlag_BERR(I2C_TypeDef* i2c)  { return (i2c->SR1 & I2C_SR1_BERR) != 0; }
+uint32_t LL_I2C_IsActiveFlag_ARLO(I2C_TypeDef* i2c)  { return (i2c->SR1 & I2C_SR1_ARLO) != 0; }
+uint32_t LL_I2C_IsActiveFlag_AF(I2C_TypeDef* i2c)    { return (i2c->SR1 & I2C_SR1_AF) != 0; }
+uint32_t LL_I2C_IsActiveFlag_OVR(I2C_TypeDef* i2c)   { return (i2c->SR1 & I2C_SR1_OVR) != 0; }
+uint32_t LL_I2C_IsActiveFlag_BUSY(I2C_TypeDef* i2c)  { return (i2c->SR2 & I2C_SR2_BUSY) != 0; }
+
+void LL_I2C_ClearFlag_ADDR(I2C_TypeDef* i2c)         { HostI2c::of(i2c).clearAddress(); }
+void LL_I2C_ClearFlag_STOP(I2C_TypeDef* i2c)         { i2c->SR1 &= ~I2C_SR1_STOPF; }
+void LL_I2C_ClearFlag_BERR(I2C_TypeDef* i2c)         { i2c->SR1 &= ~I2C_SR1_BERR; }
+void LL_I2C_ClearFlag_ARLO(I2C_TypeDef* i2c)         { i2c->SR1 &= ~I2C_SR1_ARLO; }
+void LL_I2C_ClearFlag_AF(I2C_TypeDef* i2c)           { i2c->SR1 &= ~I2C_SR1_AF; }
+void LL_I2C_ClearFlag_OVR(I2C_TypeDef* i2c)          { i2c->SR1 &= ~I2C_SR1_OVR; }
+
+void LL_I2C_TransmitData8(I2C_TypeDef* i2c, uint8_t data) { HostI2c::of(i2c).writeData(data); }
+uint8_t LL_I2C_ReceiveData8(I2C_TypeDef* i2c)              { return HostI2c::of(i2c).readData(); }
+
+}
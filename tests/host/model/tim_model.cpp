@@ -0,0 +1,437 @@
+#include "host_mcu.hpp"
+
+#include <stddef.h>
+
+TIM_TypeDef hostTim[8];
+
+// ============================================================================
+// TIM1-TIM5 and TIM9-TIM11 (RM0368 sections 12-14). The interrupt lines a timer raises
+// and the SR flags behind each one follow the vector table (RM0368 table 38): TIM1
+// spreads its sources over four vectors, three of them shared with TIM9-TIM11.
+// ============================================================================
+
+namespace
+{
+    HostTim models[8];
+
+    constexpr uint32_t ALL_SOURCES = 0xFF;
+    constexpr uint32_t CAPTURE_COMPARE = TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF;
+
+    struct TimLine
+    {
+        IRQn_Type irq;
+        uint32_t flags;
+    };
+
+    struct TimConfig
+    {
+        uint32_t maxCount;
+        TimLine lines[4];
+        size_t lineCount;
+    };
+
+    const TimConfig configs[8] =
+    {
+        { UINT16_MAX, { { TIM1_UP_TIM10_IRQn, TIM_SR_UIF }, { TIM1_CC_IRQn, CAPTURE_COMPARE },
+                        { TIM1_BRK_TIM9_IRQn, TIM_SR_BIF },
+                        { TIM1_TRG_COM_TIM11_IRQn, TIM_SR_TIF | TIM_SR_COMIF } }, 4 },
+        { UINT32_MAX, { { TIM2_IRQn, ALL_SOURCES } }, 1 },
+        { UINT16_MAX, { { TIM3_IRQn, ALL_SOURCES } }, 1 },
+        { UINT16_MAX, { { TIM4_IRQn, ALL_SOURCES } }, 1 },
+        { UINT32_MAX, { { TIM5_IRQn, ALL_SOURCES } }, 1 },
+        { UINT16_MAX, { { TIM1_BRK_TIM9_IRQn, ALL_SOURCES } }, 1 },
+        { UINT16_MAX, { { TIM1_UP_TIM10_IRQn, ALL_SOURCES } }, 1 },
+        { UINT16_MAX, { { TIM1_TRG_COM_TIM11_IRQn, ALL_SOURCES } }, 1 },
+    };
+
+    constexpr uint32_t SR_INDEX = offsetof(TIM_TypeDef, SR) / sizeof(uint32_t);
+    constexpr uint32_t EGR_INDEX = offsetof(TIM_TypeDef, EGR) / sizeof(uint32_t);
+    constexpr uint32_t REGISTER_COUNT = sizeof(TIM_TypeDef) / sizeof(uint32_t);
+
+    constexpr uint32_t OCM_PWM_1 = 6;
+    constexpr uint32_t OCM_PWM_2 = 7;
+    constexpr uint32_t OCM_FORCED_INACTIVE = 4;
+    constexpr uint32_t OCM_FORCED_ACTIVE = 5;
+}
+
+HostTim& HostTim::of(TIM_TypeDef* instance)
+{
+    size_t index = instance - hostTim;
+    HostTim& model = models[index];
+    if(!model.registers)
+    {
+        const TimConfig& config = configs[index];
+        model.registers = instance;
+        model.maxCount = config.maxCount;
+        model.irqCount = config.lineCount;
+        for(size_t i = 0; i < config.lineCount; i++)
+        {
+            model.irqs[i] = config.lines[i].irq;
+            model.irqFlags[i] = config.lines[i].flags;
+        }
+    }
+    return model;
+}
+
+void HostTim::reset()
+{
+    *registers = TIM_TypeDef{};
+
+    prescalerCount = 0;
+    activePrescaler = 0;
+    activeReload = 0;
+    for(uint32_t& compare : activeCompare)
+        compare = 0;
+    countingDown = false;
+    updatePending = false;
+    for(bool& pending : capturePending)
+        pending = false;
+    burstIndex = 0;
+    for(Input& input : inputs)
+        input = Input();
+
+    updateEvents = 0;
+    captures = 0;
+}
+
+void HostTim::setInput(uint8_t channel, bool high)
+{
+    Input& input = inputs[channel];
+    if(input.level == high)
+        return;
+
+    input.level = high;
+    edge(channel, high);
+}
+
+void HostTim::driveInput(uint8_t channel, uint32_t periodSteps, uint32_t highSteps)
+{
+    Input& input = inputs[channel];
+    input.period = periodSteps;
+    input.high = highSteps;
+    input.phase = 0;
+}
+
+uint32_t HostTim::channelMode(uint8_t channel) const
+{
+    uint32_t ccmr = channel < 2 ? registers->CCMR1 : registers->CCMR2;
+    return (ccmr >> (8 * (channel % 2))) & 0xFF;
+}
+
+uint32_t& HostTim::compareRegister(uint8_t channel)
+{
+    return (&registers->CCR1)[channel];
+}
+
+uint32_t HostTim::reload() const
+{
+    return registers->CR1 & TIM_CR1_ARPE ? activeReload : registers->ARR;
+}
+
+uint32_t HostTim::compare(uint8_t channel) const
+{
+    if(channelMode(channel) & TIM_CCMR1_OC1PE)
+        return activeCompare[channel];
+    return (&registers->CCR1)[channel];
+}
+
+bool HostTim::reference(uint8_t channel) const
+{
+    uint32_t mode = channelMode(channel);
+    if(mode & TIM_CCMR1_CC1S)
+        return false;
+
+    // PWM mode 1 is active below the compare value, counting up; down it's active up to
+    // the compare value included. PWM mode 2 is the opposite.
+    uint32_t count = registers->CNT;
+    uint32_t value = compare(channel);
+    bool down = (registers->CR1 & TIM_CR1_CMS) ? countingDown : (registers->CR1 & TIM_CR1_DIR);
+    bool below = down ? count <= value : count < value;
+
+    switch((mode & TIM_CCMR1_OC1M) >> TIM_CCMR1_OC1M_Pos)
+    {
+        case OCM_PWM_1:           return below;
+        case OCM_PWM_2:           return !below;
+        case OCM_FORCED_ACTIVE:   return true;
+        case OCM_FORCED_INACTIVE: return false;
+        default:                  return false;
+    }
+}
+
+bool HostTim::output(uint8_t channel) const
+{
+    uint32_t ccer = registers->CCER >> (4 * channel);
+    if(!(ccer & TIM_CCER_CC1E))
+        return false;
+    if(registers == TIM1 && !(registers->BDTR & TIM_BDTR_MOE))
+        return false;
+
+    return reference(channel) != static_cast<bool>(ccer & TIM_CCER_CC1P);
+}
+
+bool HostTim::complementaryOutput(uint8_t channel) const
+{
+    uint32_t ccer = registers->CCER >> (4 * channel);
+    if(!(ccer & TIM_CCER_CC1NE) || !(registers->BDTR & TIM_BDTR_MOE))
+        return false;
+
+    return !reference(channel) != static_cast<bool>(ccer & TIM_CCER_CC1NP);
+}
+
+void HostTim::edge(uint8_t channel, bool rising)
+{
+    Input& input = inputs[channel];
+    uint32_t ccer = registers->CCER >> (4 * channel);
+
+    // The capture prescaler restarts while the channel is disabled.
+    if((channelMode(channel) & TIM_CCMR1_CC1S) != 1 || !(ccer & TIM_CCER_CC1E))
+    {
+        input.edges = 0;
+        return;
+    }
+
+    // CCxNP:CCxP = 00 rising, 01 falling, 11 both edges.
+    bool falling = ccer & TIM_CCER_CC1P;
+    bool both = falling && (ccer & TIM_CCER_CC1NP);
+    if(!both && rising == falling)
+        return;
+
+    uint32_t prescaler = (channelMode(channel) & TIM_CCMR1_IC1PSC) >> TIM_CCMR1_IC1PSC_Pos;
+    if(++input.edges < (1U << prescaler))
+        return;
+    input.edges = 0;
+
+    compareRegister(channel) = registers->CNT;
+    captures++;
+
+    uint32_t flag = TIM_SR_CC1IF << channel;
+    if(registers->SR.value & flag)
+        registers->SR.value |= TIM_SR_CC1OF << channel;
+    registers->SR.value |= flag;
+
+    if(registers->DIER & (TIM_DIER_CC1DE << channel))
+        capturePending[channel] = true;
+}
+
+void HostTim::update(bool generated)
+{
+    activePrescaler = registers->PSC;
+    activeReload = registers->ARR;
+    for(uint8_t channel = 0; channel < 4; channel++)
+        activeCompare[channel] = (&registers->CCR1)[channel];
+
+    if(generated)
+    {
+        prescalerCount = 0;
+        countingDown = false;
+        bool down = (registers->CR1 & TIM_CR1_DIR) && !(registers->CR1 & TIM_CR1_CMS);
+        registers->CNT = down ? registers->ARR : 0;
+    }
+
+    updateEvents++;
+    if(generated && (registers->CR1 & TIM_CR1_URS))
+        return;
+
+    registers->SR.value |= TIM_SR_UIF;
+    if(registers->DIER & TIM_DIER_UDE)
+        updatePending = true;
+
+    if(!generated && (registers->CR1 & TIM_CR1_OPM))
+        registers->CR1 &= ~TIM_CR1_CEN;
+}
+
+void HostTim::count()
+{
+    uint32_t top = reload();
+    uint32_t cr1 = registers->CR1;
+    uint32_t& counter = registers->CNT;
+
+    if(cr1 & TIM_CR1_CMS)
+    {
+        // Up to ARR and back down to 0, an update event at both ends.
+        if(!countingDown)
+        {
+            counter++;
+            if(counter >= top)
+            {
+                counter = top;
+                countingDown = true;
+                update(false);
+            }
+        }
+        else
+        {
+            if(counter)
+                counter--;
+            if(!counter)
+            {
+                countingDown = false;
+                update(false);
+            }
+        }
+    }
+    else if(cr1 & TIM_CR1_DIR)
+    {
+        if(counter == 0)
+        {
+            counter = top;
+            update(false);
+        }
+        else
+        {
+            counter--;
+        }
+    }
+    else
+    {
+        // Above ARR (lowered without preload) it runs to the end of its range first.
+        if(counter == top)
+        {
+            counter = 0;
+            update(false);
+        }
+        else
+        {
+            counter = (counter + 1) & maxCount;
+        }
+    }
+
+    for(uint8_t channel = 0; channel < 4; channel++)
+    {
+        if(!(channelMode(channel) & TIM_CCMR1_CC1S) && counter == compare(channel))
+            registers->SR.value |= TIM_SR_CC1IF << channel;
+    }
+}
+
+void HostTim::tick()
+{
+    // Clearing a DMA enable drops the request it was holding.
+    if(!(registers->DIER & TIM_DIER_UDE))
+        updatePending = false;
+    for(uint8_t channel = 0; channel < 4; channel++)
+    {
+        if(!(registers->DIER & (TIM_DIER_CC1DE << channel)))
+            capturePending[channel] = false;
+    }
+
+    for(uint8_t channel = 0; channel < 4; channel++)
+    {
+        Input& input = inputs[channel];
+        if(!input.period)
+            continue;
+
+        if(input.phase == 0 && input.high)
+            setInput(channel, true);
+        else if(input.phase == input.high)
+            setInput(channel, false);
+        input.phase = (input.phase + 1) % input.period;
+    }
+
+    if(!(registers->CR1 & TIM_CR1_CEN))
+        return;
+
+    if(prescalerCount < activePrescaler)
+    {
+        prescalerCount++;
+        return;
+    }
+    prescalerCount = 0;
+    count();
+}
+
+void HostTim::generate(uint32_t events)
+{
+    if(events & TIM_EGR_UG)
+        update(true);
+
+    // CCxG: a compare match, or a capture of the counter in input mode.
+    for(uint8_t channel = 0; channel < 4; channel++)
+    {
+        if(!(events & (TIM_SR_CC1IF << channel)))
+            continue;
+
+        if((channelMode(channel) & TIM_CCMR1_CC1S) == 1)
+            compareRegister(channel) = registers->CNT;
+        registers->SR.value |= TIM_SR_CC1IF << channel;
+    }
+
+    // COMG, TG and BG only set their flags: nothing in the model reacts to them.
+    registers->SR.value |= events & (TIM_SR_COMIF | TIM_SR_TIF | TIM_SR_BIF);
+}
+
+bool HostTim::irqPending(IRQn_Type irq) const
+{
+    uint32_t pending = registers->SR.value & registers->DIER & ALL_SOURCES;
+    for(size_t i = 0; i < irqCount; i++)
+    {
+        if(irqs[i] == irq && (pending & irqFlags[i]))
+            return true;
+    }
+    return false;
+}
+
+void HostTim::interruptServed(IRQn_Type irq)
+{
+    for(size_t i = 0; i < irqCount; i++)
+    {
+        if(irqs[i] != irq)
+            continue;
+
+        // The capture interrupt reads CCRx, which clears CCxIF.
+        for(uint8_t channel = 0; channel < 4; channel++)
+        {
+            uint32_t flag = TIM_SR_CC1IF << channel;
+            if((irqFlags[i] & flag) && (registers->DIER & flag) &&
+               (channelMode(channel) & TIM_CCMR1_CC1S) == 1)
+                registers->SR.value &= ~flag;
+        }
+    }
+}
+
+bool HostTim::updateRequest() const
+{
+    return updatePending && (registers->DIER & TIM_DIER_UDE);
+}
+
+bool HostTim::captureRequest(uint8_t channel) const
+{
+    return capturePending[channel] && (registers->DIER & (TIM_DIER_CC1DE << channel));
+}
+
+void HostTim::writeBurst(uint32_t word)
+{
+    uint32_t base = registers->DCR & TIM_DCR_DBA;
+    uint32_t length = ((registers->DCR & TIM_DCR_DBL) >> TIM_DCR_DBL_Pos) + 1;
+    uint32_t index = base + burstIndex;
+
+    if(index == SR_INDEX)
+        registers->SR = word;
+    else if(index == EGR_INDEX)
+        registers->EGR = word;
+    else if(index < REGISTER_COUNT)
+        reinterpret_cast<uint32_t*>(registers)[index] = word;
+
+    if(++burstIndex < length)
+        return;
+
+    burstIndex = 0;
+    updatePending = false;
+}
+
+uint32_t HostTim::readCapture(uint8_t channel)
+{
+    capturePending[channel] = false;
+    registers->SR.value &= ~(TIM_SR_CC1IF << channel);
+    return compareRegister(channel);
+}
+
+// ============================================================================
+// Register stand-ins
+// ============================================================================
+
+HostTimEvents& HostTimEvents::operator=(uint32_t events)
+{
+    char* base = reinterpret_cast<char*>(this) - offsetof(TIM_TypeDef, EGR);
+    HostTim::of(reinterpret_cast<TIM_TypeDef*>(base)).generate(events);
+    return *this;
+}
@@ -0,0 +1,347 @@
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "dma_streams.hpp"
+#include "input_capture.hpp"
+#include "pwm_channel.hpp"
+
+#include "stm32f4xx_ll_dma.h"
+
+// ============================================================================
+// PwmChannel on the timer model, one tick per step (PSC = 0): the output pins are sampled
+// every step, and each PWM period must be active for exactly its compare value (twice it
+// center-aligned), duty and period changes only taking effect at the next update event.
+// ============================================================================
+
+namespace
+{
+    // Every encoding is the shortest one covering its ticks (DTG, RM0368 17.4.18).
+    constexpr uint32_t deadTimeTicks(uint8_t dtg)
+    {
+        if(!(dtg & 0x80))
+            return dtg;
+        if((dtg & 0xC0) == 0x80)
+            return (64 + (dtg & 0x3F)) * 2;
+        if((dtg & 0xE0) == 0xC0)
+            return (32 + (dtg & 0x1F)) * 8;
+        return (32 + (dtg & 0x1F)) * 16;
+    }
+
+    // The encodings grow with their value: the shortest covering one is right after the
+    // last one falling short.
+    constexpr bool deadTimeCovers()
+    {
+        for(uint32_t ticks = 0; ticks <= 1008; ticks++)
+        {
+            int16_t dtg = PwmChannel::deadTimeGenerator(ticks);
+            if(dtg < 0 || deadTimeTicks(dtg) < ticks || (dtg > 0 && deadTimeTicks(dtg - 1) >= ticks))
+                return false;
+        }
+        return PwmChannel::deadTimeGenerator(1009) == -1;
+    }
+
+    static_assert(deadTimeCovers());
+    static_assert(PwmChannel::deadTimeGenerator(127) == 127 && PwmChannel::deadTimeGenerator(128) == 0x80);
+    static_assert(PwmChannel::deadTimeGenerator(254) == 0xBF && PwmChannel::deadTimeGenerator(255) == 0xC0);
+    static_assert(PwmChannel::deadTimeGenerator(504) == 0xDF && PwmChannel::deadTimeGenerator(1008) == 0xFF);
+
+    // Active steps of the outputs over one update period.
+    struct Period
+    {
+        uint32_t active[4];
+        uint32_t complementary[4];
+    };
+
+    struct PwmFixture
+    {
+        ScopedTimer timer;
+        HostTim& model;
+
+        PwmFixture(TimerSelection selection, TIM_TypeDef* registers) : model(HostTim::of(registers))
+        {
+            HostMcu::reset();
+            (void)Timer::Builder().timerSelection(selection).buildIn(timer);
+        }
+
+        // The next `count` update periods, from the next update event.
+        void sample(Period* periods, size_t count)
+        {
+            uint32_t events = model.updateEvents;
+            HostMcu::runUntil([&] { return model.updateEvents != events; });
+
+            uint32_t first = model.updateEvents;
+            for(size_t i = 0; i < count; i++)
+                periods[i] = Period();
+
+            // The outputs as they are after each step, the update one first.
+            for(size_t index = 0; index < count; index = model.updateEvents - first)
+            {
+                for(uint8_t channel = 0; channel < 4; channel++)
+                {
+                    periods[index].active[channel] += model.output(channel);
+                    periods[index].complementary[channel] += model.complementaryOutput(channel);
+                }
+                HostMcu::step();
+            }
+        }
+    };
+
+    PwmChannel::Config pwm(PwmChannel::Channel channel, uint32_t period, uint32_t duty)
+    {
+        PwmChannel::Config config;
+        config.channel = channel;
+        config.period = period;
+        config.duty = duty;
+        return config;
+    }
+
+    bool testEdgeAligned()
+    {
+        PwmFixture fixture(TIMER_3, TIM3);
+        PwmChannel first(fixture.timer, pwm(PwmChannel::Channel::Ch1, 99, 25));
+        PwmChannel second(fixture.timer, pwm(PwmChannel::Channel::Ch2, 0, 70));
+        first.start();
+        second.start();
+        CHECK(second.getPeriod() == 99);
+
+        Period periods[4];
+        fixture.sample(periods, 4);
+        for(const Period& period : periods)
+            CHECK(period.active[0] == 25 && period.active[1] == 70);
+
+        // Preloaded: written mid-period, the new duty waits for the update event.
+        HostMcu::runUntil([] { return false; }, 30);
+        first.setDutyPermille(400);
+        CHECK(first.getDuty() == 40);
+        uint32_t events = fixture.model.updateEvents;
+        uint32_t rest = 0;
+        while(fixture.model.updateEvents == events)
+        {
+            rest += fixture.model.output(0);
+            HostMcu::step();
+        }
+        CHECK(rest == 0);
+        fixture.sample(periods, 2);
+        CHECK(periods[0].active[0] == 40 && periods[1].active[0] == 40);
+
+        // So is the period, shared by both channels.
+        first.setPeriod(199);
+        first.setDutyPermille(1000);
+        fixture.sample(periods, 3);
+        CHECK(periods[1].active[0] == 200 && periods[2].active[0] == 200);
+        CHECK(periods[1].active[1] == 70 && periods[2].active[1] == 70);
+
+        first.stop();
+        fixture.sample(periods, 2);
+        CHECK(periods[0].active[0] == 0 && periods[1].active[0] == 0);
+        CHECK(periods[0].active[1] == 70 && periods[1].active[1] == 70);
+        return true;
+    }
+
+    bool testActiveLow()
+    {
+        PwmFixture fixture(TIMER_4, TIM4);
+        PwmChannel::Config config = pwm(PwmChannel::Channel::Ch4, 49, 10);
+        config.activeLow = true;
+        PwmChannel channel(fixture.timer, config);
+        channel.start();
+
+        Period periods[3];
+        fixture.sample(periods, 3);
+        for(const Period& period : periods)
+            CHECK(period.active[3] == 50 - 10);
+        return true;
+    }
+
+    bool testCenterAligned()
+    {
+        PwmFixture fixture(TIMER_2, TIM2);
+        PwmChannel::Config config = pwm(PwmChannel::Channel::Ch3, 50, 15);
+        config.alignment = PwmChannel::Alignment::Center;
+        PwmChannel channel(fixture.timer, config);
+        channel.start();
+
+        // An update event at both ends: up then down, 2 * CCR of 2 * ARR.
+        Period periods[6];
+        fixture.sample(periods, 6);
+        for(size_t i = 0; i < 6; i += 2)
+            CHECK(periods[i].active[2] + periods[i + 1].active[2] == 2 * 15);
+
+        channel.setDutyPermille(500);
+        CHECK(channel.getDuty() == 25);
+        fixture.sample(periods, 6);
+        for(size_t i = 2; i < 6; i += 2)
+            CHECK(periods[i].active[2] + periods[i + 1].active[2] == 50);
+
+        // The counter mode can't change under a running timer.
+        CHECK(hostFails([&]
+        {
+            PwmChannel other;
+            return other.init(fixture.timer, pwm(PwmChannel::Channel::Ch1, 0, 0));
+        }, DriverError::InUse));
+        return true;
+    }
+
+    bool testComplementary()
+    {
+        PwmFixture fixture(TIMER_1, TIM1);
+        PwmChannel::Config config = pwm(PwmChannel::Channel::Ch2, 99, 30);
+        config.complementary = true;
+        config.deadTime = 300;
+        PwmChannel channel(fixture.timer, config);
+
+        CHECK((TIM1->BDTR & TIM_BDTR_DTG) == static_cast<uint32_t>(PwmChannel::deadTimeGenerator(300)));
+        CHECK(!fixture.model.output(1) && !fixture.model.complementaryOutput(1));
+
+        // MOE set by start(). The model has no dead-time: the outputs are exact opposites.
+        channel.start();
+        CHECK(TIM1->BDTR & TIM_BDTR_MOE);
+        Period periods[3];
+        fixture.sample(periods, 3);
+        for(const Period& period : periods)
+            CHECK(period.active[1] == 30 && period.complementary[1] == 100 - 30);
+
+        bool opposite = true;
+        for(int i = 0; i < 300; i++)
+        {
+            HostMcu::step();
+            opposite &= fixture.model.output(1) != fixture.model.complementaryOutput(1);
+        }
+        CHECK(opposite);
+
+        channel.stop();
+        CHECK(!fixture.model.output(1) && !fixture.model.complementaryOutput(1));
+        return true;
+    }
+
+    bool testInvalidConfig()
+    {
+        PwmFixture fixture(TIMER_3, TIM3);
+        PwmChannel channel;
+
+        PwmChannel::Config complementary = pwm(PwmChannel::Channel::Ch1, 99, 0);
+        complementary.complementary = true;
+        CHECK(hostFails([&] { return channel.init(fixture.timer, complementary); }, DriverError::InvalidConfig));
+
+        // A channel capturing can't output too.
+        uint32_t buffer[4];
+        InputCapture::Config captureConfig;
+        captureConfig.buffer = buffer;
+        captureConfig.length = 4;
+        InputCapture capture;
+        CHECK(hostSucceeds([&] { return capture.init(fixture.timer, captureConfig); }));
+        CHECK(hostFails([&] { return channel.init(fixture.timer, pwm(PwmChannel::Channel::Ch1, 99, 0)); },
+                        DriverError::InUse));
+
+        // TIM10: one channel, edge-aligned only.
+        ScopedTimer single;
+        (void)Timer::Builder().timerSelection(TIMER_10).buildIn(single);
+        CHECK(hostFails([&] { return channel.init(single, pwm(PwmChannel::Channel::Ch2, 99, 0)); },
+                        DriverError::InvalidConfig));
+        PwmChannel::Config center = pwm(PwmChannel::Channel::Ch1, 99, 0);
+        center.alignment = PwmChannel::Alignment::Center;
+        CHECK(hostFails([&] { return channel.init(single, center); }, DriverError::InvalidConfig));
+
+        // Past the longest dead-time.
+        ScopedTimer advanced;
+        (void)Timer::Builder().timerSelection(TIMER_1).buildIn(advanced);
+        complementary.deadTime = 1009;
+        CHECK(hostFails([&] { return channel.init(advanced, complementary); }, DriverError::InvalidConfig));
+        return true;
+    }
+
+    bool testWaveform()
+    {
+        PwmFixture fixture(TIMER_3, TIM3);
+        PwmChannel channel(fixture.timer, pwm(PwmChannel::Channel::Ch1, 99, 5));
+        channel.start();
+
+        // Once: the update event loads a frame, the next one makes it active. The last
+        // frame holds.
+        static const uint32_t frames[] = { 10, 20, 30, 40 };
+        CHECK(hostSucceeds([&] { return channel.startWaveform(frames, 4, 1, false); }));
+        Period periods[8];
+        fixture.sample(periods, 8);
+        const uint32_t once[] = { 5, 10, 20, 30, 40, 40, 40, 40 };
+        for(size_t i = 0; i < 8; i++)
+            CHECK(periods[i].active[0] == once[i]);
+        CHECK(!channel.isWaveformRunning() && channel.getDuty() == 40);
+        channel.stopWaveform();
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_2));
+        fixture.sample(periods, 1);
+        CHECK(periods[0].active[0] == 40);
+
+        // Repeated, until stopped: the compare value then stays where the waveform left it.
+        CHECK(hostSucceeds([&] { return channel.startWaveform(frames, 4, 1, true); }));
+        CHECK(DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_2));
+        fixture.sample(periods, 8);
+        const uint32_t repeated[] = { 40, 10, 20, 30, 40, 10, 20, 30 };
+        for(size_t i = 0; i < 8; i++)
+            CHECK(periods[i].active[0] == repeated[i]);
+        CHECK(channel.isWaveformRunning());
+
+        channel.stopWaveform();
+        CHECK(!channel.isWaveformRunning() && !DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_2));
+        uint32_t held = channel.getDuty();
+        fixture.sample(periods, 3);
+        CHECK(periods[1].active[0] == held && periods[2].active[0] == held);
+
+        // The stream taken by someone else, and a frame past the last channel.
+        CHECK(DmaStreams::claim(DMA1, LL_DMA_STREAM_2));
+        CHECK(hostFails([&] { return channel.startWaveform(frames, 4); }, DriverError::InUse));
+        DmaStreams::release(DMA1, LL_DMA_STREAM_2);
+        CHECK(hostFails([&] { return channel.startWaveform(frames, 1, 5); }, DriverError::InvalidArgument));
+        return true;
+    }
+
+    bool testWaveformBurst()
+    {
+        // An RGB LED on channels 2-4: one burst of three compare values per update event.
+        PwmFixture fixture(TIMER_5, TIM5);
+        PwmChannel red(fixture.timer, pwm(PwmChannel::Channel::Ch2, 255, 0));
+        PwmChannel green(fixture.timer, pwm(PwmChannel::Channel::Ch3, 0, 0));
+        PwmChannel blue(fixture.timer, pwm(PwmChannel::Channel::Ch4, 0, 0));
+        red.start();
+        green.start();
+        blue.start();
+
+        static const uint32_t frames[] =
+        {
+            255, 0, 0,
+            0, 128, 0,
+            0, 0, 64,
+        };
+        CHECK(hostSucceeds([&] { return red.startWaveform(frames, 3, 3, false); }));
+
+        Period periods[5];
+        fixture.sample(periods, 5);
+        for(size_t frame = 0; frame < 3; frame++)
+        {
+            for(uint8_t colour = 0; colour < 3; colour++)
+                CHECK(periods[frame + 1].active[colour + 1] == frames[3 * frame + colour]);
+        }
+        CHECK(periods[4].active[1] == 0 && periods[4].active[2] == 0 && periods[4].active[3] == 64);
+        CHECK(periods[0].active[1] == 0 && periods[0].active[2] == 0 && periods[0].active[3] == 0);
+
+        red.stop();
+        CHECK(!DmaStreams::isClaimed(DMA1, LL_DMA_STREAM_0));
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "edge_aligned",    testEdgeAligned },
+        { "active_low",      testActiveLow },
+        { "center_aligned",  testCenterAligned },
+        { "complementary",   testComplementary },
+        { "invalid_config",  testInvalidConfig },
+        { "waveform",        testWaveform },
+        { "waveform_burst",  testWaveformBurst },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}
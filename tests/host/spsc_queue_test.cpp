@@ -0,0 +1,164 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "host_test.hpp"
+
+#include "spsc_queue.hpp"
+
+// ============================================================================
+// SpscQueue on its own: FIFO order across the wrap, tombstones left by the consumer-side
+// removals, and a producer and a consumer thread running against each other.
+// ============================================================================
+
+namespace
+{
+    bool testFifo()
+    {
+        SpscQueue<uint32_t, 8> queue;
+        uint32_t next = 0;
+        uint32_t expected = 0;
+
+        // Several laps, so the free-running indexes wrap over the buffer.
+        for(int lap = 0; lap < 5; lap++)
+        {
+            while(queue.tryEnqueue(next))
+                next++;
+            CHECK(queue.isFull() && queue.size() == 8);
+
+            uint32_t element = 0;
+            for(int i = 0; i < 5; i++)
+            {
+                CHECK(queue.tryDequeue(element));
+                CHECK(element == expected++);
+            }
+            CHECK(queue.size() == 3 && *queue.peek() == expected);
+        }
+
+        uint32_t element = 0;
+        while(queue.tryDequeue(element))
+            CHECK(element == expected++);
+        CHECK(expected == next);
+        CHECK(queue.isEmpty() && !queue.peek());
+        return true;
+    }
+
+    bool testTombstones()
+    {
+        SpscQueue<uint32_t, 8> queue;
+        for(uint32_t i = 0; i < 8; i++)
+            CHECK(queue.tryEnqueue(i));
+
+        // A tombstone takes its slot until the front reaches it.
+        CHECK(queue.remove(2));
+        CHECK(!queue.remove(2));
+        CHECK(queue.size() == 7);
+        CHECK(queue.isFull() && !queue.tryEnqueue(8));
+
+        CHECK(DRIVER_VALUE(queue.dequeue(1)) == 1);
+        CHECK(*queue.peek(1) == 3);
+        CHECK(*queue.peek(4) == 6);
+
+        // The front goes too: the head moves past the tombstones of 1 and 2 behind it.
+        size_t removed = queue.removeIf([](const uint32_t& element, void*)
+        {
+            return element % 2 == 0;
+        }, nullptr);
+        CHECK(removed == 3);
+        CHECK(queue.size() == 3 && *queue.peek() == 3);
+        CHECK(!queue.isFull());
+
+        // Refill over the skipped slots (a flag left behind would hide an element). The
+        // tombstones of 4 and 6 still take theirs.
+        uint32_t next = 8;
+        while(queue.tryEnqueue(next))
+            next++;
+        CHECK(queue.size() == 6 && next == 11);
+
+        uint32_t element = 0;
+        for(uint32_t expected : { 3u, 5u, 7u, 8u, 9u, 10u })
+        {
+            CHECK(queue.tryDequeue(element));
+            CHECK(element == expected);
+        }
+        CHECK(!queue.tryDequeue(element));
+        return true;
+    }
+
+    bool testConcurrent()
+    {
+        // Small, so the producer often finds it full and the consumer empty.
+        constexpr size_t SIZE = 16;
+        constexpr uint32_t COUNT = 500000;
+        SpscQueue<uint32_t, SIZE> queue;
+        std::atomic<bool> sizeOutOfRange = false;
+
+        std::thread producer([&]
+        {
+            for(uint32_t value = 1; value <= COUNT; value++)
+            {
+                while(!queue.tryEnqueue(value))
+                    std::this_thread::yield();
+
+                // Seen from the producer, size() may lag but never runs out of range.
+                if(queue.size() > SIZE)
+                    sizeOutOfRange = true;
+            }
+        });
+
+        // The consumer dequeues in order and, now and then, cancels from the middle as
+        // I2cBus::cancel() would.
+        std::vector<uint8_t> seen(COUNT + 1, 0);
+        uint32_t last = 0;
+        uint32_t received = 0;
+        uint32_t cancelled = 0;
+        bool outOfOrder = false;
+        bool removeFailed = false;
+
+        for(uint32_t iteration = 0; received + cancelled < COUNT; iteration++)
+        {
+            if(iteration % 7 == 0 && queue.size() >= 3)
+            {
+                uint32_t victim = iteration % 2 ? *queue.peek(2) : DRIVER_VALUE(queue.dequeue(1));
+                if(iteration % 2)
+                    removeFailed |= !queue.remove(victim);
+                seen[victim]++;
+                cancelled++;
+                continue;
+            }
+
+            uint32_t value = 0;
+            if(!queue.tryDequeue(value))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            outOfOrder |= value <= last;
+            last = value;
+            seen[value]++;
+            received++;
+        }
+
+        producer.join();
+        CHECK(!outOfOrder && !removeFailed);
+        CHECK(!sizeOutOfRange);
+        CHECK(cancelled > 0);
+        CHECK(queue.isEmpty());
+        for(uint32_t value = 1; value <= COUNT; value++)
+            CHECK(seen[value] == 1);
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "fifo",       testFifo },
+        { "tombstones", testTombstones },
+        { "concurrent", testConcurrent },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}
@@ -0,0 +1,142 @@
+#include <set>
+
+#include "host_test.hpp"
+
+#include "set.hpp"
+
+// ============================================================================
+// StaticSet on its own: the packed buffer behind begin()/end(), removals moving the last
+// element into the hole, and the hashed index through tombstones, rebuilds and a hash
+// that sends everything to the same slot.
+// ============================================================================
+
+namespace
+{
+    template <typename SetType, typename ElementType>
+    bool added(SetType& set, const ElementType& element)
+    {
+        return hostSucceeds([&] { return set.add(element); });
+    }
+
+    template <typename ElementType, size_t BufferSize, typename Hash>
+    bool sameElements(StaticSet<ElementType, BufferSize, Hash>& set, const std::set<ElementType>& expected)
+    {
+        std::set<ElementType> seen(set.begin(), set.end());
+        return set.getLength() == expected.size() && seen.size() == expected.size() && seen == expected;
+    }
+
+    bool testAddRemove()
+    {
+        int objects[5];
+        StaticSet<int*, 4> set;
+
+        for(int i = 0; i < 4; i++)
+            CHECK(added(set, &objects[i]));
+        CHECK(set.getLength() == 4);
+        CHECK(hostFails([&] { return set.add(&objects[4]); }, DriverError::Full));
+
+        CHECK(set.isFound(&objects[2]) && !set.isFound(&objects[4]));
+
+        // The last element fills the hole: still packed, still found where it moved.
+        CHECK(set.remove(&objects[1]) && !set.remove(&objects[1]));
+        CHECK(sameElements(set, { &objects[0], &objects[2], &objects[3] }));
+        CHECK(set.isFound(&objects[3]));
+        CHECK(hostFails([&] { return set.add(&objects[3]); }, DriverError::AlreadyPresent));
+
+        CHECK(added(set, &objects[4]));
+        CHECK(sameElements(set, { &objects[0], &objects[2], &objects[3], &objects[4] }));
+        return true;
+    }
+
+    bool testPopClear()
+    {
+        StaticSet<uint32_t, 8> set;
+        for(uint32_t value : { 10u, 20u, 30u })
+            CHECK(added(set, value));
+
+        // pop() takes the last one in the buffer, and forgets it.
+        CHECK(DRIVER_VALUE(set.pop()) == 30);
+        CHECK(sameElements(set, { 10, 20 }) && !set.isFound(30));
+        CHECK(added(set, 30));
+
+        set.clear();
+        CHECK(set.getLength() == 0 && set.begin() == set.end());
+        CHECK(!set.isFound(10) && !set.isFound(20) && !set.isFound(30));
+        CHECK(hostFails([&] { return set.pop(); }, DriverError::Empty));
+
+        CHECK(added(set, 20));
+        CHECK(sameElements(set, { 20 }));
+        return true;
+    }
+
+    bool testChurn()
+    {
+        // Far more removals than table slots: the tombstones must be rebuilt away, or a
+        // lookup of a missing element would probe forever.
+        constexpr size_t SIZE = 16;
+        StaticSet<uint32_t, SIZE> set;
+        std::set<uint32_t> expected;
+        uint32_t state = 0x2545F491;
+
+        for(int i = 0; i < 100000; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            uint32_t value = state % 64;
+
+            if(expected.count(value))
+            {
+                CHECK(set.remove(value));
+                expected.erase(value);
+            }
+            else if(expected.size() < SIZE)
+            {
+                CHECK(added(set, value));
+                expected.insert(value);
+            }
+            CHECK(set.isFound(value) == (expected.count(value) != 0));
+        }
+        CHECK(sameElements(set, expected));
+        return true;
+    }
+
+    struct SameSlot
+    {
+        size_t operator()(uint32_t) const
+        {
+            return 0;
+        }
+    };
+
+    bool testCollisions()
+    {
+        // One probe sequence for everything: lookups must walk past the tombstones, and
+        // the element moved into a hole must stay found.
+        StaticSet<uint32_t, 8, SameSlot> set;
+        for(uint32_t value = 1; value <= 8; value++)
+            CHECK(added(set, value));
+
+        CHECK(set.remove(3) && set.remove(1) && !set.remove(1));
+        for(uint32_t value = 1; value <= 8; value++)
+            CHECK(set.isFound(value) == (value != 1 && value != 3));
+
+        CHECK(hostFails([&] { return set.add(8); }, DriverError::AlreadyPresent));
+        CHECK(added(set, 1));
+        CHECK(sameElements(set, { 1, 2, 4, 5, 6, 7, 8 }));
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "add_remove", testAddRemove },
+        { "pop_clear",  testPopClear },
+        { "churn",      testChurn },
+        { "collisions", testCollisions },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}
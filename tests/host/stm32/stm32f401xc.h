@@ -0,0 +1,334 @@
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+// Host stand-in for the CMSIS device header (stm32f401xc.h + core_cm4.h +
+// system_stm32f4xx.h). Peripherals are plain structs in host memory with the
+// register layout of RM0368; the I2C, DMA and TIM ones are driven by the register
+// model in tests/host/model, the rest (RCC, GPIO) are only storage. The model runs in
+// the same thread as the code under test, so the registers aren't volatile.
+//
+// The TIM registers whose accesses have side effects the model needs are small
+// wrappers (C++ only): SR is rc_w0, and takes no compound assignment, since a
+// read-modify-write could clear flags set meanwhile; writing EGR generates its events.
+// ============================================================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    DMA1_Stream0_IRQn       = 11,
+    DMA1_Stream1_IRQn       = 12,
+    DMA1_Stream2_IRQn       = 13,
+    DMA1_Stream3_IRQn       = 14,
+    DMA1_Stream4_IRQn       = 15,
+    DMA1_Stream5_IRQn       = 16,
+    DMA1_Stream6_IRQn       = 17,
+    TIM1_BRK_TIM9_IRQn      = 24,
+    TIM1_UP_TIM10_IRQn      = 25,
+    TIM1_TRG_COM_TIM11_IRQn = 26,
+    TIM1_CC_IRQn            = 27,
+    TIM2_IRQn               = 28,
+    TIM3_IRQn               = 29,
+    TIM4_IRQn               = 30,
+    I2C1_EV_IRQn            = 31,
+    I2C1_ER_IRQn            = 32,
+    I2C2_EV_IRQn            = 33,
+    I2C2_ER_IRQn            = 34,
+    DMA1_Stream7_IRQn       = 47,
+    TIM5_IRQn               = 50,
+    I2C3_EV_IRQn            = 72,
+    I2C3_ER_IRQn            = 73,
+    HOST_IRQ_COUNT          = 86,
+} IRQn_Type;
+
+typedef enum
+{
+    SUCCESS = 0U,
+    ERROR = !SUCCESS
+} ErrorStatus;
+
+typedef struct
+{
+    uint32_t CR1;
+    uint32_t CR2;
+    uint32_t OAR1;
+    uint32_t OAR2;
+    uint32_t DR;
+    uint32_t SR1;
+    uint32_t SR2;
+    uint32_t CCR;
+    uint32_t TRISE;
+    uint32_t FLTR;
+} I2C_TypeDef;
+
+typedef struct
+{
+    uint32_t CR;
+    uint32_t NDTR;
+    uintptr_t PAR;     // Address registers widened to hold host pointers
+    uintptr_t M0AR;
+    uintptr_t M1AR;
+    uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+    uint32_t LISR;
+    uint32_t HISR;
+    uint32_t LIFCR;
+    uint32_t HIFCR;
+    DMA_Stream_TypeDef stream[8];
+} DMA_TypeDef;
+
+#ifdef __cplusplus
+struct HostTimStatus
+{
+    uint32_t value;
+
+    operator uint32_t() const { return value; }
+
+    // rc_w0: a 0 clears the flag, a 1 leaves it as it is.
+    HostTimStatus& operator=(uint32_t written)
+    {
+        value &= written;
+        return *this;
+    }
+};
+
+struct HostTimEvents
+{
+    uint32_t value;
+
+    // Reads as 0.
+    operator uint32_t() const { return 0; }
+
+    // Generates the events written (tim_model.cpp).
+    HostTimEvents& operator=(uint32_t events);
+
+    HostTimEvents& operator|=(uint32_t events)
+    {
+        return *this = events;
+    }
+};
+#else
+typedef uint32_t HostTimStatus;
+typedef uint32_t HostTimEvents;
+#endif
+
+typedef struct
+{
+    uint32_t CR1;
+    uint32_t CR2;
+    uint32_t SMCR;
+    uint32_t DIER;
+    HostTimStatus SR;
+    HostTimEvents EGR;
+    uint32_t CCMR1;
+    uint32_t CCMR2;
+    uint32_t CCER;
+    uint32_t CNT;
+    uint32_t PSC;
+    uint32_t ARR;
+    uint32_t RCR;
+    uint32_t CCR1;
+    uint32_t CCR2;
+    uint32_t CCR3;
+    uint32_t CCR4;
+    uint32_t BDTR;
+    uint32_t DCR;
+    uint32_t DMAR;
+    uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    uint32_t CR;
+    uint32_t PLLCFGR;
+    uint32_t CFGR;
+    uint32_t CIR;
+    uint32_t AHB1RSTR;
+    uint32_t AHB2RSTR;
+    uint32_t APB1RSTR;
+    uint32_t APB2RSTR;
+    uint32_t AHB1ENR;
+    uint32_t AHB2ENR;
+    uint32_t APB1ENR;
+    uint32_t APB2ENR;
+} RCC_TypeDef;
+
+typedef struct
+{
+    uint32_t MODER;
+    uint32_t OTYPER;
+    uint32_t OSPEEDR;
+    uint32_t PUPDR;
+    uint32_t IDR;
+    uint32_t ODR;
+    uint32_t BSRR;
+    uint32_t LCKR;
+    uint32_t AFR[2];
+} GPIO_TypeDef;
+
+extern I2C_TypeDef hostI2c[3];
+extern DMA_TypeDef hostDma[2];
+extern TIM_TypeDef hostTim[8];
+extern RCC_TypeDef hostRcc;
+extern GPIO_TypeDef hostGpio[3];
+extern uint32_t hostUid[3];
+
+#define I2C1    (&hostI2c[0])
+#define I2C2    (&hostI2c[1])
+#define I2C3    (&hostI2c[2])
+#define DMA1    (&hostDma[0])
+#define DMA2    (&hostDma[1])
+#define TIM1    (&hostTim[0])
+#define TIM2    (&hostTim[1])
+#define TIM3    (&hostTim[2])
+#define TIM4    (&hostTim[3])
+#define TIM5    (&hostTim[4])
+#define TIM9    (&hostTim[5])
+#define TIM10   (&hostTim[6])
+#define TIM11   (&hostTim[7])
+#define RCC     (&hostRcc)
+#define GPIOA   (&hostGpio[0])
+#define GPIOB   (&hostGpio[1])
+#define GPIOC   (&hostGpio[2])
+#define UID_BASE ((uintptr_t)hostUid)
+
+// I2C
+#define I2C_CR1_PE          (1U << 0)
+#define I2C_CR1_ENGC        (1U << 6)
+#define I2C_CR1_START       (1U << 8)
+#define I2C_CR1_STOP        (1U << 9)
+#define I2C_CR1_ACK         (1U << 10)
+#define I2C_CR1_POS         (1U << 11)
+#define I2C_CR1_SWRST       (1U << 15)
+#define I2C_CR2_ITERREN     (1U << 8)
+#define I2C_CR2_ITEVTEN     (1U << 9)
+#define I2C_CR2_ITBUFEN     (1U << 10)
+#define I2C_CR2_DMAEN       (1U << 11)
+#define I2C_CR2_LAST        (1U << 12)
+#define I2C_OAR2_ENDUAL     (1U << 0)
+#define I2C_SR1_SB          (1U << 0)
+#define I2C_SR1_ADDR        (1U << 1)
+#define I2C_SR1_BTF         (1U << 2)
+#define I2C_SR1_ADD10       (1U << 3)
+#define I2C_SR1_STOPF       (1U << 4)
+#define I2C_SR1_RXNE        (1U << 6)
+#define I2C_SR1_TXE         (1U << 7)
+#define I2C_SR1_BERR        (1U << 8)
+#define I2C_SR1_ARLO        (1U << 9)
+#define I2C_SR1_AF          (1U << 10)
+#define I2C_SR1_OVR         (1U << 11)
+#define I2C_SR2_MSL         (1U << 0)
+#define I2C_SR2_BUSY        (1U << 1)
+#define I2C_SR2_TRA         (1U << 2)
+#define I2C_SR2_GENCALL     (1U << 4)
+
+// DMA stream CR
+#define DMA_SxCR_EN         (1U << 0)
+#define DMA_SxCR_TEIE       (1U << 2)
+#define DMA_SxCR_TCIE       (1U << 4)
+#define DMA_SxCR_DIR_Pos    6U
+#define DMA_SxCR_DIR        (3U << DMA_SxCR_DIR_Pos)
+#define DMA_SxCR_CIRC       (1U << 8)
+#define DMA_SxCR_PINC       (1U << 9)
+#define DMA_SxCR_MINC       (1U << 10)
+#define DMA_SxCR_PSIZE_Pos  11U
+#define DMA_SxCR_PSIZE      (3U << DMA_SxCR_PSIZE_Pos)
+#define DMA_SxCR_MSIZE_Pos  13U
+#define DMA_SxCR_MSIZE      (3U << DMA_SxCR_MSIZE_Pos)
+#define DMA_SxCR_PL_Pos     16U
+#define DMA_SxCR_PL         (3U << DMA_SxCR_PL_Pos)
+#define DMA_SxCR_CHSEL_Pos  25U
+#define DMA_SxCR_CHSEL      (7U << DMA_SxCR_CHSEL_Pos)
+
+// RCC
+#define RCC_AHB1ENR_DMA1EN  (1U << 21)
+#define RCC_AHB1ENR_DMA2EN  (1U << 22)
+#define RCC_APB1ENR_TIM2EN  (1U << 0)
+#define RCC_APB1ENR_TIM3EN  (1U << 1)
+#define RCC_APB1ENR_TIM4EN  (1U << 2)
+#define RCC_APB1ENR_TIM5EN  (1U << 3)
+#define RCC_APB2ENR_TIM1EN  (1U << 0)
+#define RCC_APB2ENR_TIM9EN  (1U << 16)
+#define RCC_APB2ENR_TIM10EN (1U << 17)
+#define RCC_APB2ENR_TIM11EN (1U << 18)
+#define RCC_CFGR_PPRE1_Pos  10U
+#define RCC_CFGR_PPRE1      (7U << RCC_CFGR_PPRE1_Pos)
+#define RCC_CFGR_PPRE2_Pos  13U
+#define RCC_CFGR_PPRE2      (7U << RCC_CFGR_PPRE2_Pos)
+
+// TIM
+#define TIM_CR1_CEN         (1U << 0)
+#define TIM_CR1_URS         (1U << 2)
+#define TIM_CR1_OPM         (1U << 3)
+#define TIM_CR1_DIR         (1U << 4)
+#define TIM_CR1_CMS_Pos     5U
+#define TIM_CR1_CMS         (3U << TIM_CR1_CMS_Pos)
+#define TIM_CR1_CMS_0       (1U << TIM_CR1_CMS_Pos)
+#define TIM_CR1_ARPE        (1U << 7)
+#define TIM_DIER_UIE        (1U << 0)
+#define TIM_DIER_CC1IE      (1U << 1)
+#define TIM_DIER_CC2IE      (1U << 2)
+#define TIM_DIER_CC3IE      (1U << 3)
+#define TIM_DIER_CC4IE      (1U << 4)
+#define TIM_DIER_COMIE      (1U << 5)
+#define TIM_DIER_TIE        (1U << 6)
+#define TIM_DIER_BIE        (1U << 7)
+#define TIM_DIER_UDE        (1U << 8)
+#define TIM_DIER_CC1DE      (1U << 9)
+#define TIM_SR_UIF          (1U << 0)
+#define TIM_SR_CC1IF        (1U << 1)
+#define TIM_SR_CC2IF        (1U << 2)
+#define TIM_SR_CC3IF        (1U << 3)
+#define TIM_SR_CC4IF        (1U << 4)
+#define TIM_SR_COMIF        (1U << 5)
+#define TIM_SR_TIF          (1U << 6)
+#define TIM_SR_BIF          (1U << 7)
+#define TIM_SR_CC1OF        (1U << 9)
+#define TIM_EGR_UG          (1U << 0)
+#define TIM_EGR_CC1G        (1U << 1)
+#define TIM_EGR_COMG        (1U << 5)
+#define TIM_EGR_TG          (1U << 6)
+#define TIM_EGR_BG          (1U << 7)
+#define TIM_CCMR1_CC1S      (3U << 0)
+#define TIM_CCMR1_OC1PE     (1U << 3)
+#define TIM_CCMR1_OC1M_Pos  4U
+#define TIM_CCMR1_OC1M      (7U << TIM_CCMR1_OC1M_Pos)
+#define TIM_CCMR1_OC1M_1    (1U << 5)
+#define TIM_CCMR1_OC1M_2    (1U << 6)
+#define TIM_CCMR1_IC1PSC_Pos 2U
+#define TIM_CCMR1_IC1PSC    (3U << TIM_CCMR1_IC1PSC_Pos)
+#define TIM_CCMR1_IC1F_Pos  4U
+#define TIM_CCER_CC1E       (1U << 0)
+#define TIM_CCER_CC1P       (1U << 1)
+#define TIM_CCER_CC1NE      (1U << 2)
+#define TIM_CCER_CC1NP      (1U << 3)
+#define TIM_BDTR_DTG        (0xFFU << 0)
+#define TIM_BDTR_MOE        (1U << 15)
+#define TIM_DCR_DBA         (0x1FU << 0)
+#define TIM_DCR_DBL_Pos     8U
+#define TIM_DCR_DBL         (0x1FU << TIM_DCR_DBL_Pos)
+
+// Core (core_cm4.h / system_stm32f4xx.h)
+extern uint32_t SystemCoreClock;
+void SystemCoreClockUpdate(void);
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+#define __NOP() ((void)0)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+// ============================================================================
+// Host stand-in for stm32f4xx.h: the device header plus the few HAL GPIO/RCC
+// pieces the drivers use. GPIO is only storage, and every pin reads back high
+// (lines released), which is what I2cBus::recoverBus() expects from a free bus.
+// ============================================================================
+
+#include "stm32f401xc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_3                  ((uint16_t)0x0008)
+#define GPIO_PIN_4                  ((uint16_t)0x0010)
+#define GPIO_PIN_6                  ((uint16_t)0x0040)
+#define GPIO_PIN_7                  ((uint16_t)0x0080)
+#define GPIO_PIN_8                  ((uint16_t)0x0100)
+#define GPIO_PIN_9                  ((uint16_t)0x0200)
+#define GPIO_PIN_10                 ((uint16_t)0x0400)
+
+#define GPIO_MODE_OUTPUT_OD         0x00000011U
+#define GPIO_MODE_AF_OD             0x00000012U
+#define GPIO_PULLUP                 0x00000001U
+#define GPIO_SPEED_FREQ_VERY_HIGH   0x00000003U
+
+#define GPIO_AF4_I2C1               ((uint8_t)0x04)
+#define GPIO_AF4_I2C2               ((uint8_t)0x04)
+#define GPIO_AF4_I2C3               ((uint8_t)0x04)
+#define GPIO_AF9_I2C2               ((uint8_t)0x09)
+#define GPIO_AF9_I2C3               ((uint8_t)0x09)
+
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init);
+void HAL_GPIO_DeInit(GPIO_TypeDef* port, uint32_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()    ((void)0)
+#define __HAL_RCC_I2C1_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_I2C2_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_I2C3_CLK_ENABLE()     ((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE()     (RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN)
+
+#ifdef __cplusplus
+}
+#endif
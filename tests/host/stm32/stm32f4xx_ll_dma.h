@@ -0,0 +1,71 @@
+#pragma once
+
+// ============================================================================
+// Host stand-in for stm32f4xx_ll_dma.h. The stream registers are the host DMA
+// structs; transfers are run by the DMA model (tests/host/model/dma_model.cpp).
+// Addresses are uintptr_t instead of uint32_t so host pointers fit.
+// ============================================================================
+
+#include "stm32f4xx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LL_DMA_STREAM_0                     0x00000000U
+#define LL_DMA_STREAM_1                     0x00000001U
+#define LL_DMA_STREAM_2                     0x00000002U
+#define LL_DMA_STREAM_3                     0x00000003U
+#define LL_DMA_STREAM_4                     0x00000004U
+#define LL_DMA_STREAM_5                     0x00000005U
+#define LL_DMA_STREAM_6                     0x00000006U
+#define LL_DMA_STREAM_7                     0x00000007U
+
+#define LL_DMA_CHANNEL_0                    (0U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_1                    (1U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_2                    (2U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_3                    (3U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_4                    (4U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_5                    (5U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_6                    (6U << DMA_SxCR_CHSEL_Pos)
+#define LL_DMA_CHANNEL_7                    (7U << DMA_SxCR_CHSEL_Pos)
+
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY   (0U << DMA_SxCR_DIR_Pos)
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH   (1U << DMA_SxCR_DIR_Pos)
+
+#define LL_DMA_MODE_NORMAL                  0x00000000U
+#define LL_DMA_MODE_CIRCULAR                DMA_SxCR_CIRC
+
+#define LL_DMA_PERIPH_NOINCREMENT           0x00000000U
+#define LL_DMA_MEMORY_INCREMENT             DMA_SxCR_MINC
+
+#define LL_DMA_PDATAALIGN_BYTE              (0U << DMA_SxCR_PSIZE_Pos)
+#define LL_DMA_PDATAALIGN_WORD              (2U << DMA_SxCR_PSIZE_Pos)
+#define LL_DMA_MDATAALIGN_BYTE              (0U << DMA_SxCR_MSIZE_Pos)
+#define LL_DMA_MDATAALIGN_WORD              (2U << DMA_SxCR_MSIZE_Pos)
+
+#define LL_DMA_PRIORITY_HIGH                (2U << DMA_SxCR_PL_Pos)
+
+void LL_DMA_EnableStream(DMA_TypeDef* dma, uint32_t stream);
+void LL_DMA_DisableStream(DMA_TypeDef* dma, uint32_t stream);
+uint32_t LL_DMA_IsEnabledStream(DMA_TypeDef* dma, uint32_t stream);
+
+void LL_DMA_SetChannelSelection(DMA_TypeDef* dma, uint32_t stream, uint32_t channel);
+void LL_DMA_SetDataTransferDirection(DMA_TypeDef* dma, uint32_t stream, uint32_t direction);
+void LL_DMA_SetMode(DMA_TypeDef* dma, uint32_t stream, uint32_t mode);
+void LL_DMA_SetStreamPriorityLevel(DMA_TypeDef* dma, uint32_t stream, uint32_t priority);
+void LL_DMA_SetPeriphIncMode(DMA_TypeDef* dma, uint32_t stream, uint32_t incrementMode);
+void LL_DMA_SetMemoryIncMode(DMA_TypeDef* dma, uint32_t stream, uint32_t incrementMode);
+void LL_DMA_SetPeriphSize(DMA_TypeDef* dma, uint32_t stream, uint32_t size);
+void LL_DMA_SetMemorySize(DMA_TypeDef* dma, uint32_t stream, uint32_t size);
+void LL_DMA_ConfigAddresses(DMA_TypeDef* dma, uint32_t stream, uintptr_t sourceAddress,
+                            uintptr_t destinationAddress, uint32_t direction);
+void LL_DMA_SetDataLength(DMA_TypeDef* dma, uint32_t stream, uint32_t length);
+uint32_t LL_DMA_GetDataLength(DMA_TypeDef* dma, uint32_t stream);
+
+void LL_DMA_EnableIT_TC(DMA_TypeDef* dma, uint32_t stream);
+void LL_DMA_EnableIT_TE(DMA_TypeDef* dma, uint32_t stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+// ============================================================================
+// Host stand-in for stm32f4xx_ll_i2c.h. Same names and constants as the LL
+// library, but every call goes through the I2Cv1 register model
+// (tests/host/model/i2c_model.cpp), which applies the side effects of the real
+// register accesses (DR write clears SB/TXE, SR1+SR2 read clears ADDR, ...).
+// ============================================================================
+
+#include "stm32f4xx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint32_t PeripheralMode;
+    uint32_t ClockSpeed;
+    uint32_t DutyCycle;
+    uint32_t AnalogFilter;
+    uint32_t DigitalFilter;
+    uint32_t OwnAddress1;
+    uint32_t TypeAcknowledge;
+    uint32_t OwnAddrSize;
+} LL_I2C_InitTypeDef;
+
+#define LL_I2C_MODE_I2C             0x00000000U
+#define LL_I2C_DUTYCYCLE_2          0x00000000U
+#define LL_I2C_DUTYCYCLE_16_9       (1U << 14)
+#define LL_I2C_OWNADDRESS1_7BIT     0x00004000U
+#define LL_I2C_OWNADDRESS1_10BIT    0x0000C000U
+#define LL_I2C_ACK                  I2C_CR1_ACK
+#define LL_I2C_NACK                 0x00000000U
+
+#define LL_I2C_ReadReg(__INSTANCE__, __REG__) hostI2cRead##__REG__(__INSTANCE__)
+uint32_t hostI2cReadSR1(I2C_TypeDef* i2c);
+uint32_t hostI2cReadSR2(I2C_TypeDef* i2c);
+
+ErrorStatus LL_I2C_Init(I2C_TypeDef* i2c, LL_I2C_InitTypeDef* init);
+ErrorStatus LL_I2C_DeInit(I2C_TypeDef* i2c);
+void LL_I2C_StructInit(LL_I2C_InitTypeDef* init);
+
+void LL_I2C_Enable(I2C_TypeDef* i2c);
+void LL_I2C_Disable(I2C_TypeDef* i2c);
+
+void LL_I2C_SetOwnAddress2(I2C_TypeDef* i2c, uint32_t ownAddress2);
+void LL_I2C_EnableOwnAddress2(I2C_TypeDef* i2c);
+void LL_I2C_DisableOwnAddress2(I2C_TypeDef* i2c);
+void LL_I2C_EnableClockStretching(I2C_TypeDef* i2c);
+void LL_I2C_DisableClockStretching(I2C_TypeDef* i2c);
+void LL_I2C_EnableGeneralCall(I2C_TypeDef* i2c);
+void LL_I2C_DisableGeneralCall(I2C_TypeDef* i2c);
+
+void LL_I2C_EnableIT_EVT(I2C_TypeDef* i2c);
+void LL_I2C_EnableIT_ERR(I2C_TypeDef* i2c);
+void LL_I2C_EnableIT_BUF(I2C_TypeDef* i2c);
+void LL_I2C_DisableIT_BUF(I2C_TypeDef* i2c);
+
+void LL_I2C_EnableDMAReq_TX(I2C_TypeDef* i2c);
+void LL_I2C_DisableDMAReq_TX(I2C_TypeDef* i2c);
+void LL_I2C_EnableDMAReq_RX(I2C_TypeDef* i2c);
+void LL_I2C_DisableDMAReq_RX(I2C_TypeDef* i2c);
+void LL_I2C_EnableLastDMA(I2C_TypeDef* i2c);
+void LL_I2C_DisableLastDMA(I2C_TypeDef* i2c);
+uintptr_t LL_I2C_DMA_GetRegAddr(I2C_TypeDef* i2c);
+
+void LL_I2C_GenerateStartCondition(I2C_TypeDef* i2c);
+void LL_I2C_GenerateStopCondition(I2C_TypeDef* i2c);
+void LL_I2C_AcknowledgeNextData(I2C_TypeDef* i2c, uint32_t type);
+void LL_I2C_EnableBitPOS(I2C_TypeDef* i2c);
+void LL_I2C_DisableBitPOS(I2C_TypeDef* i2c);
+
+uint32_t LL_I2C_IsActiveFlag_SB(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_ADDR(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_BTF(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_STOP(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_RXNE(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_TXE(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_BERR(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_ARLO(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_AF(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_OVR(I2C_TypeDef* i2c);
+uint32_t LL_I2C_IsActiveFlag_BUSY(I2C_TypeDef* i2c);
+
+void LL_I2C_ClearFlag_ADDR(I2C_TypeDef* i2c);
+void LL_I2C_ClearFlag_STOP(I2C_TypeDef* i2c);
+void LL_I2C_ClearFlag_BERR(I2C_TypeDef* i2c);
+void LL_I2C_ClearFlag_ARLO(I2C_TypeDef* i2c);
+void LL_I2C_ClearFlag_AF(I2C_TypeDef* i2c);
+void LL_I2C_ClearFlag_OVR(I2C_TypeDef* i2c);
+
+void LL_I2C_TransmitData8(I2C_TypeDef* i2c, uint8_t data);
+uint8_t LL_I2C_ReceiveData8(I2C_TypeDef* i2c);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,248 @@
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "input_capture.hpp"
+
+// ============================================================================
+// The timer vector table: TIM1 spreads its sources over four vectors, three of them shared
+// with TIM9, TIM10 and TIM11. Each flag raised must reach the driver of the timer that
+// raised it, and only that one, through the vector it's routed to, with both timers of a
+// shared vector served by a single interrupt.
+// ============================================================================
+
+namespace
+{
+    void countCall(void* argument)
+    {
+        ++*static_cast<uint32_t*>(argument);
+    }
+
+    // Periodic alarm every reload + 1 steps (PSC = 0), counting its callbacks. Not started.
+    void buildAlarm(ScopedTimer& timer, TimerSelection selection, uint32_t reload, uint32_t& calls)
+    {
+        (void)Timer::Builder()
+            .timerSelection(selection)
+            .setAlarm(reload)
+            .periodic()
+            .enableInterrupt()
+            .setCallback(countCall)
+            .setCallbackArguments(&calls)
+            .buildIn(timer);
+    }
+
+    bool testSharedUpdate()
+    {
+        // TIM1 and TIM10 both update through TIM1_UP_TIM10, at different rates.
+        HostMcu::reset();
+        ScopedTimer tim1;
+        ScopedTimer tim10;
+        uint32_t calls1 = 0;
+        uint32_t calls10 = 0;
+        buildAlarm(tim1, TIMER_1, 999, calls1);
+        buildAlarm(tim10, TIMER_10, 1499, calls10);
+
+        HostTim& model1 = HostTim::of(TIM1);
+        HostTim& model10 = HostTim::of(TIM10);
+        uint32_t events1 = model1.updateEvents;
+        uint32_t events10 = model10.updateEvents;
+        tim1.start();
+        tim10.start();
+        HostMcu::runUntil([] { return false; }, 30000);
+
+        // The last update events still get their interrupt.
+        tim1.pause();
+        tim10.pause();
+        HostMcu::step();
+
+        CHECK(calls1 == model1.updateEvents - events1 && calls1 >= 29);
+        CHECK(calls10 == model10.updateEvents - events10 && calls10 >= 19);
+        CHECK(!tim1.isAlarmPending() && !tim10.isAlarmPending());
+        return true;
+    }
+
+    bool testSameStep()
+    {
+        // Both timers of the vector update on the same step: one interrupt serves both.
+        HostMcu::reset();
+        ScopedTimer tim1;
+        ScopedTimer tim10;
+        uint32_t calls1 = 0;
+        uint32_t calls10 = 0;
+        buildAlarm(tim1, TIMER_1, 999, calls1);
+        buildAlarm(tim10, TIMER_10, 999, calls10);
+
+        HostTim& model1 = HostTim::of(TIM1);
+        HostTim& model10 = HostTim::of(TIM10);
+        uint32_t events1 = model1.updateEvents;
+        uint32_t events10 = model10.updateEvents;
+
+        __disable_irq();
+        tim1.start();
+        tim10.start();
+        CHECK(HostMcu::runUntil([&] { return model1.updateEvents != events1; }, 2000));
+        CHECK(model10.updateEvents != events10);
+        CHECK(tim1.isAlarmPending() && tim10.isAlarmPending());
+
+        uint32_t interrupts = HostMcu::interrupts;
+        __enable_irq();
+        HostMcu::step();
+        CHECK(HostMcu::interrupts - interrupts == 1);
+        CHECK(calls1 == 1 && calls10 == 1);
+        CHECK(!tim1.isAlarmPending() && !tim10.isAlarmPending());
+        return true;
+    }
+
+    bool testTim1Sources()
+    {
+        // Break and trigger/commutation of TIM1 go through the vectors of TIM9 and TIM11,
+        // which must not take them for their own update.
+        HostMcu::reset();
+        ScopedTimer tim1;
+        ScopedTimer tim9;
+        ScopedTimer tim11;
+        uint32_t calls1 = 0;
+        uint32_t calls9 = 0;
+        uint32_t calls11 = 0;
+        buildAlarm(tim1, TIMER_1, 999, calls1);
+        buildAlarm(tim9, TIMER_9, 999, calls9);
+        buildAlarm(tim11, TIMER_11, 999, calls11);
+        TIM1->DIER |= TIM_DIER_BIE | TIM_DIER_TIE | TIM_DIER_COMIE;
+
+        uint32_t interrupts = HostMcu::interrupts;
+        TIM1->EGR = TIM_EGR_BG;
+        CHECK(HostMcu::isIrqEnabled(TIM1_BRK_TIM9_IRQn));
+        HostMcu::step();
+        CHECK(HostMcu::interrupts - interrupts == 1 && !(TIM1->SR & TIM_SR_BIF));
+
+        TIM1->EGR = TIM_EGR_TG | TIM_EGR_COMG;
+        HostMcu::step();
+        CHECK(HostMcu::interrupts - interrupts == 2 && !(TIM1->SR & (TIM_SR_TIF | TIM_SR_COMIF)));
+        CHECK(calls1 == 0 && calls9 == 0 && calls11 == 0);
+
+        // Their own updates, each on its vector, and TIM1's on TIM1_UP_TIM10.
+        TIM9->EGR = TIM_EGR_UG;
+        HostMcu::step();
+        CHECK(calls9 == 1 && calls1 == 0 && calls11 == 0);
+
+        TIM11->EGR = TIM_EGR_UG;
+        HostMcu::step();
+        CHECK(calls11 == 1 && calls1 == 0 && calls9 == 1);
+
+        TIM1->EGR = TIM_EGR_UG;
+        HostMcu::step();
+        CHECK(calls1 == 1 && calls9 == 1 && calls11 == 1);
+
+        // All three at once: the break of TIM1 and the update of TIM9 share one interrupt.
+        interrupts = HostMcu::interrupts;
+        TIM1->EGR = TIM_EGR_BG;
+        TIM9->EGR = TIM_EGR_UG;
+        TIM11->EGR = TIM_EGR_UG;
+        HostMcu::runUntil([] { return !(TIM1->SR & TIM_SR_BIF) && !(TIM9->SR & TIM_SR_UIF) &&
+                                      !(TIM11->SR & TIM_SR_UIF); }, 10);
+        CHECK(HostMcu::interrupts - interrupts == 2);
+        CHECK(calls1 == 1 && calls9 == 2 && calls11 == 2);
+        return true;
+    }
+
+    bool testTim1Capture()
+    {
+        // Captures on TIM1_CC while TIM9 counts its alarm on TIM1_BRK_TIM9.
+        HostMcu::reset();
+        ScopedTimer tim1;
+        ScopedTimer tim9;
+        uint32_t calls1 = 0;
+        uint32_t calls9 = 0;
+        (void)Timer::Builder()
+            .timerSelection(TIMER_1)
+            .setCallback(countCall)
+            .setCallbackArguments(&calls1)
+            .buildIn(tim1);
+        buildAlarm(tim9, TIMER_9, 499, calls9);
+
+        uint32_t buffer[16];
+        InputCapture capture;
+        InputCapture::Config config;
+        config.edge = InputCapture::Edge::Rising;
+        config.buffer = buffer;
+        config.length = 16;
+        config.dma = false;
+        (void)capture.init(tim1, config);
+        capture.start();
+        CHECK(!capture.isDmaFed() && HostMcu::isIrqEnabled(TIM1_CC_IRQn));
+
+        uint32_t events9 = HostTim::of(TIM9).updateEvents;
+        HostTim::of(TIM1).driveInput(0, 800, 400);
+        tim9.start();
+        HostMcu::runUntil([] { return false; }, 800 * 10 + 100);
+        tim9.pause();
+        HostMcu::step();
+
+        InputCapture::Measurement measurement;
+        CHECK(capture.measure(measurement));
+        CHECK(measurement.periodTicks == 800 && measurement.periods == 10);
+        CHECK(calls1 == 0 && calls9 >= 16);
+        CHECK(calls9 == HostTim::of(TIM9).updateEvents - events9);
+        capture.stop();
+        return true;
+    }
+
+    bool testTim5()
+    {
+        HostMcu::reset();
+        ScopedTimer tim5;
+        uint32_t calls = 0;
+        buildAlarm(tim5, TIMER_5, 99, calls);
+        CHECK(HostMcu::isIrqEnabled(TIM5_IRQn));
+
+        tim5.start();
+        HostMcu::runUntil([] { return false; }, 1050);
+        CHECK(calls == 10);
+        tim5.pause();
+        return true;
+    }
+
+    bool testNoDriver()
+    {
+        // TIM10 raises its update with no driver behind it: TIM1_UP_TIM10 skips it and still
+        // serves TIM1.
+        HostMcu::reset();
+        ScopedTimer tim1;
+        uint32_t calls1 = 0;
+        buildAlarm(tim1, TIMER_1, 999, calls1);
+        CHECK(Timer::getDriver(TIMER_10) == nullptr);
+
+        TIM10->DIER = TIM_DIER_UIE;
+        TIM10->EGR = TIM_EGR_UG;
+        uint32_t interrupts = HostMcu::interrupts;
+        HostMcu::step();
+        CHECK(HostMcu::interrupts - interrupts == 1 && calls1 == 0);
+        CHECK(TIM10->SR & TIM_SR_UIF);
+
+        TIM1->EGR = TIM_EGR_UG;
+        HostMcu::step();
+        CHECK(calls1 == 1 && (TIM10->SR & TIM_SR_UIF));
+
+        // Nobody clears it: the vector keeps firing until it's masked.
+        TIM10->DIER = 0;
+        interrupts = HostMcu::interrupts;
+        HostMcu::step();
+        CHECK(HostMcu::interrupts == interrupts);
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "shared_update", testSharedUpdate },
+        { "same_step",     testSameStep },
+        { "tim1_sources",  testTim1Sources },
+        { "tim1_capture",  testTim1Capture },
+        { "tim5",          testTim5 },
+        { "no_driver",     testNoDriver },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}
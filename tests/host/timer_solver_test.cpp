@@ -0,0 +1,210 @@
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "timer_solver.hpp"
+
+// ============================================================================
+// TimerSolver, at compile time on the STM32F401 clock trees, then at run time against an
+// exhaustive search of the prescaler range. Timer::getClockFrequency() is checked for
+// every timer and APB prescaler, and setAlarmPeriod() on the timer model: the update
+// events must come (PSC + 1) * (ARR + 1) steps apart, one step per timer clock tick.
+// ============================================================================
+
+namespace
+{
+    // F401 at full speed: SYSCLK = HCLK = 84 MHz from the PLL, APB1 / 2 (42 MHz, its
+    // maximum), APB2 / 1. Both timer clocks end up at 84 MHz.
+    constexpr uint32_t HCLK = 84000000;
+    constexpr uint32_t APB1_TIMERS = TimerSolver::timerClock(HCLK, 2);
+    constexpr uint32_t APB2_TIMERS = TimerSolver::timerClock(HCLK, 1);
+    static_assert(APB1_TIMERS == 84000000 && APB2_TIMERS == 84000000);
+
+    // Out of reset: HSI 16 MHz, no prescalers. And APB1 / 4 with APB2 / 2.
+    static_assert(TimerSolver::timerClock(16000000, 1) == 16000000);
+    static_assert(TimerSolver::timerClock(HCLK, 4) == 42000000 && TimerSolver::timerClock(HCLK, 16) == 10500000);
+
+    static_assert(TimerSolver::isOnApb2(TIMER_1) && TimerSolver::isOnApb2(TIMER_9) &&
+                  TimerSolver::isOnApb2(TIMER_10) && TimerSolver::isOnApb2(TIMER_11));
+    static_assert(!TimerSolver::isOnApb2(TIMER_2) && !TimerSolver::isOnApb2(TIMER_3) &&
+                  !TimerSolver::isOnApb2(TIMER_4) && !TimerSolver::isOnApb2(TIMER_5));
+    static_assert(TimerSolver::maxReload(TIMER_2) == UINT32_MAX && TimerSolver::maxReload(TIMER_5) == UINT32_MAX);
+    static_assert(TimerSolver::maxReload(TIMER_1) == UINT16_MAX && TimerSolver::maxReload(TIMER_11) == UINT16_MAX);
+
+    // Tick frequencies: the nearest prescaler, clamped to PSC's range.
+    static_assert(TimerSolver::solvePrescaler(APB1_TIMERS, 1000000) == 83);
+    static_assert(TimerSolver::solvePrescaler(16000000, 3000000) == 4);        // 3.2 MHz, not 4
+    static_assert(TimerSolver::solvePrescaler(APB1_TIMERS, 1000) == UINT16_MAX);
+    static_assert(TimerSolver::solvePrescaler(APB1_TIMERS, 200000000) == 0);
+
+    // The usual periods, exact at 84 MHz. The smallest prescaler wins a tie.
+    constexpr TimerSolution MS_16 = TimerSolver::solvePeriodNs(APB1_TIMERS, 1000000, UINT16_MAX);
+    static_assert(MS_16.valid && MS_16.ticks() == 84000 && MS_16.prescaler == 1 && MS_16.reload == 41999);
+    static_assert(MS_16.periodNs(APB1_TIMERS) == 1000000 && MS_16.frequencyMilliHz(APB1_TIMERS) == 1000000);
+
+    constexpr TimerSolution S_16 = TimerSolver::solvePeriodNs(APB2_TIMERS, 1000000000, UINT16_MAX);
+    static_assert(S_16.valid && S_16.ticks() == 84000000 && S_16.prescaler == 1343);
+
+    constexpr TimerSolution S_32 = TimerSolver::solvePeriodNs(APB1_TIMERS, 1000000000, UINT32_MAX);
+    static_assert(S_32.valid && S_32.prescaler == 0 && S_32.reload == 83999999);
+
+    constexpr TimerSolution HZ_50 = TimerSolver::solveFrequency(16000000, 50, UINT16_MAX);
+    static_assert(HZ_50.valid && HZ_50.ticks() == 320000 && HZ_50.frequencyMilliHz(16000000) == 50000);
+
+    // Prime tick counts past the 16 bit range can't be exact: the nearest product. 65536
+    // and 65538 are as close, the smallest prescaler gives the former.
+    constexpr TimerSolution PRIME = TimerSolver::solveTicks(65537, UINT16_MAX);
+    static_assert(PRIME.valid && PRIME.prescaler == 0 && PRIME.ticks() == 65536);
+    constexpr TimerSolution PRIME_32 = TimerSolver::solveTicks(65537, UINT32_MAX);
+    static_assert(PRIME_32.valid && PRIME_32.prescaler == 0 && PRIME_32.ticks() == 65537);
+
+    // The range ends: 1 tick, 2^32 ticks on a 16 bit timer, about 51 minutes on TIM2/TIM5.
+    static_assert(TimerSolver::solveTicks(1, UINT16_MAX).valid && TimerSolver::solveTicks(1, UINT16_MAX).ticks() == 1);
+    static_assert(TimerSolver::solveTicks(1ULL << 32, UINT16_MAX).ticks() == 1ULL << 32);
+    static_assert(!TimerSolver::solveTicks((1ULL << 32) + 1, UINT16_MAX).valid);
+    static_assert(!TimerSolver::solveTicks(0, UINT16_MAX).valid);
+    static_assert(!TimerSolver::solveFrequency(APB1_TIMERS, 0, UINT16_MAX).valid);
+    static_assert(TimerSolver::solvePeriodNs(APB1_TIMERS, 3000ULL * 1000000000, UINT32_MAX).valid);
+    static_assert(!TimerSolver::solvePeriodNs(APB1_TIMERS, 4000ULL * 1000000000, UINT16_MAX).valid);
+
+    // The best prescaler, searched one by one: the smallest of the equally close ones.
+    TimerSolution bruteForce(uint64_t ticks, uint32_t maxReload)
+    {
+        TimerSolution best;
+        uint64_t bestError = UINT64_MAX;
+        for(uint64_t divisor = 1; divisor <= TimerSolver::MAX_PRESCALER + 1ULL; divisor++)
+        {
+            uint64_t reload = (ticks + divisor / 2) / divisor;
+            if(reload < 1)
+                reload = 1;
+            if(reload > maxReload + 1ULL)
+                reload = maxReload + 1ULL;
+
+            uint64_t product = reload * divisor;
+            uint64_t error = product > ticks ? product - ticks : ticks - product;
+            if(error < bestError)
+            {
+                bestError = error;
+                best = { static_cast<uint32_t>(divisor - 1), static_cast<uint32_t>(reload - 1), true };
+            }
+        }
+        return best;
+    }
+
+    bool testExhaustive()
+    {
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for(int i = 0; i < 400; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            // Spread over every magnitude up to the 16 bit limit.
+            uint64_t ticks = (state >> 32) >> (i % 32);
+            if(!ticks)
+                ticks = 1;
+
+            TimerSolution solution = TimerSolver::solveTicks(ticks, UINT16_MAX);
+            TimerSolution expected = bruteForce(ticks, UINT16_MAX);
+            CHECK(solution.valid && solution.reload <= UINT16_MAX);
+            CHECK(solution.prescaler == expected.prescaler && solution.ticks() == expected.ticks());
+        }
+        return true;
+    }
+
+    bool testClockTree()
+    {
+        HostMcu::reset();
+        ScopedTimer timers[TIMER_MAX];
+        for(int selection = TIMER_1; selection < TIMER_MAX; selection++)
+            (void)Timer::Builder().timerSelection(static_cast<TimerSelection>(selection)).buildIn(timers[selection]);
+
+        // Every HCLK the F401 is commonly run at, and every PPRE1/PPRE2 value.
+        for(uint32_t hclk : { 16000000U, 42000000U, 84000000U })
+        {
+            SystemCoreClock = hclk;
+            for(uint32_t ppre = 0; ppre < 8; ppre++)
+            {
+                uint32_t divider = ppre & 0x4 ? 2U << (ppre & 0x3) : 1;
+                RCC->CFGR = ppre << RCC_CFGR_PPRE1_Pos | (7 - ppre) << RCC_CFGR_PPRE2_Pos;
+                uint32_t apb2Ppre = 7 - ppre;
+                uint32_t apb2Divider = apb2Ppre & 0x4 ? 2U << (apb2Ppre & 0x3) : 1;
+
+                for(int selection = TIMER_1; selection < TIMER_MAX; selection++)
+                {
+                    bool apb2 = TimerSolver::isOnApb2(static_cast<TimerSelection>(selection));
+                    uint32_t expected = TimerSolver::timerClock(hclk, apb2 ? apb2Divider : divider);
+                    CHECK(timers[selection].getClockFrequency() == expected);
+                }
+            }
+        }
+
+        SystemCoreClock = HCLK;
+        RCC->CFGR = 0;
+        return true;
+    }
+
+    bool testAlarmPeriod()
+    {
+        // The F401 at 84 MHz: APB1 / 2, timers still at 84 MHz, one tick per step.
+        HostMcu::reset();
+        RCC->CFGR = 0x4 << RCC_CFGR_PPRE1_Pos;
+
+        struct Case
+        {
+            TimerSelection selection;
+            TIM_TypeDef* registers;
+            uint64_t periodNs;
+        };
+        const Case cases[] =
+        {
+            { TIMER_3, TIM3, 10000 },           // 840 ticks, PSC 0
+            { TIMER_4, TIM4, 1000000 },         // 84000 ticks, past 16 bits
+            { TIMER_5, TIM5, 1000000 },         // 32 bits: PSC 0
+            { TIMER_9, TIM9, 333333 },          // Not a whole number of ticks
+            { TIMER_1, TIM1, 2500000 },
+        };
+
+        for(const Case& test : cases)
+        {
+            ScopedTimer timer;
+            (void)Timer::Builder().timerSelection(test.selection).buildIn(timer);
+            CHECK(timer.getClockFrequency() == 84000000);
+
+            TimerSolution solution = DRIVER_VALUE(timer.setAlarmPeriod(test.periodNs));
+            CHECK(solution.valid && solution.prescaler == test.registers->PSC);
+            CHECK(solution.reload == test.registers->ARR);
+            uint64_t ns = solution.periodNs(84000000);
+            CHECK(ns + 6 >= test.periodNs && ns <= test.periodNs + 6);
+
+            // Update events (PSC + 1) * (ARR + 1) steps apart.
+            HostTim& model = HostTim::of(test.registers);
+            timer.start();
+            uint32_t events = model.updateEvents;
+            CHECK(HostMcu::runUntil([&] { return model.updateEvents == events + 1; }, 300000));
+            uint32_t first = HostMcu::steps;
+            CHECK(HostMcu::runUntil([&] { return model.updateEvents == events + 3; }, 600000));
+            CHECK(HostMcu::steps - first == 2 * solution.ticks());
+            timer.pause();
+        }
+
+        ScopedTimer timer;
+        (void)Timer::Builder().timerSelection(TIMER_3).buildIn(timer);
+        CHECK(hostFails([&] { return timer.setAlarmPeriod(60ULL * 1000000000); }, DriverError::OutOfRange));
+        RCC->CFGR = 0;
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "exhaustive",   testExhaustive },
+        { "clock_tree",   testClockTree },
+        { "alarm_period", testAlarmPeriod },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}
@@ -0,0 +1,217 @@
+#include "host_mcu.hpp"
+#include "host_test.hpp"
+#include "host_timer.hpp"
+
+#include "timer_wheel.hpp"
+
+// ============================================================================
+// TimerWheel on the TIM3 model, one tick per step (PSC = 0): every expiry must come the
+// same number of steps after it's due, whatever the delay, the cascades in between and
+// the other timers started or cancelled meanwhile. An alarm interrupt takes one step
+// from the update event to its handler.
+// ============================================================================
+
+namespace
+{
+    struct WheelFixture
+    {
+        ScopedTimer timer;
+        TimerWheel wheel;
+
+        WheelFixture()
+        {
+            HostMcu::reset();
+            (void)Timer::Builder().timerSelection(TIMER_3).buildIn(timer);
+            wheel.init(timer);
+        }
+    };
+
+    struct Expiry
+    {
+        uint32_t steps = 0;
+        uint32_t count = 0;
+    };
+
+    void recordExpiry(void* argument)
+    {
+        Expiry* expiry = static_cast<Expiry*>(argument);
+        expiry->steps = HostMcu::steps;
+        expiry->count++;
+    }
+
+    // Steps from start() to the callback, for a delay of 0 ticks.
+    constexpr uint32_t LATENCY = 1;
+
+    bool testExpiry()
+    {
+        WheelFixture fixture;
+
+        // Level boundaries, cascades, and delays past the 16 bit counter range.
+        const uint32_t delays[] = { 1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 65535, 65536, 70000, 262143, 300000 };
+        constexpr size_t COUNT = sizeof(delays) / sizeof(delays[0]);
+        SoftTimer softTimers[COUNT];
+        Expiry expiries[COUNT];
+
+        uint32_t start = HostMcu::steps;
+        for(size_t i = 0; i < COUNT; i++)
+            fixture.wheel.start(softTimers[i], delays[i], recordExpiry, &expiries[i]);
+
+        CHECK(HostMcu::runUntil([&] { return expiries[COUNT - 1].count == 1; }, 400000));
+        for(size_t i = 0; i < COUNT; i++)
+        {
+            CHECK(expiries[i].count == 1 && !softTimers[i].isActive());
+            CHECK(expiries[i].steps - start == delays[i] + LATENCY);
+        }
+        return true;
+    }
+
+    bool testPeriodic()
+    {
+        WheelFixture fixture;
+        SoftTimer periodic;
+        SoftTimer slow;
+        Expiry expiry;
+        Expiry slowExpiry;
+
+        // Periods run from the scheduled expiry: no drift, interrupt latency included.
+        uint32_t start = HostMcu::steps;
+        fixture.wheel.startPeriodic(periodic, 10, recordExpiry, &expiry);
+        fixture.wheel.startPeriodic(slow, 777, recordExpiry, &slowExpiry);
+
+        CHECK(HostMcu::runUntil([&] { return expiry.count == 1000; }));
+        CHECK(expiry.steps - start == 1000 * 10 + LATENCY);
+        CHECK(slowExpiry.count == 12 && slowExpiry.steps - start == 12 * 777 + LATENCY);
+
+        fixture.wheel.cancel(periodic);
+        fixture.wheel.cancel(slow);
+        CHECK(!periodic.isActive() && !slow.isActive());
+        HostMcu::runUntil([] { return false; }, 2000);
+        CHECK(expiry.count == 1000 && slowExpiry.count == 12);
+        return true;
+    }
+
+    struct Canceller
+    {
+        TimerWheel* wheel;
+        SoftTimer* victim;
+        uint32_t count = 0;
+    };
+
+    bool testCancel()
+    {
+        WheelFixture fixture;
+        SoftTimer first;
+        SoftTimer second;
+        SoftTimer third;
+        Expiry firstExpiry;
+        Expiry thirdExpiry;
+
+        // Same slot: the first one's callback cancels the second one.
+        Canceller canceller{ &fixture.wheel, &second };
+        fixture.wheel.start(first, 100, [](void* argument)
+        {
+            Canceller* canceller = static_cast<Canceller*>(argument);
+            canceller->wheel->cancel(*canceller->victim);
+            canceller->count++;
+        }, &canceller);
+        fixture.wheel.start(second, 100, recordExpiry, &firstExpiry);
+        fixture.wheel.start(third, 5000, recordExpiry, &thirdExpiry);
+
+        // Cancelled before its time, and restarted later.
+        CHECK(HostMcu::runUntil([&] { return canceller.count == 1; }));
+        fixture.wheel.cancel(third);
+        HostMcu::runUntil([] { return false; }, 6000);
+        CHECK(firstExpiry.count == 0 && thirdExpiry.count == 0);
+
+        uint32_t start = HostMcu::steps;
+        fixture.wheel.start(third, 300, recordExpiry, &thirdExpiry);
+        CHECK(HostMcu::runUntil([&] { return thirdExpiry.count == 1; }));
+        CHECK(thirdExpiry.steps - start == 300 + LATENCY);
+        return true;
+    }
+
+    bool testRestartKeepsTime()
+    {
+        WheelFixture fixture;
+        SoftTimer target;
+        SoftTimer churn;
+        Expiry expiry;
+        Expiry churnExpiry;
+
+        // Every start() reprograms the running counter: none may cost the target a tick.
+        uint32_t start = HostMcu::steps;
+        fixture.wheel.start(target, 100000, recordExpiry, &expiry);
+        while(expiry.count == 0)
+        {
+            fixture.wheel.start(churn, 50, recordExpiry, &churnExpiry);
+            HostMcu::runUntil([] { return false; }, 37);
+        }
+        CHECK(churnExpiry.count == 0);
+        CHECK(expiry.steps - start == 100000 + LATENCY);
+        return true;
+    }
+
+    bool testGetTicks()
+    {
+        WheelFixture fixture;
+        SoftTimer softTimers[3];
+        Expiry expiries[3];
+        fixture.wheel.startPeriodic(softTimers[0], 7, recordExpiry, &expiries[0]);
+        fixture.wheel.startPeriodic(softTimers[1], 4099, recordExpiry, &expiries[1]);
+        fixture.wheel.start(softTimers[2], 200000, recordExpiry, &expiries[2]);
+
+        // One tick per step, through alarms, cascades and counter reloads.
+        uint32_t startSteps = HostMcu::steps;
+        uint32_t startTicks = fixture.wheel.getTicks();
+        bool inStep = true;
+        for(uint32_t i = 0; i < 250000; i++)
+        {
+            HostMcu::step();
+            inStep &= fixture.wheel.getTicks() - startTicks == HostMcu::steps - startSteps;
+        }
+        CHECK(inStep);
+        CHECK(expiries[2].count == 1);
+
+        // Masked past the alarm (by less than its period): the update flag is pending, and
+        // the ticks still count.
+        fixture.wheel.cancel(softTimers[0]);
+        fixture.wheel.cancel(softTimers[1]);
+        __disable_irq();
+        SoftTimer masked;
+        Expiry maskedExpiry;
+        fixture.wheel.start(masked, 20, recordExpiry, &maskedExpiry);
+        startSteps = HostMcu::steps;
+        startTicks = fixture.wheel.getTicks();
+        HostMcu::runUntil([] { return false; }, 30);
+        CHECK(fixture.timer.isAlarmPending() && maskedExpiry.count == 0);
+        CHECK(fixture.wheel.getTicks() - startTicks == HostMcu::steps - startSteps);
+
+        // A start() with the flag pending catches up to the alarm first.
+        SoftTimer late;
+        Expiry lateExpiry;
+        fixture.wheel.start(late, 5, recordExpiry, &lateExpiry);
+        CHECK(maskedExpiry.count == 1 && !fixture.timer.isAlarmPending());
+        CHECK(fixture.wheel.getTicks() - startTicks == HostMcu::steps - startSteps);
+        __enable_irq();
+
+        uint32_t lateStart = HostMcu::steps;
+        CHECK(HostMcu::runUntil([&] { return lateExpiry.count == 1; }));
+        CHECK(lateExpiry.steps - lateStart == 5 + LATENCY);
+        CHECK(fixture.wheel.getTicks() - startTicks == HostMcu::steps - startSteps);
+        return true;
+    }
+
+    const HostTest tests[] =
+    {
+        { "expiry",             testExpiry },
+        { "periodic",           testPeriodic },
+        { "cancel",             testCancel },
+        { "restart_keeps_time", testRestartKeepsTime },
+        { "get_ticks",          testGetTicks },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    return runHostTests(tests, argc, argv);
+}